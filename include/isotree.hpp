@@ -130,8 +130,9 @@ typedef struct IsoTree {
     ColType  col_type = NotUsed;
     size_t   col_num;
     double   num_split;
-    std::vector<char> cat_split;
+    std::vector<uint64_t> cat_split; /* packed bitset, see 'src/isotree.hpp' */
     int      chosen_cat;
+    int      ncat_split = 0;
     size_t   tree_left;
     size_t   tree_right;
     double   pct_tree_left;
@@ -225,6 +226,28 @@ typedef struct TreesIndexer {
     TreesIndexer() = default;
 } TreesIndexer;
 
+typedef struct RandomCutTree {
+    std::vector<size_t> parent;
+    std::vector<size_t> n_points;
+    std::vector<double> box_low;  /* [node*ncols + col] */
+    std::vector<double> box_high; /* [node*ncols + col] */
+    std::vector<size_t> point_leaf;
+    std::vector<size_t> free_nodes;
+    RandomCutTree() = default;
+} RandomCutTree;
+
+typedef struct RandomCutForest {
+    IsoForest model;
+    std::vector<RandomCutTree> cut_trees;
+    std::vector<char> point_is_active;
+    std::vector<size_t> free_point_ids;
+    size_t ncols;
+    size_t n_points;
+    uint64_t random_seed;
+    uint64_t n_inserted;
+    RandomCutForest() = default;
+} RandomCutForest;
+
 #endif /* ISOTREE_H */
 
 /*  Fit Isolation Forest model, or variant of it such as SCiForest
@@ -670,9 +693,9 @@ typedef struct TreesIndexer {
 *       a given column (minus 2). For averaged gain, the best split is always to put the second most-frequent
 *       category in a separate branch, so not evaluating all  permutations (passing 'false') will make it
 *       possible to select other splits that respect the sorted frequency order.
-*       The total number of combinations must be a number that can fit into a 'size_t' variable - for x64-64
-*       systems, this means no column can have more than 20 different categories if using 'all_perm=true',
-*       but note that this is not checked within the function.
+*       Permutations are only evaluated in tree nodes in which at most 'MAX_CATEG_ALL_PERM' categories are present
+*       (16 by default, can be changed at compile time) - nodes with more categories will use the sorted grouping,
+*       and a warning will be printed when fitting to data in which some column has more categories than that.
 *       Ignored when not using categorical variables or not doing splits by pooled gain or using 'ndim>1'.
 * - coef_by_prop
 *       In the extended model, whether to sort the randomly-generated coefficients for categories
@@ -717,7 +740,9 @@ typedef struct TreesIndexer {
 *       be sensitive to a difference of 10^-100), but will make the calculations slower, the more so in
 *       platforms in which 'long double' is a software-emulated type (e.g. Power8 platforms).
 *       Note that some platforms (most notably windows with the msvc compiler) do not make any difference
-*       between 'double' and 'long double'.
+*       between 'double' and 'long double'. If the library is compiled with 'USE_DOUBLE_DOUBLE', will use
+*       instead a double-double type (sum of two doubles), which provides extended precision also in such
+*       platforms, and is faster than software-emulated 'long double', but slower than x87 'long double'.
 * - nthreads
 *       Number of parallel threads to use. Note that, the more threads, the more memory will be
 *       allocated, even if the thread does not end up being used.
@@ -727,6 +752,16 @@ typedef struct TreesIndexer {
 *       in only a very modest speed up (e.g. 1.5x faster with 4x more threads),
 *       even if all threads look fully utilized.
 *       Ignored when not building with OpenMP support.
+* - max_memory
+*       Limit on the memory (in bytes) that the procedure is allowed to take, as estimated
+*       by function 'estimate_fit_memory' (this includes the model objects being produced,
+*       but not the input data nor the arrays passed as outputs). If the estimate exceeds
+*       the limit, will first avoid making copies of the rows sampled for each tree, and then
+*       reduce the number of threads to use. If it cannot stay under the limit even with a
+*       single thread, will throw an exception before allocating anything.
+*       Note that the estimate is only approximate, so this should leave some margin.
+*       Pass zero for no limit. The overload of this function which does not take this
+*       parameter behaves the same as passing zero.
 * 
 * Returns
 * =======
@@ -738,6 +773,32 @@ typedef struct TreesIndexer {
 * as integers.
 */
 ISOTREE_EXPORTED
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, int nthreads, size_t max_memory);
+
+/* Same as above, without a limit on memory usage (kept for compatibility with code
+   written before the 'max_memory' parameter was added) */
+ISOTREE_EXPORTED
 int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
                 int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -999,6 +1060,213 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              uint64_t random_seed, bool use_long_double);
 
 
+/* Add several trees to an already-fitted isolation forest model, fitting them in parallel
+* 
+* This produces the same trees as calling 'add_tree' 'ntrees' times in a row with the same
+* 'random_seed', but fits them with multiple threads, each one with its own working memory.
+* The imputer and indexer (including distances and reference points) are updated for the
+* new trees in the same parallel pass.
+* 
+* The new trees are only appended to the model (along with their imputation nodes and indexer
+* entries) once all of them have been fitted, so if an error or interrupt happens in the
+* middle, the model, imputer and indexer will be left as they were.
+* 
+* Parameters
+* ==========
+* - model_outputs, model_outputs_ext
+*       Same parameters as for 'add_tree' (see the documentation in there for details).
+* - ntrees
+*       Number of trees to add. Must be positive.
+* - All other parameters except for 'nthreads'
+*       Same as for 'add_tree' (see the documentation in there for details).
+* - nthreads
+*       Number of parallel threads to use. If passing a number larger than 'ntrees',
+*       will use 'ntrees' threads instead.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1), in which case the model will be left as it was.
+*/
+ISOTREE_EXPORTED
+int add_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
+              real_t numeric_data[],  size_t ncols_numeric,
+              int    categ_data[],    size_t ncols_categ,    int ncat[],
+              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+              size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+              real_t sample_weights[], size_t nrows,
+              size_t max_depth,     size_t ncols_per_tree,
+              bool   limit_depth,   bool penalize_range, bool standardize_data,
+              bool   fast_bratio,
+              real_t col_weights[], bool weigh_by_kurt,
+              double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+              double prob_pick_by_full_gain, double prob_pick_by_dens,
+              double prob_pick_col_by_range, double prob_pick_col_by_var,
+              double prob_pick_col_by_kurt,
+              double min_gain, MissingAction missing_action,
+              CategSplit cat_split_type, NewCategAction new_cat_action,
+              UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+              bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+              TreesIndexer *indexer,
+              real_t ref_numeric_data[], int ref_categ_data[],
+              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+              uint64_t random_seed, bool use_long_double, int nthreads);
+
+
+/* Replace a tree in an isolation forest model with a new tree fit to the data passed here
+* 
+* This will fit a new tree in the same way as 'add_tree', and then put it in place of the
+* tree at position 'tree_num', discarding the old one along with its associated imputation
+* nodes and indexer entry (if any). The other trees are left in their same positions.
+* 
+* Can be used in a rotating fashion (e.g. replacing the oldest tree each time) in order to
+* have a model that tracks a sliding window of data while keeping a fixed number of trees,
+* at a cost that doesn't depend on the number of trees in the model.
+* 
+* Note that, same as for 'add_tree', the expected isolation depth stored in the model
+* ('exp_avg_depth' and 'exp_avg_sep') will not be modified. If the new tree is fit to a
+* number of rows different from the sample size of the tree that it replaces, these might
+* need to be updated manually (see the object-oriented interface for an example).
+* 
+* Parameters
+* ==========
+* - model_outputs, model_outputs_ext
+*       Same parameters as for 'add_tree' (see the documentation in there for details).
+* - tree_num
+*       Position (zero-based) of the tree to replace. Must be smaller than the number of trees
+*       in the model.
+* - All other parameters
+*       Same as for 'add_tree' (see the documentation in there for details). Note that the
+*       new tree will use the random seed that 'add_tree' would use for the next tree to add,
+*       so 'random_seed' should be varied across calls in order to get different trees.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1), in which case the model will be left as it was.
+*/
+ISOTREE_EXPORTED
+int replace_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t tree_num,
+                 real_t numeric_data[],  size_t ncols_numeric,
+                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                 real_t sample_weights[], size_t nrows,
+                 size_t max_depth,     size_t ncols_per_tree,
+                 bool   limit_depth,   bool penalize_range, bool standardize_data,
+                 bool   fast_bratio,
+                 real_t col_weights[], bool weigh_by_kurt,
+                 double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                 double prob_pick_by_full_gain, double prob_pick_by_dens,
+                 double prob_pick_col_by_range, double prob_pick_col_by_var,
+                 double prob_pick_col_by_kurt,
+                 double min_gain, MissingAction missing_action,
+                 CategSplit cat_split_type, NewCategAction new_cat_action,
+                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                 TreesIndexer *indexer,
+                 real_t ref_numeric_data[], int ref_categ_data[],
+                 bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+                 real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+                 uint64_t random_seed, bool use_long_double);
+
+
+/* Fit isolation forest model to rows that are read one at a time from a stream
+* 
+* This reads all the rows in a single pass while keeping a separate random sub-sample
+* (reservoir) of 'sample_size' rows for each tree, and then fits all the trees to their
+* reservoirs, thus requiring memory proportional to 'ntrees * sample_size * ncols' instead
+* of the number of rows in the stream. Each tree gets the same sampling distribution that
+* it would get from 'fit_iforest' when sub-sampling without replacement, but the trees
+* are fit to different random samples than 'fit_iforest' would use with the same seed.
+* 
+* Parameters
+* ==========
+* - model_outputs (out)
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - model_outputs_ext (out)
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - next_row
+*       Function that will be called to obtain each row, in the order in which they are to
+*       be sampled. It will receive the pointer 'row_source' as-is, along with arrays of
+*       dimension 'ncols_numeric' and 'ncols_categ' where to write the values for the row
+*       (these can be ignored if the respective number of columns is zero), and a pointer
+*       where to write the row weight (which will be set to 1 before each call and can be
+*       ignored if not using weights). Numeric and categorical values follow the same
+*       conventions as 'numeric_data' and 'categ_data' in 'fit_iforest' (e.g. NAN for
+*       missing numeric values and negative numbers for missing categories).
+*       Should return 'true' when it wrote a new row and 'false' once there are no more rows,
+*       in which case the outputs from that call will be ignored.
+* - row_source
+*       Pointer to arbitrary data that will be passed to 'next_row' in each call.
+* - ncols_numeric
+*       Number of numeric columns in each row.
+* - ncols_categ
+*       Number of categorical columns in each row.
+* - ncat[ncols_categ]
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - ndim, ntry, coef_type, coef_by_prop
+*       Same parameters as for 'fit_iforest' (see the documentation in there for details).
+* - use_weights
+*       Whether to use the row weights produced by 'next_row'. Rows with non-positive weights
+*       will be ignored when the weights are taken as sampling probabilities.
+* - weight_as_sample
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+*       If passing 'true', the reservoirs will be sampled with probabilities proportional to
+*       the row weights, without replacement.
+* - sample_size
+*       Number of rows to keep in the reservoir of each tree. Unlike in 'fit_iforest', this
+*       must be passed as a positive number, since the number of rows is not known in advance.
+*       If the stream ends up having fewer rows than this, all trees will use all the rows.
+* - ntrees
+*       Number of trees (and reservoirs) to build.
+* - max_depth, ncols_per_tree, limit_depth, penalize_range, standardize_data,
+*   scoring_metric, fast_bratio, col_weights, weigh_by_kurt, prob_pick_by_gain_pl,
+*   prob_pick_by_gain_avg, prob_pick_by_full_gain, prob_pick_by_dens, prob_pick_col_by_range,
+*   prob_pick_col_by_var, prob_pick_col_by_kurt, min_gain, missing_action, cat_split_type,
+*   new_cat_action, all_perm, imputer, min_imp_obs, depth_imp, weigh_imp_rows
+*       Same parameters as for 'fit_iforest' (see the documentation in there for details).
+* - random_seed
+*       Seed that will be used for generating random numbers, both for the reservoirs and for
+*       the trees.
+* - use_long_double
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - nthreads
+*       Number of parallel threads to use for fitting the trees once the stream is exhausted.
+*       Reading the stream is always done in a single thread.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1).
+*/
+ISOTREE_EXPORTED
+int fit_iforest_from_rows(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          bool (*next_row)(void *row_source, real_t numeric_row[], int categ_row[], real_t *row_weight),
+                          void *row_source,
+                          size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          bool use_weights, bool weight_as_sample,
+                          size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          real_t col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, bool use_long_double, int nthreads);
+
+
 /* Predict outlier score, average depth, or terminal node numbers
 * 
 * Parameters
@@ -1145,6 +1413,67 @@ ISOTREE_EXPORTED void get_num_nodes(const ExtIsoForest &model_outputs, sparse_ix
 
 
 
+/* Estimate the memory that a model will take and that fitting it will require
+* 
+* These are estimates (in bytes) of the memory used by the objects produced by 'fit_iforest'
+* and of the peak memory used by 'fit_iforest' itself, which can be used to decide on the
+* number of threads or on the parameters before fitting a model to a large dataset. They
+* take the sizes to which the buffers get allocated, assuming that the trees grow up to the
+* number of nodes for which space is reserved while fitting (in practice, trees with non-random
+* splits might end up with fewer nodes). They do not include the input data nor the arrays
+* that are passed as outputs ('tmat', 'output_depths'), but 'estimate_fit_memory' does include
+* the model objects and the imputer. When imputing at fit time, it is assumed that any row
+* might have missing values, but the sums kept for each missing value are not counted.
+* 
+* Parameters
+* ==========
+* - ndim
+*       Same parameter as for 'fit_iforest'. Passing 'ndim=1' means the single-variable model.
+* - max_categ
+*       Maximum number of categories among the categorical columns (the maximum of 'ncat').
+* - nnz
+*       Number of non-zero entries in the numeric data, if it is passed in sparse CSC format.
+*       Pass zero if the numeric data is dense.
+* - has_sample_weights
+*       Whether 'sample_weights' will be passed to 'fit_iforest'.
+* - calc_dist
+*       Whether 'tmat' will be passed to 'fit_iforest'.
+* - calc_depth
+*       Whether 'output_depths' will be passed to 'fit_iforest'.
+* - build_imputer
+*       Whether an 'Imputer' object will be passed to 'fit_iforest' to be built along with the model.
+* - build_indexer, with_distances
+*       Whether the model will have an indexer built through 'build_tree_indices', and whether
+*       it will contain node distances.
+* - nthreads
+*       Number of threads that will be passed to 'fit_iforest' (the procedure uses at most
+*       one thread per tree).
+* 
+* The rest of the parameters are the same as for 'fit_iforest'.
+*/
+ISOTREE_EXPORTED
+size_t estimate_model_size(size_t ndim, size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth, CategSplit cat_split_type,
+                           bool build_imputer, bool build_indexer, bool with_distances);
+ISOTREE_EXPORTED
+size_t estimate_fit_memory(size_t ndim, size_t ntry,
+                           size_t ncols_numeric, size_t ncols_categ, int max_categ, size_t nnz,
+                           bool has_sample_weights, bool with_replacement, bool weight_as_sample,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth,
+                           ScoringMetric scoring_metric, bool calc_dist, bool calc_depth,
+                           bool weigh_by_kurt,
+                           double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                           double prob_pick_by_full_gain, double prob_pick_by_dens,
+                           double prob_pick_col_by_range, double prob_pick_col_by_var,
+                           double prob_pick_col_by_kurt,
+                           MissingAction missing_action, CategSplit cat_split_type,
+                           bool build_imputer, bool impute_at_fit,
+                           bool use_long_double, int nthreads);
+
+
+
 /* Calculate distance or similarity or kernel/proximity between data points
 * 
 * Parameters
@@ -2022,6 +2351,139 @@ ISOTREE_EXPORTED
 void incremental_serialize_Indexer(const TreesIndexer &model, std::string &old_bytes);
 
 
+/* Serialize only some of the trees in a model, to be applied over a previously de-serialized copy
+*
+* This is meant for models in which trees get replaced (e.g. through function 'replace_tree'),
+* for which 'incremental_serialize_*' cannot be used since it only handles trees appended at
+* the end. The serialized delta contains only the selected trees and their positions, plus the
+* model-level fields that might change along with them ('exp_avg_depth', 'exp_avg_sep',
+* 'orig_sample_size', 'has_range_penalty'), and can then be applied over a copy of the model
+* which has the same trees in all the other positions in order to bring it up to date.
+* 
+* If the model has an associated imputer and/or indexer, their deltas need to be produced and
+* applied separately, passing the same tree numbers.
+*
+* Parameters
+* ==========
+* - model (in) / model (out)
+*       A model object from which to serialize the selected trees, or to which to apply a
+*       serialized delta. When applying a delta, the trees at positions that were not included
+*       in the delta will be left as they were. The serialized model cannot have had fewer trees
+*       than the model to which the delta is applied, and if it had more, the delta must include
+*       all of the trees at the positions that the model doesn't have (otherwise will throw).
+* - tree_nums[n_trees]
+*       Positions (zero-based) of the trees to serialize, such as the ones that were replaced
+*       since the last time that the model was serialized.
+* - n_trees
+*       Number of entries in 'tree_nums'.
+* - out (out)
+*       Pointer to an already-allocated array with the required size, which must be
+*       obtained from function 'determine_serialized_size_trees_delta'.
+* - in
+*       Serialized delta produced by the 'serialize_trees_delta_*' function for the same
+*       type of object. Must have been produced in a setup with the same characteristics
+*       (e.g. width of 'int' and 'size_t', endianness, etc.).
+* 
+* Returns
+* =======
+* - For functions 'determine_serialized_size_trees_delta', size that the serialized delta
+*   will have.
+* - For functions 'serialize_trees_delta_*' that take no 'out', the serialized delta.
+*/
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const std::string &in);
+
+
+/*  Streaming forest of random cut trees, in which points can be inserted and deleted one at a time
+* 
+* This follows the procedures from the 'Robust Random Cut Forest' paper [12], in which each tree contains
+* all of the points that are currently in the forest, and the cuts are re-arranged when points are added
+* or removed so that the tree has the same distribution as if it had been built from scratch with the
+* current points. Only numeric data without missing values is supported.
+* 
+* Inserting or deleting a point visits only the nodes in the path from the root to the point, at a cost
+* of O(depth * ncols), plus updating the depths of the terminal nodes in the sub-tree that moves one level
+* up or down.
+* 
+* The trees are kept in the same format as those from 'fit_iforest' in member 'model' of 'RandomCutForest',
+* which (once there are at least 2 points in the forest) can be passed to 'predict_iforest' in order to
+* obtain standardized isolation depths for new points, using the columns in the same order as the inserted
+* points. Alternatively, the co-displacement of a point that is in the forest can be obtained through
+* 'codisp_random_cut'.
+* 
+* Note that these objects do not have serialization functions.
+* 
+* Parameters
+* ==========
+* - forest (in, out)
+*       Random cut forest object. Must be initialized through 'initialize_random_cut_forest'
+*       before inserting points into it.
+* - ncols
+*       Number of columns in the points that will be inserted into the forest.
+* - ntrees
+*       Number of random cut trees in the forest.
+* - random_seed
+*       Seed that will be used for random number generation when choosing cuts.
+* - point[ncols]
+*       Point to insert into the forest. Cannot have missing or infinite values.
+* - point_id
+*       Identifier of a point in the forest, as returned by 'insert_point_random_cut'. Identifiers
+*       from deleted points will be re-used for newly inserted points.
+* 
+* Returns
+* =======
+* - insert_point_random_cut: identifier of the newly-inserted point.
+* - codisp_random_cut: average co-displacement of the point across trees, where higher values mean
+*   more outlierness.
+*/
+ISOTREE_EXPORTED
+void initialize_random_cut_forest(RandomCutForest &forest, size_t ncols, size_t ntrees, uint64_t random_seed);
+ISOTREE_EXPORTED
+size_t insert_point_random_cut(RandomCutForest &forest, const double point[]);
+ISOTREE_EXPORTED
+void delete_point_random_cut(RandomCutForest &forest, size_t point_id);
+ISOTREE_EXPORTED
+double codisp_random_cut(const RandomCutForest &forest, size_t point_id);
+
+
 /* Translate isolation forest model into a single SQL select statement
 * 
 * Parameters
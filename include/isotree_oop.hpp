@@ -101,6 +101,12 @@ public:
         so passing -1 means using all available threads.  */
     int nthreads = -1; /* <- May be manually changed at any time */
 
+    /*  Limit on the memory (in bytes) that 'fit' is allowed to take, according to the
+        estimate from 'estimate_fit_memory'. If needed, it will use fewer threads than
+        'nthreads' in order to stay under it, or throw an exception if not possible.
+        Pass zero for no limit. See 'fit_iforest' in 'isotree.hpp' for details.  */
+    size_t max_memory = 0; /* <- May be manually changed at any time */
+
     uint64_t random_seed = 1;
 
     /*  General tree construction parameters  */
@@ -201,6 +207,65 @@ public:
              int    categ_data[],       size_t ncols_categ,   int ncat[],
              double sample_weights[],   double col_weights[]);
 
+    /*  Fits the model in rounds of 'ntrees_per_round' trees, stopping once adding more
+        trees no longer changes the ranking of the outlier scores. Takes the same data
+        as 'fit', plus rows on which to monitor the scores, in the same format. These
+        would usually be a held-out sample. If passing NULL for both
+        'monitor_numeric_data' and 'monitor_categ_data', will monitor the rows to which
+        the model is fit instead.
+
+        After each round, the scores of the monitoring rows are compared with the
+        scores from the previous round through Spearman's rank correlation. Fitting
+        stops once the correlation reaches 'min_rank_corr' (e.g. 0.999), or once the
+        model reaches 'ntrees' trees. Only the trees of the new round are used for
+        predicting on the monitoring rows, so monitoring costs about the same as
+        predicting those rows once with the final model.
+
+        Everything other than the trees themselves (e.g. column weights from kurtosis)
+        is calculated once for the full 'ntrees', so the resulting model is the same as
+        the first trees of the model that 'fit' would produce with the same parameters
+        and random seed. The trees of each round are fit in parallel according to
+        'nthreads', so 'ntrees_per_round' should be a multiple of it.
+
+        Returns the number of trees in the fitted model.  */
+    size_t fit_early_stop(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                          int    categ_data[],     size_t ncols_categ,    int ncat[],
+                          double sample_weights[], double col_weights[],
+                          double monitor_numeric_data[], int monitor_categ_data[], size_t nrows_monitor,
+                          size_t ntrees_per_round, double min_rank_corr);
+
+    /*  For keeping the model up to date with a sliding window of data: this fits a
+        new tree to all the rows passed here and puts it in place of the oldest tree
+        in the model, going through the trees in circular order, so that after
+        'ntrees' calls all of the trees will have been fit to recent data. The data
+        follows the same format as for 'fit'.
+
+        The expected average depth used to standardize the scores is updated so as
+        to account for the number of rows to which each tree was fit.
+
+        Returns the position of the tree that was replaced, which can be used for
+        producing serialized deltas of the model (see 'serialize_trees_delta_*' in
+        the non-OOP header).
+
+        Note that the model must have already been fitted, and that this is not
+        supported for models with reference points. After de-serializing a model,
+        the first tree to replace will be tree number zero.  */
+    size_t rotate_tree(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                       int    categ_data[],     size_t ncols_categ,    int ncat[],
+                       double sample_weights[], double col_weights[]);
+
+    /*  These give estimates of the memory (in bytes) that 'fit' would take with the current
+        parameters for data of a given shape, and of the memory that the fitted model objects
+        would take afterwards (optionally, after calling 'build_indexer'). If the numeric data
+        is sparse, must pass its number of non-zero entries as 'nnz' (zero means dense data).
+        Note that these are only approximate. See 'estimate_fit_memory' and 'estimate_model_size'
+        in 'isotree.hpp' for details about what they include.  */
+    size_t estimate_fit_memory(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                               size_t nnz, bool has_sample_weights);
+
+    size_t estimate_model_size(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                               bool with_indexer, bool with_distances);
+
     /*  'predict' will return a vector with the standardized outlier scores
         (output length is the same as the number of rows in the data), in
         which higher values mean more outlierness.
@@ -404,6 +469,9 @@ public:
 
 private:
     bool is_fitted = false;
+    size_t n_rotated = 0;
+    std::vector<double> tree_exp_depths;
+    std::vector<double> tree_exp_seps;
 
     void override_previous_fit();
     void check_params();
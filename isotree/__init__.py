@@ -543,6 +543,8 @@ class IsolationForest(BaseEstimator):
         a given column (minus 2). For averaged gain, the best split is always to put the second most-frequent
         category in a separate branch, so not evaluating all  permutations (passing ``False``) will make it
         possible to select other splits that respect the sorted frequency order.
+        Permutations are only evaluated in tree nodes in which at most 16 categories are present - nodes
+        with more categories will use the sorted grouping.
         Ignored when not using categorical variables or not doing splits by pooled gain or using ``ndim > 1``.
     coef_by_prop : bool
         In the extended model, whether to sort the randomly-generated coefficients for categories
@@ -137,8 +137,9 @@ cdef extern from "headers_joined.hpp":
         ColType       col_type
         size_t        col_num
         double        num_split
-        vector[signed char]  cat_split
+        vector[uint64_t]  cat_split
         int           chosen_cat
+        int           ncat_split
         size_t        tree_left
         size_t        tree_right
         double        pct_tree_left
@@ -147,6 +148,8 @@ cdef extern from "headers_joined.hpp":
         double        range_high
         double        remainder
 
+    bool_t cat_goes_left(IsoTree &node, int cat)
+
     ctypedef struct IsoForest:
         vector[vector[IsoTree]] trees
         NewCategAction   new_cat_action
@@ -350,7 +353,7 @@ cdef extern from "headers_joined.hpp":
                     CategSplit cat_split_type, NewCategAction new_cat_action,
                     bool_t all_perm, Imputer *imputer, size_t min_imp_obs,
                     UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool_t impute_at_fit,
-                    uint64_t random_seed, bool_t use_long_double, int nthreads) except + nogil
+                    uint64_t random_seed, bool_t use_long_double, int nthreads, size_t max_memory) except + nogil
 
     void predict_iforest[real_t_, sparse_ix_](
                          real_t_ *numeric_data, int *categ_data,
@@ -582,20 +585,19 @@ def _reconstruct_csr_with_categ(
         nrows, ncols, cols_numeric.shape[0], cols_categ.shape[0]
     )
 
-def get_list_left_categories(vector[signed char] &cat_split):
-    cdef size_t ix
+cdef list get_list_left_categories(IsoTree &node):
     cdef size_t n_left = 0
-    for ix in range(cat_split.size()):
-        n_left += cat_split[ix] == <signed char>1
+    cdef int iix
+    for iix in range(node.ncat_split):
+        n_left += cat_goes_left(node, iix)
     cdef np.ndarray[int, ndim=1] categs_ = np.empty(n_left, dtype=ctypes.c_int)
-    cdef int *categs = &categs_[0]
+    cdef int *categs = &categs_[0] if n_left else NULL
     cdef size_t n_used = 0
-    cdef int iix
-    for iix in range(<int>(cat_split.size())):
-        if cat_split[iix] == <signed char>1:
+    for iix in range(node.ncat_split):
+        if cat_goes_left(node, iix):
             categs[n_used] = iix
             n_used += 1
-    return list(cat_split)
+    return list(categs_)
 
 cdef class isoforest_cpp_obj:
     cdef IsoForest     isoforest
@@ -859,7 +861,7 @@ cdef class isoforest_cpp_obj:
                         cat_split_type_C, new_cat_action_C,
                         all_perm, imputer_ptr, min_imp_obs,
                         depth_imp_C, weigh_imp_rows_C, impute_at_fit,
-                        random_seed, use_long_double, nthreads)
+                        random_seed, use_long_double, nthreads, 0)
 
         if cy_check_interrupt_switch():
             cy_tick_off_interrupt_switch()
@@ -1652,7 +1654,7 @@ cdef class isoforest_cpp_obj:
                     return [self.isoforest.trees[tree][node].chosen_cat]
                 else:
                     if self.isoforest.trees[tree][node].cat_split.size():
-                        return get_list_left_categories(self.isoforest.trees[tree][node].cat_split)
+                        return get_list_left_categories(self.isoforest.trees[tree][node])
                     else:
                         return [0]
         else:
@@ -50,12 +50,16 @@ class build_ext_subclass( build_ext ):
                     (self.compiler.compiler_type.lower()
                      in ["mingw32", "mingw64", "mingw", "msys", "msys2", "gcc", "g++"]))
         no_ld = "NO_LONG_DOUBLE" in os.environ
+        use_dd = ("USE_DOUBLE_DOUBLE" in os.environ) and not no_ld
         has_robinmap = os.path.exists("src/robinmap/include/tsl")
 
         if is_msvc:
             for e in self.extensions:
                 e.extra_compile_args = ['/openmp', '/O2', '/GL', '/std:c++14', '/fp:except-', '/wd4244', '/wd4267', '/wd4018', '/wd5030']
-                e.define_macros += [("NO_LONG_DOUBLE", None)]
+                if use_dd:
+                    e.define_macros += [("USE_DOUBLE_DOUBLE", None)]
+                else:
+                    e.define_macros += [("NO_LONG_DOUBLE", None)]
                 if has_robinmap:
                     e.define_macros += [("_USE_ROBIN_MAP", None)]
         
@@ -82,7 +86,9 @@ class build_ext_subclass( build_ext ):
                 if has_robinmap:
                     e.define_macros += [("_USE_ROBIN_MAP", None)]
 
-                if is_windows or no_ld:
+                if use_dd:
+                    e.define_macros += [("USE_DOUBLE_DOUBLE", None)]
+                elif is_windows or no_ld:
                     e.define_macros += [("NO_LONG_DOUBLE", None)]
 
 
@@ -323,8 +329,10 @@ setup(
                                 sources=["isotree/cpp_interface.pyx",
                                          "src/indexer.cpp",
                                          "src/merge_models.cpp", "src/subset_models.cpp",
+                                         "src/random_cut.cpp",
                                          "src/serialize.cpp", "src/sql.cpp",
-                                         "src/formatted_exporters.cpp"],
+                                         "src/formatted_exporters.cpp",
+                                         "src/simd_kernels_avx2.cpp", "src/simd_kernels_avx512.cpp"],
                                 include_dirs=[np.get_include(), ".", "./src"],
                                 language="c++",
                                 install_requires = ["numpy", "pandas>=0.24.0", "cython", "scipy"],
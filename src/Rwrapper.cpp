@@ -722,7 +722,7 @@ Rcpp::List fit_model(Rcpp::NumericVector X_num, Rcpp::IntegerVector X_cat, Rcpp:
                 cat_split_type_C, new_cat_action_C,
                 all_perm, imputer_ptr.get(), min_imp_obs,
                 depth_imp_C, weigh_imp_rows_C, output_imputations,
-                (uint64_t) random_seed, use_long_double, nthreads);
+                (uint64_t) random_seed, use_long_double, nthreads, (size_t)0);
 
     Rcpp::checkUserInterrupt(); /* <- nothing is returned in this case */
     /* Note to self: the procedure has its own interrupt checker, so when an interrupt
@@ -77,133 +77,153 @@
 #define pw4(x) ((x) * (x) * (x) * (x))
 
 /* https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Higher-order_statistics */
-template <class real_t, class ldouble_safe>
-double calc_kurtosis(size_t ix_arr[], size_t st, size_t end, real_t x[], MissingAction missing_action)
+/* Running moments for non-weighted data are calculated separately for observations in interleaved
+   positions, which are then merged at the end through the pairwise formulas from the link above.
+   This way, the updates for consecutive observations do not depend on each other and can be
+   executed in parallel or with SIMD instructions when there are no missing values to skip.
+   This is done for 'double' and for the double-double type, but not for 'long double', as x87
+   long doubles cannot be vectorized and the extra accumulators end up spilled to memory. */
+#define N_LANES_MOMENTS 4
+#define n_lanes_moments(ldouble_safe) (std::is_same<ldouble_safe, long double>::value? 1 : N_LANES_MOMENTS)
+
+template <class ldouble_safe>
+static inline void update_moments(ldouble_safe xval, ldouble_safe &restrict cnt, ldouble_safe &restrict m,
+                                  ldouble_safe &restrict M2, ldouble_safe &restrict M3, ldouble_safe &restrict M4)
 {
-    ldouble_safe m = 0;
-    ldouble_safe M2 = 0, M3 = 0, M4 = 0;
-    ldouble_safe delta, delta_s, delta_div;
-    ldouble_safe diff, n;
-    ldouble_safe out;
+    ldouble_safe n_prev = cnt;
+    cnt += 1;
+    ldouble_safe delta     = xval - m;
+    ldouble_safe delta_div = delta / cnt;
+    ldouble_safe delta_s   = delta_div * delta_div;
+    ldouble_safe diff      = delta * (delta_div * n_prev);
+
+    m   +=  delta_div;
+    M4  +=  diff * delta_s * (cnt * cnt - 3 * cnt + 3) + 6 * delta_s * M2 - 4 * delta_div * M3;
+    M3  +=  diff * delta_div * (cnt - 2) - 3 * delta_div * M2;
+    M2  +=  diff;
+}
 
-    if (missing_action == Fail)
-    {
-        for (size_t row = st; row <= end; row++)
-        {
-            n  =  (ldouble_safe)(row - st + 1);
+template <class ldouble_safe>
+static inline void merge_moments(ldouble_safe &restrict cnt, ldouble_safe &restrict m,
+                                 ldouble_safe &restrict M2, ldouble_safe &restrict M3, ldouble_safe &restrict M4,
+                                 ldouble_safe cnt_b, ldouble_safe m_b, ldouble_safe M2_b, ldouble_safe M3_b, ldouble_safe M4_b)
+{
+    if (cnt_b <= 0) return;
+    if (cnt <= 0) {
+        cnt = cnt_b; m = m_b; M2 = M2_b; M3 = M3_b; M4 = M4_b;
+        return;
+    }
 
-            delta      =  x[ix_arr[row]] - m;
-            delta_div  =  delta / n;
-            delta_s    =  delta_div * delta_div;
-            diff       =  delta * (delta_div * (ldouble_safe)(row - st));
+    ldouble_safe n = cnt + cnt_b;
+    ldouble_safe delta = m_b - m;
+    ldouble_safe delta_div = delta / n;
+    ldouble_safe delta_div_s = delta_div * delta_div;
+    ldouble_safe prod_cnt = cnt * cnt_b;
+
+    M4 += M4_b
+            + delta * delta_div * delta_div_s * prod_cnt * (cnt * cnt - prod_cnt + cnt_b * cnt_b)
+            + 6 * delta_div_s * (cnt * cnt * M2_b + cnt_b * cnt_b * M2)
+            + 4 * delta_div * (cnt * M3_b - cnt_b * M3);
+    M3 += M3_b
+            + delta * delta_div_s * prod_cnt * (cnt - cnt_b)
+            + 3 * delta_div * (cnt * M2_b - cnt_b * M2);
+    M2 += M2_b + delta * delta_div * prod_cnt;
+    m  += delta_div * cnt_b;
+    cnt = n;
+}
 
-            m   +=  delta_div;
-            M4  +=  diff * delta_s * (n * n - 3 * n + 3) + 6 * delta_s * M2 - 4 * delta_div * M3;
-            M3  +=  diff * delta_div * (n - 2) - 3 * delta_div * M2;
-            M2  +=  diff;
-        }
+/* 'x_at(ix)' should return the value of the observation at position 'ix' */
+template <class ldouble_safe, size_t n_lanes, class value_getter>
+void calc_moments_by_lanes(size_t n, value_getter x_at, bool skip_missing,
+                           ldouble_safe &restrict cnt, ldouble_safe &restrict M2, ldouble_safe &restrict M4)
+{
+    ldouble_safe cnt_l[n_lanes];
+    ldouble_safe m_l[n_lanes];
+    ldouble_safe M2_l[n_lanes];
+    ldouble_safe M3_l[n_lanes];
+    ldouble_safe M4_l[n_lanes];
+    for (size_t lane = 0; lane < n_lanes; lane++)
+    {
+        cnt_l[lane] = 0; m_l[lane] = 0; M2_l[lane] = 0; M3_l[lane] = 0; M4_l[lane] = 0;
+    }
 
-        if (unlikely(!is_na_or_inf(M2) && M2 <= 0))
+    size_t n_full = n - (n % n_lanes);
+    if (!skip_missing)
+    {
+        for (size_t ix = 0; ix < n_full; ix += n_lanes)
         {
-            if (!check_more_than_two_unique_values(ix_arr, st, end, x, missing_action))
-                return -HUGE_VAL;
+            for (size_t lane = 0; lane < n_lanes; lane++)
+                update_moments<ldouble_safe>(x_at(ix + lane), cnt_l[lane], m_l[lane], M2_l[lane], M3_l[lane], M4_l[lane]);
         }
-
-        out = ( M4 / M2 ) * ( (ldouble_safe)(end - st + 1) / M2 );
-        return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
     }
 
     else
     {
-        size_t cnt = 0;
-        for (size_t row = st; row <= end; row++)
+        double xval;
+        for (size_t ix = 0; ix < n_full; ix += n_lanes)
         {
-            if (likely(!is_na_or_inf(x[ix_arr[row]])))
+            for (size_t lane = 0; lane < n_lanes; lane++)
             {
-                cnt++;
-                n = (ldouble_safe) cnt;
-
-                delta      =  x[ix_arr[row]] - m;
-                delta_div  =  delta / n;
-                delta_s    =  delta_div * delta_div;
-                diff       =  delta * (delta_div * (ldouble_safe)(cnt - 1));
-
-                m   +=  delta_div;
-                M4  +=  diff * delta_s * (n * n - 3 * n + 3) + 6 * delta_s * M2 - 4 * delta_div * M3;
-                M3  +=  diff * delta_div * (n - 2) - 3 * delta_div * M2;
-                M2  +=  diff;
+                xval = x_at(ix + lane);
+                if (likely(!is_na_or_inf(xval)))
+                    update_moments<ldouble_safe>(xval, cnt_l[lane], m_l[lane], M2_l[lane], M3_l[lane], M4_l[lane]);
             }
         }
+    }
 
-        if (unlikely(cnt == 0)) return -HUGE_VAL;
-        if (unlikely(!is_na_or_inf(M2) && M2 <= 0))
-        {
-            if (!check_more_than_two_unique_values(ix_arr, st, end, x, missing_action))
-                return -HUGE_VAL;
-        }
-
-        out = ( M4 / M2 ) * ( (ldouble_safe)cnt / M2 );
-        return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
+    for (size_t ix = n_full; ix < n; ix++)
+    {
+        double xval = x_at(ix);
+        if (skip_missing && is_na_or_inf(xval)) continue;
+        size_t lane = ix - n_full;
+        update_moments<ldouble_safe>(xval, cnt_l[lane], m_l[lane], M2_l[lane], M3_l[lane], M4_l[lane]);
     }
+
+    for (size_t lane = 1; lane < n_lanes; lane++)
+        merge_moments<ldouble_safe>(cnt_l[0], m_l[0], M2_l[0], M3_l[0], M4_l[0],
+                                    cnt_l[lane], m_l[lane], M2_l[lane], M3_l[lane], M4_l[lane]);
+    cnt = cnt_l[0];
+    M2 = M2_l[0];
+    M4 = M4_l[0];
 }
 
 template <class real_t, class ldouble_safe>
-double calc_kurtosis(real_t x[], size_t n, MissingAction missing_action)
+double calc_kurtosis(size_t ix_arr[], size_t st, size_t end, real_t x[], MissingAction missing_action)
 {
-    ldouble_safe m = 0;
-    ldouble_safe M2 = 0, M3 = 0, M4 = 0;
-    ldouble_safe delta, delta_s, delta_div;
-    ldouble_safe diff, n_;
+    ldouble_safe cnt, M2, M4;
     ldouble_safe out;
+    size_t *restrict ix_arr_st = ix_arr + st;
+    constexpr size_t n_lanes = n_lanes_moments(ldouble_safe);
+    calc_moments_by_lanes<ldouble_safe, n_lanes>(end - st + 1,
+                                                 [&x, &ix_arr_st](const size_t ix){return (double)x[ix_arr_st[ix]];},
+                                                 missing_action != Fail,
+                                                 cnt, M2, M4);
 
-    if (missing_action == Fail)
+    if (unlikely(cnt <= 0)) return -HUGE_VAL;
+    if (unlikely(!is_na_or_inf(M2) && M2 <= 0))
     {
-        for (size_t row = 0; row < n; row++)
-        {
-            n_  =  (ldouble_safe)(row + 1);
-
-            delta      =  x[row] - m;
-            delta_div  =  delta / n_;
-            delta_s    =  delta_div * delta_div;
-            diff       =  delta * (delta_div * (ldouble_safe)row);
-
-            m   +=  delta_div;
-            M4  +=  diff * delta_s * (n_ * n_ - 3 * n_ + 3) + 6 * delta_s * M2 - 4 * delta_div * M3;
-            M3  +=  diff * delta_div * (n_ - 2) - 3 * delta_div * M2;
-            M2  +=  diff;
-        }
-
-        out = ( M4 / M2 ) * ( (ldouble_safe)n / M2 );
-        return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
+        if (!check_more_than_two_unique_values(ix_arr, st, end, x, missing_action))
+            return -HUGE_VAL;
     }
 
-    else
-    {
-        size_t cnt = 0;
-        for (size_t row = 0; row < n; row++)
-        {
-            if (likely(!is_na_or_inf(x[row])))
-            {
-                cnt++;
-                n_ = (ldouble_safe) cnt;
-
-                delta      =  x[row] - m;
-                delta_div  =  delta / n_;
-                delta_s    =  delta_div * delta_div;
-                diff       =  delta * (delta_div * (ldouble_safe)(cnt - 1));
-
-                m   +=  delta_div;
-                M4  +=  diff * delta_s * (n_ * n_ - 3 * n_ + 3) + 6 * delta_s * M2 - 4 * delta_div * M3;
-                M3  +=  diff * delta_div * (n_ - 2) - 3 * delta_div * M2;
-                M2  +=  diff;
-            }
-        }
+    out = ( M4 / M2 ) * ( cnt / M2 );
+    return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
+}
+
+template <class real_t, class ldouble_safe>
+double calc_kurtosis(real_t x[], size_t n, MissingAction missing_action)
+{
+    ldouble_safe cnt, M2, M4;
+    ldouble_safe out;
+    constexpr size_t n_lanes = n_lanes_moments(ldouble_safe);
+    calc_moments_by_lanes<ldouble_safe, n_lanes>(n, [&x](const size_t ix){return (double)x[ix];},
+                                                 missing_action != Fail,
+                                                 cnt, M2, M4);
 
-        if (unlikely(cnt == 0)) return -HUGE_VAL;
+    if (unlikely(cnt <= 0)) return -HUGE_VAL;
 
-        out = ( M4 / M2 ) * ( (ldouble_safe)cnt / M2 );
-        return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
-    }
+    out = ( M4 / M2 ) * ( cnt / M2 );
+    return (!is_na_or_inf(out))? std::fmax((double)out, 0.) : (-HUGE_VAL);
 }
 
 /* TODO: is this algorithm correct? */
@@ -314,6 +334,7 @@ double calc_kurtosis(size_t *restrict ix_arr, size_t st, size_t end, size_t col_
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, Xc_ind[st_col]);
 
@@ -350,15 +371,15 @@ double calc_kurtosis(size_t *restrict ix_arr, size_t st, size_t end, size_t col_
                 }
 
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
 
@@ -385,15 +406,15 @@ double calc_kurtosis(size_t *restrict ix_arr, size_t st, size_t end, size_t col_
                 // s4 += pw4(xval);
 
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
     }
@@ -520,6 +541,7 @@ double calc_kurtosis_weighted(size_t *restrict ix_arr, size_t st, size_t end, si
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, Xc_ind[st_col]);
 
@@ -555,15 +577,15 @@ double calc_kurtosis_weighted(size_t *restrict ix_arr, size_t st, size_t end, si
                 }
 
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
 
@@ -592,15 +614,15 @@ double calc_kurtosis_weighted(size_t *restrict ix_arr, size_t st, size_t end, si
                 // s4 += w_this * pw4(xval);
 
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
     }
@@ -990,18 +1012,34 @@ double calc_kurtosis_weighted(size_t nrows, int x[], int ncat, double *restrict
                                            rnd_generator, w);
 }
 
+/* The variance here is a sum over the categories of 'p/3 - p^2/3' minus a sum over all the pairs of
+   categories of 'p1*p2/2', with the latter being '((sum p)^2 - sum p^2)/2', so it can be obtained
+   from the sum of the probabilities and the sum of their squares in a single pass. */
 template <class int_t, class ldouble_safe>
 double expected_sd_cat(double p[], size_t n, int_t pos[])
 {
     if (n <= 1) return 0;
 
-    ldouble_safe cum_var = -square(p[pos[0]]) / 3.0 - p[pos[0]] * p[pos[1]] / 2.0 + p[pos[0]] / 3.0  - square(p[pos[1]]) / 3.0 + p[pos[1]] / 3.0;
-    for (size_t cat1 = 2; cat1 < n; cat1++)
+    ldouble_safe sum_p = 0;
+    ldouble_safe sum_p2 = 0;
+    for (size_t cat = 0; cat < n; cat++)
     {
-        cum_var += p[pos[cat1]] / 3.0 - square(p[pos[cat1]]) / 3.0;
-        for (size_t cat2 = 0; cat2 < cat1; cat2++)
-            cum_var -= p[pos[cat1]] * p[pos[cat2]] / 2.0;
+        sum_p  += p[pos[cat]];
+        sum_p2 += square((ldouble_safe)p[pos[cat]]);
     }
+    ldouble_safe cum_var = (sum_p - sum_p2) / 3.0 - (square(sum_p) - sum_p2) / 4.0;
+    return std::sqrt(std::fmax(cum_var, (ldouble_safe)0));
+}
+
+/* Same as above for probabilities that add up to one, taking the total count of the 'n' categories
+   and the sum of their squared counts, in which case the variance simplifies to '(1 - sum p^2)/12'.
+   This allows evaluating a split in constant time after moving a category from one branch to the other. */
+template <class ldouble_safe>
+double expected_sd_cat_from_sums(ldouble_safe cnt, ldouble_safe cnt_sq, size_t n)
+{
+    if (n <= 1 || cnt <= 0) return 0;
+
+    ldouble_safe cum_var = (square(cnt) - cnt_sq) / (12.0 * square(cnt));
     return std::sqrt(std::fmax(cum_var, (ldouble_safe)0));
 }
 
@@ -1018,40 +1056,6 @@ double expected_sd_cat(number *restrict counts, double *restrict p, size_t n, in
     return expected_sd_cat<int_t, ldouble_safe>(p, n, pos);
 }
 
-template <class number, class int_t, class ldouble_safe>
-double expected_sd_cat_single(number *restrict counts, double *restrict p, size_t n, int_t *restrict pos, size_t cat_exclude, number cnt)
-{
-    if (cat_exclude == 0)
-        return expected_sd_cat<number, int_t, ldouble_safe>(counts, p, n-1, pos + 1);
-
-    else if (cat_exclude == (n-1))
-        return expected_sd_cat<number, int_t, ldouble_safe>(counts, p, n-1, pos);
-
-    size_t ix_exclude = pos[cat_exclude];
-
-    ldouble_safe cnt_div = (ldouble_safe) (cnt - counts[ix_exclude]);
-    for (size_t cat = 0; cat < n; cat++)
-        p[pos[cat]] = (ldouble_safe)counts[pos[cat]] / cnt_div;
-
-    ldouble_safe cum_var;
-    if (cat_exclude != 1)
-        cum_var = -square(p[pos[0]]) / 3.0 - p[pos[0]] * p[pos[1]] / 2.0 + p[pos[0]] / 3.0  - square(p[pos[1]]) / 3.0 + p[pos[1]] / 3.0;
-    else
-        cum_var = -square(p[pos[0]]) / 3.0 - p[pos[0]] * p[pos[2]] / 2.0 + p[pos[0]] / 3.0  - square(p[pos[2]]) / 3.0 + p[pos[2]] / 3.0;
-    for (size_t cat1 = (cat_exclude == 1)? 3 : 2; cat1 < n; cat1++)
-    {
-        if (pos[cat1] == ix_exclude) continue;
-        cum_var += p[pos[cat1]] / 3.0 - square(p[pos[cat1]]) / 3.0;
-        for (size_t cat2 = 0; cat2 < cat1; cat2++)
-        {
-            if (pos[cat2] == ix_exclude) continue;
-            cum_var -= p[pos[cat1]] * p[pos[cat2]] / 2.0;
-        }
-
-    }
-    return std::sqrt(std::fmax(cum_var, (ldouble_safe)0));
-}
-
 template <class number, class int_t, class ldouble_safe>
 double expected_sd_cat_internal(int ncat, number *restrict buffer_cnt, ldouble_safe cnt_l,
                                 int_t *restrict buffer_pos, double *restrict buffer_prob)
@@ -1174,8 +1178,8 @@ double categ_gain(number cnt_left, number cnt_right,
 {
     return (
             base_info -
-            (((cnt_left  <= 1)? 0 : ((ldouble_safe)cnt_left  * std::log((ldouble_safe)cnt_left)))  - s_left) -
-            (((cnt_right <= 1)? 0 : ((ldouble_safe)cnt_right * std::log((ldouble_safe)cnt_right))) - s_right)
+            (((cnt_left  <= 1)? (ldouble_safe)0 : ((ldouble_safe)cnt_left  * std::log((ldouble_safe)cnt_left)))  - s_left) -
+            (((cnt_right <= 1)? (ldouble_safe)0 : ((ldouble_safe)cnt_right * std::log((ldouble_safe)cnt_right))) - s_right)
             ) / cnt;
 }
 
@@ -1421,7 +1425,7 @@ real_t calc_sd_right_to_left(real_t_ *restrict x, size_t n, double *restrict sd_
         running_mean   += (x[n-row-1] - running_mean) / (real_t)(row+1);
         running_ssq    += (x[n-row-1] - running_mean) * (x[n-row-1] - mean_prev);
         mean_prev       =  running_mean;
-        sd_arr[n-row-1] = (row == 0)? 0. : std::sqrt(running_ssq / (real_t)(row+1));
+        sd_arr[n-row-1] = (row == 0)? 0. : (double)std::sqrt(running_ssq / (real_t)(row+1));
     }
     running_mean   += (x[0] - running_mean) / (real_t)n;
     running_ssq    += (x[0] - running_mean) * (x[0] - mean_prev);
@@ -1444,7 +1448,7 @@ ldouble_safe calc_sd_right_to_left_weighted(real_t_ *restrict x, size_t n, doubl
         running_mean   += w_this * (x[sorted_ix[n-row-1]] - running_mean) / cnt;
         running_ssq    += w_this * ((x[sorted_ix[n-row-1]] - running_mean) * (x[sorted_ix[n-row-1]] - mean_prev));
         mean_prev       =  running_mean;
-        sd_arr[n-row-1] = (row == 0)? 0. : std::sqrt(running_ssq / cnt);
+        sd_arr[n-row-1] = (row == 0)? 0. : (double)std::sqrt(running_ssq / cnt);
     }
     w_this = w[sorted_ix[0]];
     cnt += w_this;
@@ -1466,7 +1470,7 @@ real_t calc_sd_right_to_left(real_t_ *restrict x, real_t_ xmean, size_t ix_arr[]
         running_mean   += ((x[ix_arr[end-row]] - xmean) - running_mean) / (real_t)(row+1);
         running_ssq    += ((x[ix_arr[end-row]] - xmean) - running_mean) * ((x[ix_arr[end-row]] - xmean) - mean_prev);
         mean_prev       =  running_mean;
-        sd_arr[n-row-1] = (row == 0)? 0. : std::sqrt(running_ssq / (real_t)(row+1));
+        sd_arr[n-row-1] = (row == 0)? 0. : (double)std::sqrt(running_ssq / (real_t)(row+1));
     }
     running_mean   += ((x[ix_arr[st]] - xmean) - running_mean) / (real_t)n;
     running_ssq    += ((x[ix_arr[st]] - xmean) - running_mean) * ((x[ix_arr[st]] - xmean) - mean_prev);
@@ -1490,7 +1494,7 @@ ldouble_safe calc_sd_right_to_left_weighted(real_t_ *restrict x, real_t_ xmean,
         running_mean   += w_this * ((x[ix_arr[end-row]] - xmean) - running_mean) / cnt;
         running_ssq    += w_this * (((x[ix_arr[end-row]] - xmean) - running_mean) * ((x[ix_arr[end-row]] - xmean) - mean_prev));
         mean_prev       =  running_mean;
-        sd_arr[n-row-1] = (row == 0)? 0. : std::sqrt(running_ssq / cnt);
+        sd_arr[n-row-1] = (row == 0)? 0. : (double)std::sqrt(running_ssq / cnt);
     }
     w_this = w[ix_arr[st]];
     cnt += w_this;
@@ -1520,7 +1524,7 @@ double find_split_std_gain_t(real_t_ *restrict x, size_t n, double *restrict sd_
         if (x[row] == x[row+1])
             continue;
 
-        this_sd = (row == 0)? 0. : std::sqrt(running_ssq / (real_t)(row+1));
+        this_sd = (row == 0)? (real_t)0 : std::sqrt(running_ssq / (real_t)(row+1));
         this_gain = (criterion == Pooled)?
                     pooled_gain(full_sd, n_, this_sd, sd_arr[row+1], row+1, n-row-1)
                         :
@@ -1574,9 +1578,9 @@ double find_split_std_gain_weighted(real_t *restrict x, size_t n, double *restri
         if (x[sorted_ix[row]] == x[sorted_ix[row+1]])
             continue;
 
-        this_sd = (row == 0)? 0. : std::sqrt(running_ssq / currw);
+        this_sd = (row == 0)? 0. : (double)std::sqrt(running_ssq / currw);
         this_gain = (criterion == Pooled)?
-                    pooled_gain(full_sd, cumw, this_sd, sd_arr[row+1], currw, cumw-currw)
+                    (double)pooled_gain(full_sd, cumw, this_sd, sd_arr[row+1], currw, cumw-currw)
                         :
                     sd_gain(full_sd, this_sd, sd_arr[row+1]);
         if (this_gain > best_gain && this_gain > min_gain)
@@ -1612,7 +1616,7 @@ double find_split_std_gain_t(real_t_ *restrict x, real_t_ xmean, size_t ix_arr[]
         if (x[ix_arr[row]] == x[ix_arr[row+1]])
             continue;
 
-        this_sd = (row == st)? 0. : std::sqrt(running_ssq / (real_t)(row-st+1));
+        this_sd = (row == st)? (real_t)0 : std::sqrt(running_ssq / (real_t)(row-st+1));
         this_gain = (criterion == Pooled)?
                     pooled_gain(full_sd, n, this_sd, sd_arr[row-st+1], row-st+1, end-row)
                         :
@@ -1665,9 +1669,9 @@ double find_split_std_gain_weighted(real_t *restrict x, real_t xmean, size_t ix_
         if (x[ix_arr[row]] == x[ix_arr[row+1]])
             continue;
 
-        this_sd = (row == st)? 0. : std::sqrt(running_ssq / currw);
+        this_sd = (row == st)? 0. : (double)std::sqrt(running_ssq / currw);
         this_gain = (criterion == Pooled)?
-                    pooled_gain(full_sd, cumw, this_sd, sd_arr[row-st+1], currw, cumw-currw)
+                    (double)pooled_gain(full_sd, cumw, this_sd, sd_arr[row-st+1], currw, cumw-currw)
                         :
                     sd_gain(full_sd, this_sd, sd_arr[row-st+1]);
         if (this_gain > best_gain && this_gain > min_gain)
@@ -1722,6 +1726,95 @@ static inline void axpy1(const double a, double *restrict xval, size_t ind[], si
     for (size_t ix = 0; ix < nnz; ix++) y[ind[ix]] = std::fma(a, xval[ix], y[ind[ix]]);
 }
 
+/* Helpers for the full gain, which is calculated as 'ssq_left/n_left + ssq_right/n_right', with
+   'ssq' being the sums of squares of the column sums at each side. The dense variants add a row to
+   the left sums and calculate the sums of squares in the same pass over the columns, while the
+   sparse variants update the sums of squares only for the columns that change. */
+#ifndef _FOR_R
+[[gnu::optimize("Ofast")]]
+#endif
+static inline void sumsq_left_right(const double *restrict sum_left, const double *restrict sum_tot, size_t n,
+                                    double &restrict ssq_left, double &restrict ssq_right)
+{
+    double sl, sr;
+    double ssl = 0, ssr = 0;
+    for (size_t ix = 0; ix < n; ix++)
+    {
+        sl = sum_left[ix];
+        sr = sum_tot[ix] - sl;
+        ssl += sl * sl;
+        ssr += sr * sr;
+    }
+    ssq_left = ssl;
+    ssq_right = ssr;
+}
+
+#ifndef _FOR_R
+[[gnu::optimize("Ofast")]]
+#endif
+static inline void xpy1_sumsq(const double *restrict x, double *restrict sum_left, const double *restrict sum_tot, size_t n,
+                              double &restrict ssq_left, double &restrict ssq_right)
+{
+    double sl, sr;
+    double ssl = 0, ssr = 0;
+    for (size_t ix = 0; ix < n; ix++)
+    {
+        sl = sum_left[ix] + x[ix];
+        sum_left[ix] = sl;
+        sr = sum_tot[ix] - sl;
+        ssl += sl * sl;
+        ssr += sr * sr;
+    }
+    ssq_left = ssl;
+    ssq_right = ssr;
+}
+
+#ifndef _FOR_R
+[[gnu::optimize("Ofast")]]
+#endif
+static inline void axpy1_sumsq(const double a, const double *restrict x, double *restrict sum_left, const double *restrict sum_tot, size_t n,
+                               double &restrict ssq_left, double &restrict ssq_right)
+{
+    double sl, sr;
+    double ssl = 0, ssr = 0;
+    for (size_t ix = 0; ix < n; ix++)
+    {
+        sl = std::fma(a, x[ix], sum_left[ix]);
+        sum_left[ix] = sl;
+        sr = sum_tot[ix] - sl;
+        ssl += sl * sl;
+        ssr += sr * sr;
+    }
+    ssq_left = ssl;
+    ssq_right = ssr;
+}
+
+static inline void update_sumsq(const double xval, size_t ind, double *restrict sum_left, const double *restrict sum_tot,
+                                double &restrict ssq_left, double &restrict ssq_right)
+{
+    double sl_old = sum_left[ind];
+    double sl_new = sl_old + xval;
+    sum_left[ind] = sl_new;
+    ssq_left += (sl_new - sl_old) * (sl_new + sl_old);
+    double sr_old = sum_tot[ind] - sl_old;
+    double sr_new = sum_tot[ind] - sl_new;
+    ssq_right += (sr_new - sr_old) * (sr_new + sr_old);
+}
+
+static inline void xpy1_sumsq(const double *restrict xval, const size_t ind[], size_t nnz, double *restrict sum_left, const double *restrict sum_tot,
+                              double &restrict ssq_left, double &restrict ssq_right)
+{
+    for (size_t ix = 0; ix < nnz; ix++)
+        update_sumsq(xval[ix], ind[ix], sum_left, sum_tot, ssq_left, ssq_right);
+}
+
+static inline void axpy1_sumsq(const double a, const double *restrict xval, const size_t ind[], size_t nnz, double *restrict sum_left, const double *restrict sum_tot,
+                               double &restrict ssq_left, double &restrict ssq_right)
+{
+    for (size_t ix = 0; ix < nnz; ix++)
+        update_sumsq(a * xval[ix], ind[ix], sum_left, sum_tot, ssq_left, ssq_right);
+}
+
 #ifndef _FOR_R
     #if defined(__clang__)
         #pragma clang diagnostic pop
@@ -1771,19 +1864,21 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
             size_t *curr_col;
             double *restrict Xr_this;
             size_t *cols_end = cols_use + ncols_use;
+            bool gallop;
             for (size_t row = st; row <= end; row++)
             {
                 curr_begin = Xr_ind + Xr_indptr[ix_arr[row]];
                 row_end = Xr_ind + Xr_indptr[ix_arr[row] + 1];
                 if (curr_begin == row_end) continue;
                 curr_col = cols_use;
+                gallop = prefer_galloping(ncols_use, row_end - curr_begin);
                 Xr_this = Xr + Xr_indptr[ix_arr[row]];
                 
                 while (curr_col < cols_end && curr_begin < row_end)
                 {
                     if (*curr_begin == *curr_col)
                     {
-                        buffer_sum_tot[std::distance(cols_use, curr_col)] += Xr_this[std::distance(curr_begin, row_end)];
+                        buffer_sum_tot[std::distance(cols_use, curr_col)] += Xr_this[std::distance(Xr_ind + Xr_indptr[ix_arr[row]], curr_begin)];
                         curr_col++;
                         curr_begin++;
                     }
@@ -1791,9 +1886,9 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
                     else
                     {
                         if (*curr_begin > *curr_col)
-                            curr_col = std::lower_bound(curr_col, cols_end, *curr_begin);
+                            curr_col = advance_sorted(curr_col, cols_end, *curr_begin, gallop);
                         else
-                            curr_begin = std::lower_bound(curr_begin, row_end, *curr_col);
+                            curr_begin = advance_sorted(curr_begin, row_end, *curr_col, gallop);
                     }
                 }
             }
@@ -1812,9 +1907,8 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
 
     double best_gain = -HUGE_VAL;
     double this_gain;
-    double sl, sr;
+    double ssq_left, ssq_right;
     double dl, dr;
-    double vleft, vright;
     memset(buffer_sum_left, 0, (force_cols_use? ncols_use : ncols)*sizeof(double));
     if (Xr_indptr == NULL)
     {
@@ -1822,27 +1916,23 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
         {
             for (size_t row = st; row < end; row++)
             {
-                xpy1(X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
                 if (x_uses_ix_arr) {
-                    if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) continue;
+                    if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) {
+                        xpy1(X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
+                        continue;
+                    }
                 }
                 else {
-                    if (unlikely(x[row] == x[row+1])) continue;
+                    if (unlikely(x[row] == x[row+1])) {
+                        xpy1(X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
+                        continue;
+                    }
                 }
 
-                vleft = 0;
-                vright = 0;
+                xpy1_sumsq(X_row_major + ix_arr[row]*ncols, buffer_sum_left, buffer_sum_tot, ncols, ssq_left, ssq_right);
                 dl = (double)(row-st+1);
                 dr = (double)(end-row);
-                for (size_t col = 0; col < ncols; col++)
-                {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / dl);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / dr);
-                }
-
-                this_gain = vleft + vright;
+                this_gain = ssq_left / dl + ssq_right / dr;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -1866,19 +1956,10 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
+                sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_use, ssq_left, ssq_right);
                 dl = (double)(row-st+1);
                 dr = (double)(end-row);
-                for (size_t col = 0; col < ncols_use; col++)
-                {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / dl);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / dr);
-                }
-
-                this_gain = vleft + vright;
+                this_gain = ssq_left / dl + ssq_right / dr;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -1890,13 +1971,23 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
 
     else
     {
+        /* Here the sums of squares are updated only for the non-zero entries of each row,
+           and recalculated from scratch once every 'ncols' updates to limit the accumulation
+           of rounding errors, so that the cost per row is proportional to its non-zeros. */
+        size_t ncols_sum = force_cols_use? ncols_use : ncols;
+        size_t n_updates = 0;
+        sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+
         if (!force_cols_use)
         {
             size_t ptr_this;
+            size_t nnz_this;
             for (size_t row = st; row < end; row++)
             {
                 ptr_this = Xr_indptr[ix_arr[row]];
-                xpy1(Xr + ptr_this, Xr_ind + ptr_this, Xr_indptr[ix_arr[row]+1] - ptr_this, buffer_sum_left);
+                nnz_this = Xr_indptr[ix_arr[row]+1] - ptr_this;
+                xpy1_sumsq(Xr + ptr_this, Xr_ind + ptr_this, nnz_this, buffer_sum_left, buffer_sum_tot, ssq_left, ssq_right);
+                n_updates += nnz_this;
                 if (x_uses_ix_arr) {
                     if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) continue;
                 }
@@ -1904,19 +1995,14 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
-                dl = (double)(row-st+1);
-                dr = (double)(end-row);
-                for (size_t col = 0; col < ncols; col++)
+                if (n_updates >= ncols_sum)
                 {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / dl);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / dr);
+                    sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+                    n_updates = 0;
                 }
-
-                this_gain = vleft + vright;
+                dl = (double)(row-st+1);
+                dr = (double)(end-row);
+                this_gain = ssq_left / dl + ssq_right / dr;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -1927,23 +2013,31 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
 
         else
         {
+            size_t *row_begin;
             size_t *curr_begin;
             size_t *row_end;
             size_t *curr_col;
             double *restrict Xr_this;
             size_t *cols_end = cols_use + ncols_use;
+            bool gallop;
+            size_t dtemp;
             for (size_t row = st; row < end; row++)
             {
-                curr_begin = Xr_ind + Xr_indptr[ix_arr[row]];
+                row_begin = Xr_ind + Xr_indptr[ix_arr[row]];
                 row_end = Xr_ind + Xr_indptr[ix_arr[row] + 1];
-                if (curr_begin == row_end) goto skip_sum;
+                if (row_begin == row_end) goto skip_sum;
+                curr_begin = row_begin;
                 curr_col = cols_use;
+                gallop = prefer_galloping(ncols_use, row_end - curr_begin);
                 Xr_this = Xr + Xr_indptr[ix_arr[row]];
                 while (curr_col < cols_end && curr_begin < row_end)
                 {
                     if (*curr_begin == *curr_col)
                     {
-                        buffer_sum_left[std::distance(cols_use, curr_col)] += Xr_this[std::distance(curr_begin, row_end)];
+                        dtemp = std::distance(cols_use, curr_col);
+                        update_sumsq(Xr_this[std::distance(row_begin, curr_begin)], dtemp,
+                                     buffer_sum_left, buffer_sum_tot, ssq_left, ssq_right);
+                        n_updates++;
                         curr_col++;
                         curr_begin++;
                     }
@@ -1951,9 +2045,9 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
                     else
                     {
                         if (*curr_begin > *curr_col)
-                            curr_col = std::lower_bound(curr_col, cols_end, *curr_begin);
+                            curr_col = advance_sorted(curr_col, cols_end, *curr_begin, gallop);
                         else
-                            curr_begin = std::lower_bound(curr_begin, row_end, *curr_col);
+                            curr_begin = advance_sorted(curr_begin, row_end, *curr_col, gallop);
                     }
                 }
 
@@ -1965,19 +2059,14 @@ double find_split_full_gain(real_t *restrict x, size_t st, size_t end, size_t *r
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
-                dl = (double)(row-st+1);
-                dr = (double)(end-row);
-                for (size_t col = 0; col < ncols_use; col++)
+                if (n_updates >= ncols_sum)
                 {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / dl);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / dr);
+                    sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+                    n_updates = 0;
                 }
-
-                this_gain = vleft + vright;
+                dl = (double)(row-st+1);
+                dr = (double)(end-row);
+                this_gain = ssq_left / dl + ssq_right / dr;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -2101,6 +2190,7 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
             size_t *curr_col;
             double *restrict Xr_this;
             size_t *cols_end = cols_use + ncols_use;
+            bool gallop;
             double w_row;
             for (size_t row = st; row <= end; row++)
             {
@@ -2108,6 +2198,7 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                 row_end = Xr_ind + Xr_indptr[ix_arr[row] + 1];
                 if (curr_begin == row_end) continue;
                 curr_col = cols_use;
+                gallop = prefer_galloping(ncols_use, row_end - curr_begin);
                 Xr_this = Xr + Xr_indptr[ix_arr[row]];
                 w_row = w[x_uses_ix_arr? ix_arr[row] : row];
                 size_t dtemp;
@@ -2119,7 +2210,7 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                         dtemp = std::distance(cols_use, curr_col);
                         buffer_sum_tot[dtemp]
                             =
-                        std::fma(w_row, Xr_this[std::distance(curr_begin, row_end)], buffer_sum_tot[dtemp]);
+                        std::fma(w_row, Xr_this[std::distance(Xr_ind + Xr_indptr[ix_arr[row]], curr_begin)], buffer_sum_tot[dtemp]);
                         curr_col++;
                         curr_begin++;
                     }
@@ -2127,9 +2218,9 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                     else
                     {
                         if (*curr_begin > *curr_col)
-                            curr_col = std::lower_bound(curr_col, cols_end, *curr_begin);
+                            curr_col = advance_sorted(curr_col, cols_end, *curr_begin, gallop);
                         else
-                            curr_begin = std::lower_bound(curr_begin, row_end, *curr_col);
+                            curr_begin = advance_sorted(curr_begin, row_end, *curr_col, gallop);
                     }
                 }
             }
@@ -2138,8 +2229,7 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
 
     double best_gain = -HUGE_VAL;
     double this_gain;
-    double sl, sr;
-    double vleft, vright;
+    double ssq_left, ssq_right;
     double wleft = 0;
     double w_row;
     double wright;
@@ -2152,26 +2242,22 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
             {
                 w_row = w[x_uses_ix_arr? ix_arr[row] : row];
                 wleft += w_row;
-                axpy1(w_row, X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
                 if (x_uses_ix_arr) {
-                    if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) continue;
+                    if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) {
+                        axpy1(w_row, X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
+                        continue;
+                    }
                 }
                 else {
-                    if (unlikely(x[row] == x[row+1])) continue;
+                    if (unlikely(x[row] == x[row+1])) {
+                        axpy1(w_row, X_row_major + ix_arr[row]*ncols, buffer_sum_left, ncols);
+                        continue;
+                    }
                 }
 
-                vleft = 0;
-                vright = 0;
+                axpy1_sumsq(w_row, X_row_major + ix_arr[row]*ncols, buffer_sum_left, buffer_sum_tot, ncols, ssq_left, ssq_right);
                 wright = wtot - wleft;
-                for (size_t col = 0; col < ncols; col++)
-                {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / wleft);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / wright);
-                }
-
-                this_gain = vleft + vright;
+                this_gain = ssq_left / wleft + ssq_right / wright;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -2183,7 +2269,6 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
         else
         {
             double *restrict ptr_row;
-            double w_row;
             for (size_t row = st; row < end; row++)
             {
                 w_row = w[x_uses_ix_arr? ix_arr[row] : row];
@@ -2199,18 +2284,9 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
+                sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_use, ssq_left, ssq_right);
                 wright = wtot - wleft;
-                for (size_t col = 0; col < ncols_use; col++)
-                {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / wleft);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / wright);
-                }
-
-                this_gain = vleft + vright;
+                this_gain = ssq_left / wleft + ssq_right / wright;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -2222,16 +2298,23 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
 
     else
     {
+        /* see the unweighted version for the logic behind these updates */
+        size_t ncols_sum = force_cols_use? ncols_use : ncols;
+        size_t n_updates = 0;
+        sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+
         if (!force_cols_use)
         {
             size_t ptr_this;
-            double w_row;
+            size_t nnz_this;
             for (size_t row = st; row < end; row++)
             {
-                w_row= w[x_uses_ix_arr? ix_arr[row] : row];
+                w_row = w[x_uses_ix_arr? ix_arr[row] : row];
                 wleft += w_row;
                 ptr_this = Xr_indptr[ix_arr[row]];
-                axpy1(w_row, Xr + ptr_this, Xr_ind + ptr_this, Xr_indptr[ix_arr[row]+1] - ptr_this, buffer_sum_left);
+                nnz_this = Xr_indptr[ix_arr[row]+1] - ptr_this;
+                axpy1_sumsq(w_row, Xr + ptr_this, Xr_ind + ptr_this, nnz_this, buffer_sum_left, buffer_sum_tot, ssq_left, ssq_right);
+                n_updates += nnz_this;
                 if (x_uses_ix_arr) {
                     if (unlikely(x[ix_arr[row]] == x[ix_arr[row+1]])) continue;
                 }
@@ -2239,18 +2322,13 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
-                wright = wtot - wleft;
-                for (size_t col = 0; col < ncols; col++)
+                if (n_updates >= ncols_sum)
                 {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / wleft);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / wright);
+                    sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+                    n_updates = 0;
                 }
-
-                this_gain = vleft + vright;
+                wright = wtot - wleft;
+                this_gain = ssq_left / wleft + ssq_right / wright;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -2261,31 +2339,34 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
 
         else
         {
+            size_t *row_begin;
             size_t *curr_begin;
             size_t *row_end;
             size_t *curr_col;
             double *restrict Xr_this;
             size_t *cols_end = cols_use + ncols_use;
-            double w_row;
+            bool gallop;
             size_t dtemp;
             for (size_t row = st; row < end; row++)
             {
                 w_row = w[x_uses_ix_arr? ix_arr[row] : row];
                 wleft += w_row;
                 
-                curr_begin = Xr_ind + Xr_indptr[ix_arr[row]];
+                row_begin = Xr_ind + Xr_indptr[ix_arr[row]];
                 row_end = Xr_ind + Xr_indptr[ix_arr[row] + 1];
-                if (curr_begin == row_end) goto skip_sum;
+                if (row_begin == row_end) goto skip_sum;
+                curr_begin = row_begin;
                 curr_col = cols_use;
+                gallop = prefer_galloping(ncols_use, row_end - curr_begin);
                 Xr_this = Xr + Xr_indptr[ix_arr[row]];
                 while (curr_col < cols_end && curr_begin < row_end)
                 {
                     if (*curr_begin == *curr_col)
                     {
                         dtemp = std::distance(cols_use, curr_col);
-                        buffer_sum_left[dtemp]
-                            =
-                        std::fma(w_row, Xr_this[std::distance(curr_begin, row_end)], buffer_sum_left[dtemp]);
+                        update_sumsq(w_row * Xr_this[std::distance(row_begin, curr_begin)], dtemp,
+                                     buffer_sum_left, buffer_sum_tot, ssq_left, ssq_right);
+                        n_updates++;
                         curr_col++;
                         curr_begin++;
                     }
@@ -2293,9 +2374,9 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                     else
                     {
                         if (*curr_begin > *curr_col)
-                            curr_col = std::lower_bound(curr_col, cols_end, *curr_begin);
+                            curr_col = advance_sorted(curr_col, cols_end, *curr_begin, gallop);
                         else
-                            curr_begin = std::lower_bound(curr_begin, row_end, *curr_col);
+                            curr_begin = advance_sorted(curr_begin, row_end, *curr_col, gallop);
                     }
                 }
 
@@ -2307,18 +2388,13 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
                     if (unlikely(x[row] == x[row+1])) continue;
                 }
 
-                vleft = 0;
-                vright = 0;
-                wright = wtot - wleft;
-                for (size_t col = 0; col < ncols_use; col++)
+                if (n_updates >= ncols_sum)
                 {
-                    sl = buffer_sum_left[col];
-                    vleft += sl * (sl / wleft);
-                    sr = buffer_sum_tot[col] - sl;
-                    vright += sr * (sr / wright);
+                    sumsq_left_right(buffer_sum_left, buffer_sum_tot, ncols_sum, ssq_left, ssq_right);
+                    n_updates = 0;
                 }
-
-                this_gain = vleft + vright;
+                wright = wtot - wleft;
+                this_gain = ssq_left / wleft + ssq_right / wright;
                 if (this_gain > best_gain)
                 {
                     best_gain = this_gain;
@@ -2330,7 +2406,10 @@ double find_split_full_gain_weighted(real_t *restrict x, size_t st, size_t end,
 
     if (best_gain  <= -HUGE_VAL) return best_gain;
     
-    split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
+    if (x_uses_ix_arr)
+        split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
+    else
+        split_point = midpoint(x[split_ix], x[split_ix+1]);
     return best_gain / wtot;
 }
 
@@ -2541,7 +2620,7 @@ double find_split_dens_shortform_weighted(real_t *restrict x, size_t *restrict i
     w_right = wtot - w_left;
     w_left = std::fmax(w_left, std::numeric_limits<double>::min());
     w_right = std::fmax(w_right, std::numeric_limits<double>::min());
-    split_point = midpoint(x[split_ix], x[split_ix+1]);
+    split_point = midpoint(x[ix_arr[split_ix]], x[ix_arr[split_ix+1]]);
     double rpct_left = split_point / xtot;
     rpct_left = std::fmax(rpct_left, std::numeric_limits<double>::min());
     double rpct_right = 1. - rpct_left;
@@ -3538,12 +3617,25 @@ double eval_guided_crit_weighted(size_t ix_arr[], size_t st, size_t end,
      smallest or the largest category to assign to one branch, but sometimes picks groups too.
    - For Pooled criterion, will take shannon entropy, which tends to make a more even split. In the case of splitting
      by a single category, it always puts the largest category in a separate branch. In the case of subsets,
-     it can either evaluate possible splits over all permutations (not feasible if there are too many categories),
-     or look up for splits in sorted order just like for Averaged criterion.
+     it can either evaluate possible splits over all permutations (only done with up to 'MAX_CATEG_ALL_PERM' categories
+     present in the node), or look up for splits in sorted order just like for Averaged criterion.
+   - Splits in sorted order are evaluated in constant time each by keeping running sums of the counts at each side
+     (and of their squares for Averaged), so the search is dominated by the sorting of the categories.
    Splitting by averaged Gini gain (like with Averaged) also selects always the second-largest category to put in one branch,
    while splitting by weighted Gini (like with Pooled) usually selects the largest category to put in one branch. The
    Gini gain is not easily comparable to that of numerical columns, so it's not offered as an option here.
 */
+
+/* Puts in the left branch the categories up to 'best_pos' in the sorted order, taking the rest of the
+   split from 'buffer_split', in which categories that are not present are already marked */
+static inline void set_sorted_categ_split(signed char *restrict split_categ, signed char *restrict buffer_split,
+                                          const size_t *restrict buffer_pos, size_t st_pos, size_t best_pos, int ncat)
+{
+    for (size_t pos = st_pos; pos <= best_pos; pos++)
+        buffer_split[buffer_pos[pos]] = 1;
+    memcpy(split_categ, buffer_split, ncat * sizeof(signed char));
+}
+
 /* https://math.stackexchange.com/questions/3343384/expected-variance-and-kurtosis-from-pmf-in-which-possible-discrete-values-are-dr */
 /* TODO: 'buffer_pos' doesn't need to be 'size_t', 'int' would suffice */
 template <class ldouble_safe>
@@ -3642,13 +3734,22 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                     if (ncat_present <= 1) return -HUGE_VAL;
 
                     double sd_full = expected_sd_cat<size_t, ldouble_safe>(buffer_prob, ncat_present, buffer_pos + st_pos);
+                    ldouble_safe cnt_present = 0;
+                    ldouble_safe cnt_sq = 0;
+                    for (size_t pos = st_pos; (int)pos < ncat; pos++)
+                    {
+                        cnt_present += buffer_cnt[buffer_pos[pos]];
+                        cnt_sq      += square((ldouble_safe)buffer_cnt[buffer_pos[pos]]);
+                    }
 
                     /* try isolating each category one at a time */
+                    ldouble_safe cnt_this;
                     for (size_t pos = st_pos; (int)pos < ncat; pos++)
                     {
+                        cnt_this = buffer_cnt[buffer_pos[pos]];
                         this_gain = sd_gain(sd_full,
                                             0.0,
-                                            (expected_sd_cat_single<size_t, size_t, ldouble_safe>(buffer_cnt, buffer_prob, ncat_present, buffer_pos + st_pos, pos - st_pos, cnt)));
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_present - cnt_this, cnt_sq - square(cnt_this), ncat_present - 1));
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
                             best_gain = this_gain;
@@ -3732,23 +3833,39 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                     /* calculate full SD assuming they take values randomly ~Unif(0, 1) */
                     size_t ncat_present = (size_t)ncat - st_pos;
                     sd_full = expected_sd_cat<size_t, ldouble_safe>(buffer_prob, ncat_present, buffer_pos + st_pos);
-                    if (ncat_present >= log2ceil(SIZE_MAX)) all_perm = false;
 
                     /* move categories one at a time */
-                    for (size_t pos = st_pos; pos < ((size_t)ncat - st_pos - 1); pos++)
+                    ldouble_safe cnt_left = 0, cnt_sq_left = 0;
+                    ldouble_safe cnt_right = 0, cnt_sq_right = 0;
+                    ldouble_safe cnt_this;
+                    size_t best_pos = st_pos;
+                    for (size_t pos = st_pos; pos < (size_t)ncat; pos++)
+                    {
+                        cnt_right    += buffer_cnt[buffer_pos[pos]];
+                        cnt_sq_right += square((ldouble_safe)buffer_cnt[buffer_pos[pos]]);
+                    }
+
+                    for (size_t pos = st_pos; pos < ((size_t)ncat - 1); pos++)
                     {
-                        buffer_split[buffer_pos[pos]] = 1;
+                        cnt_this      = buffer_cnt[buffer_pos[pos]];
+                        cnt_left     += cnt_this;
+                        cnt_sq_left  += square(cnt_this);
+                        cnt_right    -= cnt_this;
+                        cnt_sq_right -= square(cnt_this);
                         this_gain = sd_gain(sd_full,
-                                            (expected_sd_cat<size_t, size_t, ldouble_safe>(buffer_cnt, buffer_prob, pos - st_pos + 1, buffer_pos + st_pos)),
-                                            (expected_sd_cat<size_t, size_t, ldouble_safe>(buffer_cnt, buffer_prob, (size_t)ncat - pos - 1, buffer_pos + pos + 1))
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_left, cnt_sq_left, pos - st_pos + 1),
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_right, cnt_sq_right, (size_t)ncat - pos - 1)
                                             );
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
                             best_gain = this_gain;
-                            memcpy(split_categ, buffer_split, ncat * sizeof(signed char));
+                            best_pos = pos;
                         }
                     }
 
+                    if (best_gain > -HUGE_VAL)
+                        set_sorted_categ_split(split_categ, buffer_split, buffer_pos, st_pos, best_pos, ncat);
+
                     break;
                 }
 
@@ -3762,7 +3879,7 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                         if (buffer_cnt[buffer_pos[cat]])
                         {
                             s += (buffer_cnt[buffer_pos[cat]] <= 1)?
-                                  0 : ((ldouble_safe) buffer_cnt[buffer_pos[cat]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[cat]]));
+                                  (ldouble_safe)0 : ((ldouble_safe) buffer_cnt[buffer_pos[cat]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[cat]]));
                         }
 
                         else
@@ -3777,7 +3894,7 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                     /* calculate base info */
                     ldouble_safe base_info = cnt * std::log(cnt) - s;
 
-                    if (all_perm)
+                    if (all_perm && (size_t)ncat - st_pos <= MAX_CATEG_ALL_PERM)
                     {
                         size_t cnt_left, cnt_right;
                         double s_left, s_right;
@@ -3791,11 +3908,11 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                             s_left   = 0;   s_right = 0;
                             for (size_t pos = st_pos; (int)pos < ncat; pos++)
                             {
-                                if (extract_bit(combin, pos))
+                                if (extract_bit(combin, pos - st_pos))
                                 {
                                     cnt_left += buffer_cnt[buffer_pos[pos]];
                                     s_left   += (buffer_cnt[buffer_pos[pos]] <= 1)?
-                                                 0 : ((ldouble_safe) buffer_cnt[buffer_pos[pos]]
+                                                 (ldouble_safe)0 : ((ldouble_safe) buffer_cnt[buffer_pos[pos]]
                                                        * std::log((ldouble_safe) buffer_cnt[buffer_pos[pos]]));
                                 }
 
@@ -3803,7 +3920,7 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                                 {
                                     cnt_right += buffer_cnt[buffer_pos[pos]];
                                     s_right   += (buffer_cnt[buffer_pos[pos]] <= 1)?
-                                                  0 : ((ldouble_safe) buffer_cnt[buffer_pos[pos]]
+                                                  (ldouble_safe)0 : ((ldouble_safe) buffer_cnt[buffer_pos[pos]]
                                                         * std::log((ldouble_safe) buffer_cnt[buffer_pos[pos]]));
                                 }
                             }
@@ -3835,13 +3952,14 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                         double s_left = 0;
                         double s_right = s;
 
-                        for (size_t pos = st_pos; pos < (ncat - st_pos - 1); pos++)
+                        size_t best_pos = st_pos;
+
+                        for (size_t pos = st_pos; pos < ((size_t)ncat - 1); pos++)
                         {
-                            buffer_split[buffer_pos[pos]] = 1;
                             s_left    += (buffer_cnt[buffer_pos[pos]] <= 1)?
-                                          0 : ((ldouble_safe)buffer_cnt[buffer_pos[pos]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[pos]]));
+                                          (ldouble_safe)0 : ((ldouble_safe)buffer_cnt[buffer_pos[pos]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[pos]]));
                             s_right   -= (buffer_cnt[buffer_pos[pos]] <= 1)?
-                                          0 : ((ldouble_safe)buffer_cnt[buffer_pos[pos]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[pos]]));
+                                          (ldouble_safe)0 : ((ldouble_safe)buffer_cnt[buffer_pos[pos]] * std::log((ldouble_safe)buffer_cnt[buffer_pos[pos]]));
                             cnt_left  += buffer_cnt[buffer_pos[pos]];
                             cnt_right -= buffer_cnt[buffer_pos[pos]];
 
@@ -3853,9 +3971,12 @@ double eval_guided_crit(size_t *restrict ix_arr, size_t st, size_t end, int *res
                             if (this_gain > min_gain && this_gain > best_gain)
                             {
                                 best_gain = this_gain;
-                                memcpy(split_categ, buffer_split, ncat * sizeof(signed char));
+                                best_pos = pos;
                             }
                         }
+
+                        if (best_gain > -HUGE_VAL)
+                            set_sorted_categ_split(split_categ, buffer_split, buffer_pos, st_pos, best_pos, ncat);
                     }
 
                     break;
@@ -3982,14 +4103,22 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                     if (ncat_present <= 1) return -HUGE_VAL;
 
                     double sd_full = expected_sd_cat<size_t, ldouble_safe>(buffer_prob, ncat_present, buffer_pos + st_pos);
+                    ldouble_safe cnt_present = 0;
+                    ldouble_safe cnt_sq = 0;
+                    for (size_t pos = st_pos; (int)pos < ncat; pos++)
+                    {
+                        cnt_present += buffer_cnt[buffer_pos[pos]];
+                        cnt_sq      += square((ldouble_safe)buffer_cnt[buffer_pos[pos]]);
+                    }
 
                     /* try isolating each category one at a time */
+                    ldouble_safe cnt_this;
                     for (size_t pos = st_pos; (int)pos < ncat; pos++)
                     {
+                        cnt_this = buffer_cnt[buffer_pos[pos]];
                         this_gain = sd_gain(sd_full,
                                             0.0,
-                                            (expected_sd_cat_single<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, ncat_present, buffer_pos + st_pos, pos - st_pos, cnt))
-                                            );
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_present - cnt_this, cnt_sq - square(cnt_this), ncat_present - 1));
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
                             best_gain = this_gain;
@@ -4074,24 +4203,40 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                     /* calculate full SD assuming they take values randomly ~Unif(0, 1) */
                     size_t ncat_present = (size_t)ncat - st_pos;
                     sd_full = expected_sd_cat<size_t, ldouble_safe>(buffer_prob, ncat_present, buffer_pos + st_pos);
-                    if (ncat_present >= log2ceil(SIZE_MAX)) all_perm = false;
 
                     /* move categories one at a time */
-                    for (size_t pos = st_pos; pos < ((size_t)ncat - st_pos - 1); pos++)
+                    ldouble_safe cnt_left = 0, cnt_sq_left = 0;
+                    ldouble_safe cnt_right = 0, cnt_sq_right = 0;
+                    ldouble_safe cnt_this;
+                    size_t best_pos = st_pos;
+                    for (size_t pos = st_pos; pos < (size_t)ncat; pos++)
                     {
-                        buffer_split[buffer_pos[pos]] = 1;
+                        cnt_right    += buffer_cnt[buffer_pos[pos]];
+                        cnt_sq_right += square((ldouble_safe)buffer_cnt[buffer_pos[pos]]);
+                    }
+
+                    for (size_t pos = st_pos; pos < ((size_t)ncat - 1); pos++)
+                    {
+                        cnt_this      = buffer_cnt[buffer_pos[pos]];
+                        cnt_left     += cnt_this;
+                        cnt_sq_left  += square(cnt_this);
+                        cnt_right    -= cnt_this;
+                        cnt_sq_right -= square(cnt_this);
                         /* TODO: is this correct? */
                         this_gain = sd_gain(sd_full,
-                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, pos - st_pos + 1, buffer_pos + st_pos)),
-                                            (expected_sd_cat<ldouble_safe, size_t, ldouble_safe>(buffer_cnt, buffer_prob, (size_t)ncat - pos - 1, buffer_pos + pos + 1))
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_left, cnt_sq_left, pos - st_pos + 1),
+                                            expected_sd_cat_from_sums<ldouble_safe>(cnt_right, cnt_sq_right, (size_t)ncat - pos - 1)
                                             );
                         if (this_gain > min_gain && this_gain > best_gain)
                         {
                             best_gain = this_gain;
-                            memcpy(split_categ, buffer_split, ncat * sizeof(signed char));
+                            best_pos = pos;
                         }
                     }
 
+                    if (best_gain > -HUGE_VAL)
+                        set_sorted_categ_split(split_categ, buffer_split, buffer_pos, st_pos, best_pos, ncat);
+
                     break;
                 }
 
@@ -4122,7 +4267,7 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                     /* calculate base info */
                     ldouble_safe base_info = std::fmax((ldouble_safe)1, cnt) * std::log(std::fmax((ldouble_safe)1, cnt)) - s;
 
-                    if (all_perm)
+                    if (all_perm && (size_t)ncat - st_pos <= MAX_CATEG_ALL_PERM)
                     {
                         size_t cnt_left, cnt_right;
                         double s_left, s_right;
@@ -4136,7 +4281,7 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                             s_left   = 0;   s_right = 0;
                             for (size_t pos = st_pos; (int)pos < ncat; pos++)
                             {
-                                if (extract_bit(combin, pos))
+                                if (extract_bit(combin, pos - st_pos))
                                 {
                                     cnt_left += buffer_cnt[buffer_pos[pos]];
                                     s_left   += (buffer_cnt[buffer_pos[pos]] <= 1)?
@@ -4184,9 +4329,10 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                         double s_left = 0;
                         double s_right = s;
 
-                        for (size_t pos = st_pos; pos < (ncat - st_pos - 1); pos++)
+                        size_t best_pos = st_pos;
+
+                        for (size_t pos = st_pos; pos < ((size_t)ncat - 1); pos++)
                         {
-                            buffer_split[buffer_pos[pos]] = 1;
                             s_left    += (buffer_cnt[buffer_pos[pos]] <= 1)?
                                           (ldouble_safe)0
                                              :
@@ -4206,9 +4352,12 @@ double eval_guided_crit_weighted(size_t *restrict ix_arr, size_t st, size_t end,
                             if (this_gain > min_gain && this_gain > best_gain)
                             {
                                 best_gain = this_gain;
-                                memcpy(split_categ, buffer_split, ncat * sizeof(signed char));
+                                best_pos = pos;
                             }
                         }
+
+                        if (best_gain > -HUGE_VAL)
+                            set_sorted_categ_split(split_categ, buffer_split, buffer_pos, st_pos, best_pos, ncat);
                     }
 
                     break;
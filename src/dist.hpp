@@ -250,7 +250,7 @@ void calc_similarity(real_t numeric_data[], int categ_data[],
         );
     #ifndef NO_LONG_DOUBLE
     else
-        calc_similarity_internal<real_t, sparse_ix, long double>(
+        calc_similarity_internal<real_t, sparse_ix, ldouble_ext>(
             numeric_data, categ_data,
             Xc, Xc_ind, Xc_indptr,
             nrows, nthreads,
@@ -728,8 +728,9 @@ void traverse_tree_sim(WorkerForSimilarity   &workspace,
                     else
                         divide_subset_split(workspace.ix_arr.data(),
                                             prediction_data.categ_data + prediction_data.nrows * trees[curr_tree].col_num,
-                                            workspace.st, workspace.end, trees[curr_tree].cat_split.data(),
-                                            (int) trees[curr_tree].cat_split.size(),
+                                            workspace.st, workspace.end,
+                                            trees[curr_tree].cat_split.data(), cat_split_absent_bits(trees[curr_tree]),
+                                            trees[curr_tree].ncat_split,
                                             model_outputs.missing_action, model_outputs.new_cat_action,
                                             (bool)(trees[curr_tree].pct_tree_left < .5), st_NA, end_NA, split_ix);
                     break;
@@ -0,0 +1,363 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD International Conference on Knowledge Discovery & Data Mining. 2018.
+*
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2022, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*  Double-double floating point type, which represents a number as the unevaluated sum of two doubles
+    ('hi' + 'lo', with |lo| <= ulp(hi)/2), giving around 106 bits of mantissa using only operations on
+    regular doubles. It is meant to be used as 'ldouble_safe' in platforms in which 'long double' is not
+    wider than 'double' (e.g. MSVC) or in which it is a slow software-emulated type, by compiling with
+    'USE_DOUBLE_DOUBLE'.
+
+    Additions and subtractions are calculated through error-free transformations ('two_sum'), and
+    multiplications use FMA for the exact products. The math functions that are applied to extended-
+    precision values in the calculations of gains and statistics ('std::sqrt', 'std::log', 'std::exp',
+    'std::fma', 'std::fmax', 'std::fmin', 'std::fabs') have overloads for this type which keep the full
+    precision, with 'sqrt' and 'log' obtained through one Newton step from the 'double' result, and
+    'exp' through argument reduction plus a Taylor series. Other functions are calculated on the leading
+    component after an implicit conversion to 'double'.
+
+    Operations that overflow or involve infinities or NaNs produce results only in the leading component.
+
+    The operations are scalar and branch on non-finite values, so they do not get vectorized. Running
+    sums that are kept in independent lanes (e.g. the moments for kurtosis) can still overlap their
+    operations, but are several times slower than with x87 'long double'.
+
+    Note that these operations are exact only under strict IEEE754 semantics - they will not work
+    correctly if compiled with flags such as '-ffast-math', and must not be used inside functions with
+    attribute 'optimize("Ofast")'.
+
+    Reference:
+    Bailey, David H. "QD (C++/Fortran-90 double-double and quad-double package)." */
+#ifndef DOUBLE_DOUBLE_HPP
+#define DOUBLE_DOUBLE_HPP
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+struct DoubleDouble
+{
+    double hi;
+    double lo;
+
+    DoubleDouble() = default;
+    DoubleDouble(double x) : hi(x), lo(0.) {}
+    DoubleDouble(double hi, double lo) : hi(hi), lo(lo) {}
+    template <class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    DoubleDouble(T x)
+    {
+        this->hi = (double)x;
+        if (std::fabs(this->hi) < 9007199254740992.) /* 2^53 */
+            this->lo = 0.;
+        else
+            this->lo = (x >= (T)this->hi)? (double)(x - (T)this->hi) : -(double)((T)this->hi - x);
+    }
+
+    operator double() const {return this->hi + this->lo;}
+
+    static inline DoubleDouble quick_two_sum(double a, double b)
+    {
+        double s = a + b;
+        return DoubleDouble(s, b - (s - a));
+    }
+
+    static inline DoubleDouble two_sum(double a, double b)
+    {
+        double s = a + b;
+        double bb = s - a;
+        return DoubleDouble(s, (a - (s - bb)) + (b - bb));
+    }
+
+    static inline DoubleDouble two_prod(double a, double b)
+    {
+        double p = a * b;
+        return DoubleDouble(p, std::fma(a, b, -p));
+    }
+
+    static inline DoubleDouble add(const DoubleDouble &a, const DoubleDouble &b)
+    {
+        DoubleDouble s = two_sum(a.hi, b.hi);
+        if (unlikely(!std::isfinite(s.hi))) return DoubleDouble(s.hi);
+        DoubleDouble t = two_sum(a.lo, b.lo);
+        s.lo += t.hi;
+        s = quick_two_sum(s.hi, s.lo);
+        s.lo += t.lo;
+        return quick_two_sum(s.hi, s.lo);
+    }
+
+    static inline DoubleDouble add(const DoubleDouble &a, double b)
+    {
+        DoubleDouble s = two_sum(a.hi, b);
+        if (unlikely(!std::isfinite(s.hi))) return DoubleDouble(s.hi);
+        s.lo += a.lo;
+        return quick_two_sum(s.hi, s.lo);
+    }
+
+    static inline DoubleDouble mul(const DoubleDouble &a, const DoubleDouble &b)
+    {
+        DoubleDouble p = two_prod(a.hi, b.hi);
+        if (unlikely(!std::isfinite(p.hi))) return DoubleDouble(p.hi);
+        p.lo += a.hi * b.lo + a.lo * b.hi;
+        return quick_two_sum(p.hi, p.lo);
+    }
+
+    static inline DoubleDouble mul(const DoubleDouble &a, double b)
+    {
+        DoubleDouble p = two_prod(a.hi, b);
+        if (unlikely(!std::isfinite(p.hi))) return DoubleDouble(p.hi);
+        p.lo = std::fma(a.lo, b, p.lo);
+        return quick_two_sum(p.hi, p.lo);
+    }
+
+    static inline DoubleDouble div(const DoubleDouble &a, double b)
+    {
+        double q1 = a.hi / b;
+        if (unlikely(std::isinf(q1) || std::isnan(q1) || q1 == 0)) return DoubleDouble(q1);
+        DoubleDouble p = two_prod(q1, b);
+        double q2 = (((a.hi - p.hi) - p.lo) + a.lo) / b;
+        return quick_two_sum(q1, q2);
+    }
+
+    static inline DoubleDouble mul_pwr2(const DoubleDouble &a, double b)
+    {
+        return DoubleDouble(a.hi * b, a.lo * b);
+    }
+
+    static inline DoubleDouble div(const DoubleDouble &a, const DoubleDouble &b)
+    {
+        if (b.lo == 0) return div(a, b.hi);
+        double q1 = a.hi / b.hi;
+        if (unlikely(std::isinf(q1) || std::isnan(q1) || q1 == 0)) return DoubleDouble(q1);
+        DoubleDouble r = mul(b, q1);
+        DoubleDouble s = two_sum(a.hi, -r.hi);
+        s.lo -= r.lo;
+        s.lo += a.lo;
+        double q2 = (s.hi + s.lo) / b.hi;
+        return quick_two_sum(q1, q2);
+    }
+
+    static inline DoubleDouble sqrt(const DoubleDouble &a)
+    {
+        if (a.hi <= 0 || unlikely(std::isinf(a.hi) || std::isnan(a.hi))) return DoubleDouble(std::sqrt(a.hi));
+        double x = 1. / std::sqrt(a.hi);
+        double ax = a.hi * x;
+        return two_sum(ax, add(a, -two_prod(ax, ax)).hi * (x * 0.5));
+    }
+
+    /* exp(a) = 2^m * exp(r)^512, with 'r' small enough for a few terms of the series to suffice */
+    static inline DoubleDouble exp(const DoubleDouble &a)
+    {
+        if (a.hi <= -709.) return DoubleDouble(0.);
+        if (a.hi >= 709.) return DoubleDouble(HUGE_VAL);
+        if (a.hi == 0) return DoubleDouble(1.);
+        if (unlikely(std::isnan(a.hi))) return DoubleDouble(a.hi);
+
+        const DoubleDouble log2(6.931471805599452862e-01, 2.319046813846299558e-17);
+        const double inv_k = 1. / 512.;
+        const double eps = 4.93038065763132e-32; /* 2^-104 */
+        double m = std::floor(a.hi / log2.hi + 0.5);
+        DoubleDouble r = mul_pwr2(add(a, -mul(log2, m)), inv_k);
+        DoubleDouble p = mul(r, r);
+        DoubleDouble s = add(r, mul_pwr2(p, 0.5));
+        DoubleDouble t;
+        double fact = 2.;
+        for (int i = 3; i <= 9; i++)
+        {
+            p = mul(p, r);
+            fact *= (double)i;
+            t = div(p, fact);
+            s = add(s, t);
+            if (std::fabs(t.hi) <= inv_k * eps) break;
+        }
+
+        /* 's' is exp(r) - 1, which squared is exp(2r) - 1 = 2s + s^2 */
+        for (int i = 0; i < 9; i++)
+            s = add(mul_pwr2(s, 2.), mul(s, s));
+        s = add(s, 1.);
+        return DoubleDouble(std::ldexp(s.hi, (int)m), std::ldexp(s.lo, (int)m));
+    }
+
+    /* Newton step for f(x) = exp(x) - a, starting from the 'double' logarithm */
+    static inline DoubleDouble log(const DoubleDouble &a)
+    {
+        if (a.hi == 1 && a.lo == 0) return DoubleDouble(0.);
+        if (a.hi <= 0 || unlikely(std::isinf(a.hi) || std::isnan(a.hi))) return DoubleDouble(std::log(a.hi));
+        DoubleDouble x = std::log(a.hi);
+        return add(x, add(mul(a, exp(-x)), -1.));
+    }
+
+    DoubleDouble operator-() const {return DoubleDouble(-this->hi, -this->lo);}
+    DoubleDouble& operator+=(const DoubleDouble &other) {*this = add(*this, other); return *this;}
+    DoubleDouble& operator-=(const DoubleDouble &other) {*this = add(*this, -other); return *this;}
+    DoubleDouble& operator*=(const DoubleDouble &other) {*this = mul(*this, other); return *this;}
+    DoubleDouble& operator/=(const DoubleDouble &other) {*this = div(*this, other); return *this;}
+    DoubleDouble& operator+=(double other) {*this = add(*this, other); return *this;}
+    DoubleDouble& operator-=(double other) {*this = add(*this, -other); return *this;}
+    DoubleDouble& operator*=(double other) {*this = mul(*this, other); return *this;}
+    DoubleDouble& operator/=(double other) {*this = div(*this, other); return *this;}
+};
+
+/* The mixed-type operators are templated so that they take precedence over
+   the built-in operators that would convert the double-double to 'double' */
+#define dd_arithmetic_type typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0
+
+static inline DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b) {return DoubleDouble::add(a, b);}
+static inline DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b) {return DoubleDouble::add(a, -b);}
+static inline DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b) {return DoubleDouble::mul(a, b);}
+static inline DoubleDouble operator/(const DoubleDouble &a, const DoubleDouble &b) {return DoubleDouble::div(a, b);}
+/* Integers beyond 2^53 need both components, other numbers can use the cheaper operations with 'double' */
+#define dd_mixed_op(op, a, b) ((b).lo == 0)? DoubleDouble::op(a, (b).hi) : DoubleDouble::op(a, b)
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator+(const DoubleDouble &a, T b) {DoubleDouble bb(b); return dd_mixed_op(add, a, bb);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator+(T a, const DoubleDouble &b) {DoubleDouble aa(a); return dd_mixed_op(add, b, aa);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator-(const DoubleDouble &a, T b) {DoubleDouble bb = -DoubleDouble(b); return dd_mixed_op(add, a, bb);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator-(T a, const DoubleDouble &b) {DoubleDouble aa(a); return dd_mixed_op(add, -b, aa);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator*(const DoubleDouble &a, T b) {DoubleDouble bb(b); return dd_mixed_op(mul, a, bb);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator*(T a, const DoubleDouble &b) {DoubleDouble aa(a); return dd_mixed_op(mul, b, aa);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator/(const DoubleDouble &a, T b) {DoubleDouble bb(b); return dd_mixed_op(div, a, bb);}
+template <class T, dd_arithmetic_type>
+static inline DoubleDouble operator/(T a, const DoubleDouble &b) {return DoubleDouble::div(DoubleDouble(a), b);}
+#undef dd_mixed_op
+
+static inline bool operator==(const DoubleDouble &a, const DoubleDouble &b) {return a.hi == b.hi && a.lo == b.lo;}
+static inline bool operator!=(const DoubleDouble &a, const DoubleDouble &b) {return !(a == b);}
+static inline bool operator<(const DoubleDouble &a, const DoubleDouble &b) {return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);}
+static inline bool operator>(const DoubleDouble &a, const DoubleDouble &b) {return b < a;}
+static inline bool operator<=(const DoubleDouble &a, const DoubleDouble &b) {return a.hi < b.hi || (a.hi == b.hi && a.lo <= b.lo);}
+static inline bool operator>=(const DoubleDouble &a, const DoubleDouble &b) {return b <= a;}
+template <class T, dd_arithmetic_type>
+static inline bool operator==(const DoubleDouble &a, T b) {return a == DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator==(T a, const DoubleDouble &b) {return DoubleDouble(a) == b;}
+template <class T, dd_arithmetic_type>
+static inline bool operator!=(const DoubleDouble &a, T b) {return a != DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator!=(T a, const DoubleDouble &b) {return DoubleDouble(a) != b;}
+template <class T, dd_arithmetic_type>
+static inline bool operator<(const DoubleDouble &a, T b) {return a < DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator<(T a, const DoubleDouble &b) {return DoubleDouble(a) < b;}
+template <class T, dd_arithmetic_type>
+static inline bool operator>(const DoubleDouble &a, T b) {return a > DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator>(T a, const DoubleDouble &b) {return DoubleDouble(a) > b;}
+template <class T, dd_arithmetic_type>
+static inline bool operator<=(const DoubleDouble &a, T b) {return a <= DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator<=(T a, const DoubleDouble &b) {return DoubleDouble(a) <= b;}
+template <class T, dd_arithmetic_type>
+static inline bool operator>=(const DoubleDouble &a, T b) {return a >= DoubleDouble(b);}
+template <class T, dd_arithmetic_type>
+static inline bool operator>=(T a, const DoubleDouble &b) {return DoubleDouble(a) >= b;}
+
+#undef dd_arithmetic_type
+
+/* These are declared in namespace 'std' so that the templated code, which calls the functions from 'std'
+   for all the types that can be used as 'ldouble_safe', picks them instead of converting to 'double' */
+namespace std {
+inline DoubleDouble sqrt(const DoubleDouble &a) {return DoubleDouble::sqrt(a);}
+inline DoubleDouble exp(const DoubleDouble &a) {return DoubleDouble::exp(a);}
+inline DoubleDouble log(const DoubleDouble &a) {return DoubleDouble::log(a);}
+inline DoubleDouble fabs(const DoubleDouble &a) {return (a.hi < 0)? -a : a;}
+inline DoubleDouble fma(const DoubleDouble &a, const DoubleDouble &b, const DoubleDouble &c)
+{
+    return DoubleDouble::add(DoubleDouble::mul(a, b), c);
+}
+inline DoubleDouble fma(double a, double b, const DoubleDouble &c)
+{
+    return DoubleDouble::add(c, DoubleDouble::two_prod(a, b));
+}
+inline DoubleDouble fmax(const DoubleDouble &a, const DoubleDouble &b)
+{
+    if (std::isnan(a.hi)) return b;
+    if (std::isnan(b.hi)) return a;
+    return (a < b)? b : a;
+}
+inline DoubleDouble fmin(const DoubleDouble &a, const DoubleDouble &b)
+{
+    if (std::isnan(a.hi)) return b;
+    if (std::isnan(b.hi)) return a;
+    return (b < a)? b : a;
+}
+inline DoubleDouble fmax(const DoubleDouble &a, double b) {return fmax(a, DoubleDouble(b));}
+inline DoubleDouble fmax(double a, const DoubleDouble &b) {return fmax(DoubleDouble(a), b);}
+inline DoubleDouble fmin(const DoubleDouble &a, double b) {return fmin(a, DoubleDouble(b));}
+inline DoubleDouble fmin(double a, const DoubleDouble &b) {return fmin(DoubleDouble(a), b);}
+
+template <>
+class numeric_limits<DoubleDouble> : public numeric_limits<double>
+{
+public:
+    static DoubleDouble min() noexcept {return numeric_limits<double>::min();}
+    static DoubleDouble max() noexcept {return numeric_limits<double>::max();}
+    static DoubleDouble lowest() noexcept {return numeric_limits<double>::lowest();}
+    static DoubleDouble infinity() noexcept {return numeric_limits<double>::infinity();}
+    static DoubleDouble quiet_NaN() noexcept {return numeric_limits<double>::quiet_NaN();}
+};
+}
+
+#endif /* DOUBLE_DOUBLE_HPP */
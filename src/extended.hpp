@@ -81,8 +81,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
     if (impute_nodes != NULL)
     {
         if (input_data.Xc_indptr != NULL)
-            std::sort(workspace.ix_arr.begin() + workspace.st,
-                      workspace.ix_arr.begin() + workspace.end + 1);
+            sort_ix_arr(workspace.ix_arr.data(), workspace.st, workspace.end);
         build_impute_node<decltype(input_data), decltype(workspace), ldouble_safe>(
                           impute_nodes->back(), workspace,
                           input_data, model_params,
@@ -104,7 +103,7 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
 
     /* for sparse matrices, need to sort the indices */
     if (input_data.Xc_indptr != NULL && impute_nodes == NULL)
-        std::sort(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1);
+        sort_ix_arr(workspace.ix_arr.data(), workspace.st, workspace.end);
 
     /* pick column to split according to criteria */
     workspace.prob_split_type = workspace.rbin(workspace.rnd_generator);
@@ -586,7 +585,8 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
 
     /* divide */
     workspace.split_ix = divide_subset_split(workspace.ix_arr.data(), workspace.comb_val.data(),
-                                             workspace.st, workspace.end, hplanes.back().split_point);
+                                             workspace.st, workspace.end, hplanes.back().split_point,
+                                             workspace.buffer_ix.data());
 
     /* set as non-terminal */
     hplanes.back().score = -1;
@@ -784,21 +784,16 @@ void split_hplane_recursive(std::vector<IsoHPlane>   &hplanes,
 
         hplanes.back().remainder = (!workspace.weights_arr.empty())?
                                    sum_weight : ((!workspace.weights_map.empty())?
-                                                 sum_weight : ((double)(workspace.end - workspace.st + 1))
+                                                 sum_weight : ((ldouble_safe)(workspace.end - workspace.st + 1))
                                                  );
 
         /* for distance, assume also the elements keep being split */
         if (model_params.calc_dist)
             add_remainder_separation_steps<InputData, WorkerMemory, ldouble_safe>(workspace, input_data, sum_weight);
 
-        /* add this depth right away if requested */
-        if (!workspace.row_depths.empty())
-            for (size_t row = workspace.st; row <= workspace.end; row++)
-                workspace.row_depths[workspace.ix_arr[row]] += hplanes.back().score;
-
-        /* add imputations from node if requested */
-        if (model_params.impute_at_fit)
-            add_from_impute_node(impute_nodes->back(), workspace, input_data);
+        /* add this depth and the imputations from this node right away if requested */
+        if (model_params.calc_depth || model_params.impute_at_fit)
+            add_terminal_to_row_sums(workspace, input_data, model_params, impute_nodes, hplanes.back().score, false);
     }
 }
 
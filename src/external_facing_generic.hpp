@@ -61,6 +61,29 @@
 *     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 ISOTREE_EXPORTED
+int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, int nthreads, size_t max_memory);
+ISOTREE_EXPORTED
 int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
                 int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -106,6 +129,54 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
              uint64_t random_seed, bool use_long_double);
 ISOTREE_EXPORTED
+int add_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
+              real_t numeric_data[],  size_t ncols_numeric,
+              int    categ_data[],    size_t ncols_categ,    int ncat[],
+              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+              size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+              real_t sample_weights[], size_t nrows,
+              size_t max_depth,     size_t ncols_per_tree,
+              bool   limit_depth,   bool penalize_range, bool standardize_data,
+              bool   fast_bratio,
+              real_t col_weights[], bool weigh_by_kurt,
+              double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+              double prob_pick_by_full_gain, double prob_pick_by_dens,
+              double prob_pick_col_by_range, double prob_pick_col_by_var,
+              double prob_pick_col_by_kurt,
+              double min_gain, MissingAction missing_action,
+              CategSplit cat_split_type, NewCategAction new_cat_action,
+              UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+              bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+              TreesIndexer *indexer,
+              real_t ref_numeric_data[], int ref_categ_data[],
+              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+              uint64_t random_seed, bool use_long_double, int nthreads);
+ISOTREE_EXPORTED
+int replace_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t tree_num,
+                 real_t numeric_data[],  size_t ncols_numeric,
+                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                 real_t sample_weights[], size_t nrows,
+                 size_t max_depth,     size_t ncols_per_tree,
+                 bool   limit_depth,   bool penalize_range, bool standardize_data,
+                 bool   fast_bratio,
+                 real_t col_weights[], bool weigh_by_kurt,
+                 double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                 double prob_pick_by_full_gain, double prob_pick_by_dens,
+                 double prob_pick_col_by_range, double prob_pick_col_by_var,
+                 double prob_pick_col_by_kurt,
+                 double min_gain, MissingAction missing_action,
+                 CategSplit cat_split_type, NewCategAction new_cat_action,
+                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                 TreesIndexer *indexer,
+                 real_t ref_numeric_data[], int ref_categ_data[],
+                 bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+                 real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+                 uint64_t random_seed, bool use_long_double);
+ISOTREE_EXPORTED
 void predict_iforest(real_t numeric_data[], int categ_data[],
                      bool is_col_major, size_t ncols_numeric, size_t ncols_categ,
                      real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
@@ -405,6 +476,46 @@ ISOTREE_EXPORTED
 void incremental_serialize_Imputer(const Imputer &model, std::string &old_bytes);
 ISOTREE_EXPORTED
 void incremental_serialize_Indexer(const TreesIndexer &model, std::string &old_bytes);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const std::string &in);
 
 ISOTREE_EXPORTED
 void set_reference_points(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, TreesIndexer *indexer,
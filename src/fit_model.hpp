@@ -505,9 +505,9 @@
 *       a given column (minus 2). For averaged gain, the best split is always to put the second most-frequent
 *       category in a separate branch, so not evaluating all  permutations (passing 'false') will make it
 *       possible to select other splits that respect the sorted frequency order.
-*       The total number of combinations must be a number that can fit into a 'size_t' variable - for x64-64
-*       systems, this means no column can have more than 20 different categories if using 'all_perm=true',
-*       but note that this is not checked within the function.
+*       Permutations are only evaluated in tree nodes in which at most 'MAX_CATEG_ALL_PERM' categories are present
+*       (16 by default, can be changed at compile time) - nodes with more categories will use the sorted grouping,
+*       and a warning will be printed when fitting to data in which some column has more categories than that.
 *       Ignored when not using categorical variables or not doing splits by pooled gain or using 'ndim>1'.
 * - coef_by_prop
 *       In the extended model, whether to sort the randomly-generated coefficients for categories
@@ -552,7 +552,9 @@
 *       be sensitive to a difference of 10^-100), but will make the calculations slower, the more so in
 *       platforms in which 'long double' is a software-emulated type (e.g. Power8 platforms).
 *       Note that some platforms (most notably windows with the msvc compiler) do not make any difference
-*       between 'double' and 'long double'.
+*       between 'double' and 'long double'. If the library is compiled with 'USE_DOUBLE_DOUBLE', will use
+*       instead a double-double type (sum of two doubles), which provides extended precision also in such
+*       platforms, and is faster than software-emulated 'long double', but slower than x87 'long double'.
 * - nthreads
 *       Number of parallel threads to use. Note that, the more threads, the more memory will be
 *       allocated, even if the thread does not end up being used.
@@ -562,6 +564,15 @@
 *       in only a very modest speed up (e.g. 1.5x faster with 4x more threads),
 *       even if all threads look fully utilized.
 *       Ignored when not building with OpenMP support.
+* - max_memory
+*       Limit on the memory (in bytes) that the procedure is allowed to take, as estimated
+*       by function 'estimate_fit_memory' (this includes the model objects being produced,
+*       but not the input data nor the arrays passed as outputs). If the estimate exceeds
+*       the limit, will first avoid making copies of the rows sampled for each tree, and then
+*       reduce the number of threads to use. If it cannot stay under the limit even with a
+*       single thread, will throw an exception before allocating anything.
+*       Note that the estimate is only approximate, so this should leave some margin.
+*       Pass zero for no limit.
 * 
 * Returns
 * =======
@@ -594,7 +605,7 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, bool use_long_double, int nthreads)
+                uint64_t random_seed, bool use_long_double, int nthreads, size_t max_memory)
 {
     if (use_long_double && !has_long_double()) {
         use_long_double = false;
@@ -625,11 +636,12 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             cat_split_type, new_cat_action,
             all_perm, imputer, min_imp_obs,
             depth_imp, weigh_imp_rows, impute_at_fit,
-            random_seed, nthreads
+            random_seed, nthreads, (size_t)0, max_memory,
+            (size_t)0, NULL, NULL
         );
     #ifndef NO_LONG_DOUBLE
     else
-        return fit_iforest_internal<real_t, sparse_ix, long double>(
+        return fit_iforest_internal<real_t, sparse_ix, ldouble_ext>(
             model_outputs, model_outputs_ext,
             numeric_data,  ncols_numeric,
             categ_data,    ncols_categ,    ncat,
@@ -651,11 +663,66 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             cat_split_type, new_cat_action,
             all_perm, imputer, min_imp_obs,
             depth_imp, weigh_imp_rows, impute_at_fit,
-            random_seed, nthreads
+            random_seed, nthreads, (size_t)0, max_memory,
+            (size_t)0, NULL, NULL
         );
     #endif
 }
 
+/* Same as 'fit_iforest' for dense data in the types used by the C++ class, but fitting the
+   trees in rounds of 'ntrees_per_round', after each of which 'continue_fit' gets called with
+   'fit_monitor' and the number of trees fitted so far (the first ones in the model object).
+   If it returns 'false', the model is left with only those trees. Everything else is set up
+   once for the full 'ntrees', so the trees are the same as what 'fit_iforest' would produce. */
+int fit_iforest_in_rounds(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          double numeric_data[],  size_t ncols_numeric,
+                          int    categ_data[],    size_t ncols_categ,    int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          double sample_weights[], bool with_replacement, bool weight_as_sample,
+                          size_t nrows, size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          double col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, int nthreads, size_t max_memory,
+                          size_t ntrees_per_round, bool (*continue_fit)(void *fit_monitor, size_t ntrees_fitted),
+                          void *fit_monitor)
+{
+    return fit_iforest_internal<double, int, double>(
+        model_outputs, model_outputs_ext,
+        numeric_data,  ncols_numeric,
+        categ_data,    ncols_categ,    ncat,
+        (double*)NULL, (int*)NULL, (int*)NULL,
+        ndim, ntry, coef_type, coef_by_prop,
+        sample_weights, with_replacement, weight_as_sample,
+        nrows, sample_size, ntrees,
+        max_depth, ncols_per_tree,
+        limit_depth, penalize_range, standardize_data,
+        scoring_metric, fast_bratio,
+        false, (double*)NULL,
+        (double*)NULL, false,
+        col_weights, weigh_by_kurt,
+        prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+        prob_pick_by_full_gain, prob_pick_by_dens,
+        prob_pick_col_by_range, prob_pick_col_by_var,
+        prob_pick_col_by_kurt,
+        min_gain, missing_action,
+        cat_split_type, new_cat_action,
+        all_perm, imputer, min_imp_obs,
+        depth_imp, weigh_imp_rows, false,
+        random_seed, nthreads, (size_t)0, max_memory,
+        ntrees_per_round, continue_fit, fit_monitor
+    );
+}
+
 template <class real_t, class sparse_ix, class ldouble_safe>
 int fit_iforest_internal(
                 IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
@@ -679,7 +746,9 @@ int fit_iforest_internal(
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, int nthreads)
+                uint64_t random_seed, int nthreads, size_t tree_block_size, size_t max_memory,
+                size_t ntrees_per_round, bool (*continue_fit)(void *fit_monitor, size_t ntrees_fitted),
+                void *fit_monitor)
 {
     if (
         prob_pick_by_gain_avg  < 0 || prob_pick_by_gain_pl  < 0 ||
@@ -711,6 +780,8 @@ int fit_iforest_internal(
         if (impute_at_fit)
             throw std::runtime_error("Cannot impute at fit time when sampling with replacement.\n");
     }
+    if (ntrees_per_round && ntrees_per_round < ntrees && (tmat != NULL || output_depths != NULL || impute_at_fit))
+        throw std::runtime_error("Cannot produce outputs at fit time when fitting trees in rounds.\n");
     if (sample_size != 0 && sample_size < nrows) {
         if (output_depths != NULL)
             throw std::runtime_error("Cannot produce outlier scores at fit time when using sub-sampling.\n");
@@ -731,6 +802,10 @@ int fit_iforest_internal(
     for (size_t col = 0; col < ncols_categ; col++)
         max_categ = (ncat[col] > max_categ)? ncat[col] : max_categ;
 
+    if (all_perm && model_outputs != NULL && prob_pick_by_gain_pl &&
+        cat_split_type == SubSet && (size_t)max_categ > MAX_CATEG_ALL_PERM)
+        print_errmsg("Passed 'all_perm=true', but nodes with more than 'MAX_CATEG_ALL_PERM' categories present will use the sorted grouping.\n");
+
     bool calc_dist = tmat != NULL;
 
     if (sample_size == 0)
@@ -749,10 +824,12 @@ int fit_iforest_internal(
                                 weight_as_sample, col_weights,
                                 Xc, Xc_ind, Xc_indptr,
                                 0, 0, std::vector<double>(),
+                                std::vector<double>(), std::vector<size_t>(),
                                 std::vector<char>(), 0, NULL,
                                 (double*)NULL, (double*)NULL, (int*)NULL, std::vector<double>(),
                                 std::vector<double>(), std::vector<double>(),
-                                std::vector<size_t>(), std::vector<size_t>()};
+                                std::vector<size_t>(), std::vector<size_t>(),
+                                tree_block_size};
     ModelParams model_params = {with_replacement, sample_size, ntrees, ncols_per_tree,
                                 limit_depth? log2ceil(sample_size) : max_depth? max_depth : (sample_size - 1),
                                 penalize_range, standardize_data, random_seed, weigh_by_kurt,
@@ -764,7 +841,13 @@ int fit_iforest_internal(
                                 scoring_metric, fast_bratio, all_perm,
                                 (model_outputs != NULL)? 0 : ndim, ntry,
                                 coef_type, coef_by_prop, calc_dist, (bool)(output_depths != NULL), impute_at_fit,
-                                depth_imp, weigh_imp_rows, min_imp_obs};
+                                depth_imp, weigh_imp_rows, min_imp_obs, false};
+
+    /* if there is a limit on memory usage, might need to use fewer threads */
+    if (max_memory)
+        adjust_to_memory_limit(input_data, model_params, imputer != NULL,
+                               (Xc_indptr != NULL)? (size_t)Xc_indptr[ncols_numeric] : (size_t)0,
+                               sizeof(ldouble_safe), nthreads, max_memory);
 
     /* if calculating full gain, need to produce copies of the data in row-major order */
     if (prob_pick_by_full_gain)
@@ -777,11 +860,15 @@ int fit_iforest_internal(
                                  input_data.Xr, input_data.Xr_ind, input_data.Xr_indptr);
     }
 
-    /* if using weights as sampling probability, build a binary tree for faster sampling */
+    /* if using weights as sampling probability, build an alias table or a binary tree for faster sampling */
     if (input_data.weight_as_sample && input_data.sample_weights != NULL)
     {
-        build_btree_sampler(input_data.btree_weights_init, input_data.sample_weights,
-                            input_data.nrows, input_data.log2_n, input_data.btree_offset);
+        if (model_params.with_replacement)
+            build_alias_sampler(input_data.alias_prob, input_data.alias_ix,
+                                input_data.sample_weights, input_data.nrows);
+        else if (prefer_btree_sampler(model_params.sample_size, input_data.nrows))
+            build_btree_sampler(input_data.btree_weights_init, input_data.sample_weights,
+                                input_data.nrows, input_data.log2_n, input_data.btree_offset);
     }
 
     /* same for column weights */
@@ -805,7 +892,7 @@ int fit_iforest_internal(
             if (model_params.weigh_by_kurt && model_params.sample_size == input_data.nrows && !model_params.with_replacement)
             {
                 RNG_engine rnd_generator(random_seed);
-                std::vector<double> kurt_weights = calc_kurtosis_all_data<InputData<real_t, sparse_ix>, ldouble_safe>(input_data, model_params, rnd_generator);
+                std::vector<double> kurt_weights = calc_kurtosis_all_data<InputData<real_t, sparse_ix>, ldouble_safe>(input_data, model_params, rnd_generator, nthreads);
                 if (col_weights != NULL)
                 {
                     for (size_t col = 0; col < input_data.ncols_tot; col++)
@@ -995,6 +1082,22 @@ int fit_iforest_internal(
         std::vector<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> worker_memory(1);
     #endif
 
+    /* depths and imputations are added by all threads to the same arrays */
+    RowStripes row_stripes;
+    if (model_params.calc_depth || model_params.impute_at_fit)
+    {
+        row_stripes.initialize(nrows, nthreads);
+        if (output_depths != NULL)
+            std::fill(output_depths, output_depths + nrows, 0.);
+        for (auto &w : worker_memory)
+        {
+            w.row_stripes = &row_stripes;
+            w.row_depths  = output_depths;
+            w.impute_vec  = &impute_vec;
+            w.impute_map  = &impute_map;
+        }
+    }
+
     /* Global variable that determines if the procedure receives a stop signal */
     SignalSwitcher ss = SignalSwitcher();
 
@@ -1002,63 +1105,68 @@ int fit_iforest_internal(
     bool threw_exception = false;
     std::exception_ptr ex = NULL;
 
-    /* grow trees */
-    #pragma omp parallel for num_threads(nthreads) schedule(dynamic) shared(model_outputs, model_outputs_ext, worker_memory, input_data, model_params, threw_exception, ex)
-    for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
+    /* grow trees - when fitting in rounds, the remaining trees are left out if the
+       check after a round says to stop, but everything else is kept as it would be
+       for the full number of trees, so the trees are the same as without rounds */
+    if (!ntrees_per_round)
+        ntrees_per_round = ntrees;
+    size_t ntrees_fitted = 0;
+    while (ntrees_fitted < ntrees)
     {
-        if (interrupt_switch || threw_exception)
-            continue; /* Cannot break with OpenMP==2.0 (MSVC) */
+        size_t round_end = std::min(ntrees, ntrees_fitted + ntrees_per_round);
 
-        try
+        #pragma omp parallel for num_threads(nthreads) schedule(dynamic) shared(model_outputs, model_outputs_ext, worker_memory, input_data, model_params, threw_exception, ex, ntrees_fitted, round_end)
+        for (size_t_for tree = (decltype(tree))ntrees_fitted; tree < (decltype(tree))round_end; tree++)
         {
-            if (
-                model_params.impute_at_fit &&
-                input_data.n_missing &&
-                !worker_memory[omp_get_thread_num()].impute_vec.size() &&
-                !worker_memory[omp_get_thread_num()].impute_map.size()
-                )
-            {
-                #ifdef _OPENMP
-                if (nthreads > 1)
-                {
-                    worker_memory[omp_get_thread_num()].impute_vec = impute_vec;
-                    worker_memory[omp_get_thread_num()].impute_map = impute_map;
-                }
+            if (interrupt_switch || threw_exception)
+                continue; /* Cannot break with OpenMP==2.0 (MSVC) */
 
+            try
+            {
+                fit_itree<decltype(input_data), typename std::remove_pointer<decltype(worker_memory.data())>::type, ldouble_safe>(
+                          (model_outputs != NULL)? &model_outputs->trees[tree] : NULL,
+                          (model_outputs_ext != NULL)? &model_outputs_ext->hplanes[tree] : NULL,
+                          worker_memory[omp_get_thread_num()],
+                          input_data,
+                          model_params,
+                          (imputer != NULL)? &(imputer->imputer_tree[tree]) : NULL,
+                          tree);
+
+                if ((model_outputs != NULL))
+                    model_outputs->trees[tree].shrink_to_fit();
                 else
-                #endif
-                {
-                    worker_memory[0].impute_vec = std::move(impute_vec);
-                    worker_memory[0].impute_map = std::move(impute_map);
-                }
+                    model_outputs_ext->hplanes[tree].shrink_to_fit();
             }
 
-            fit_itree<decltype(input_data), typename std::remove_pointer<decltype(worker_memory.data())>::type, ldouble_safe>(
-                      (model_outputs != NULL)? &model_outputs->trees[tree] : NULL,
-                      (model_outputs_ext != NULL)? &model_outputs_ext->hplanes[tree] : NULL,
-                      worker_memory[omp_get_thread_num()],
-                      input_data,
-                      model_params,
-                      (imputer != NULL)? &(imputer->imputer_tree[tree]) : NULL,
-                      tree);
-
-            if ((model_outputs != NULL))
-                model_outputs->trees[tree].shrink_to_fit();
-            else
-                model_outputs_ext->hplanes[tree].shrink_to_fit();
-        }
-
-        catch (...)
-        {
-            #pragma omp critical
+            catch (...)
             {
-                if (!threw_exception)
+                #pragma omp critical
                 {
-                    threw_exception = true;
-                    ex = std::current_exception();
+                    if (!threw_exception)
+                    {
+                        threw_exception = true;
+                        ex = std::current_exception();
+                    }
                 }
             }
         }
+
+        ntrees_fitted = round_end;
+        if (interrupt_switch || threw_exception || ntrees_fitted == ntrees)
+            break;
+
+        if (!continue_fit(fit_monitor, ntrees_fitted))
+        {
+            if (model_outputs != NULL)
+                model_outputs->trees.resize(ntrees_fitted);
+            else
+                model_outputs_ext->hplanes.resize(ntrees_fitted);
+            if (imputer != NULL)
+                imputer->imputer_tree.resize(ntrees_fitted);
+            ntrees = ntrees_fitted;
+            model_params.ntrees = ntrees_fitted;
+            break;
+        }
     }
 
     /* check if the procedure got interrupted */
@@ -1091,40 +1199,23 @@ int fit_iforest_internal(
     if (interrupt_switch) return EXIT_FAILURE;
     #endif
 
-    /* same for depths */
+    /* depths were already summed up by the trees, now they need to be averaged */
     if (output_depths != NULL)
     {
-        #ifdef _OPENMP
-        if (nthreads > 1)
-        {
-            for (auto &w : worker_memory)
-            {
-                if (w.row_depths.size())
-                {
-                    #pragma omp parallel for schedule(static) num_threads(nthreads) shared(input_data, output_depths, w, worker_memory)
-                    for (size_t_for row = 0; row < (decltype(row))input_data.nrows; row++)
-                        output_depths[row] += w.row_depths[row];
-                }
-            }
-        }
-        else
-        #endif
-        {
-            std::copy(worker_memory[0].row_depths.begin(), worker_memory[0].row_depths.end(), output_depths);
-        }
-
         if (standardize_depth)
         {
             double depth_divisor = (double)ntrees * ((model_outputs != NULL)?
                                                      model_outputs->exp_avg_depth : model_outputs_ext->exp_avg_depth);
-            for (size_t row = 0; row < nrows; row++)
+            #pragma omp parallel for schedule(static) num_threads(nthreads) shared(output_depths, nrows, depth_divisor)
+            for (size_t_for row = 0; row < (decltype(row))nrows; row++)
                 output_depths[row] = std::exp2( - output_depths[row] / depth_divisor );
         }
 
         else
         {
             double ntrees_dbl = (double) ntrees;
-            for (size_t row = 0; row < nrows; row++)
+            #pragma omp parallel for schedule(static) num_threads(nthreads) shared(output_depths, nrows, ntrees_dbl)
+            for (size_t_for row = 0; row < (decltype(row))nrows; row++)
                 output_depths[row] /= ntrees_dbl;
         }
     }
@@ -1134,25 +1225,9 @@ int fit_iforest_internal(
     if (interrupt_switch) return EXIT_FAILURE;
     #endif
 
-    /* if imputing missing values, now need to reduce and write final values */
+    /* if imputing missing values, the sums are also complete, need to write final values */
     if (model_params.impute_at_fit)
-    {
-        #ifdef _OPENMP
-        if (nthreads > 1)
-        {
-            for (auto &w : worker_memory)
-                combine_tree_imputations(w, impute_vec, impute_map, input_data.has_missing, nthreads);
-        }
-
-        else
-        #endif
-        {
-            impute_vec = std::move(worker_memory[0].impute_vec);
-            impute_map = std::move(worker_memory[0].impute_map);
-        }
-
         apply_imputation_results(impute_vec, impute_map, *imputer, input_data, nthreads);
-    }
 
     check_interrupt_switch(ss);
     #if defined(DONT_THROW_ON_INTERRUPT)
@@ -1397,6 +1472,87 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
              uint64_t random_seed, bool use_long_double)
+{
+    return add_trees<real_t, sparse_ix>(
+        model_outputs, model_outputs_ext, (size_t)1,
+        numeric_data,  ncols_numeric,
+        categ_data,    ncols_categ,    ncat,
+        Xc, Xc_ind, Xc_indptr,
+        ndim, ntry, coef_type, coef_by_prop,
+        sample_weights, nrows,
+        max_depth,     ncols_per_tree,
+        limit_depth,   penalize_range, standardize_data,
+        fast_bratio,
+        col_weights, weigh_by_kurt,
+        prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+        prob_pick_by_full_gain, prob_pick_by_dens,
+        prob_pick_col_by_range, prob_pick_col_by_var,
+        prob_pick_col_by_kurt,
+        min_gain, missing_action,
+        cat_split_type, new_cat_action,
+        depth_imp, weigh_imp_rows,
+        all_perm, imputer, min_imp_obs,
+        indexer,
+        ref_numeric_data, ref_categ_data,
+        ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+        ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+        random_seed, use_long_double, 1
+    );
+}
+
+/* Add several trees to an already-fitted isolation forest model, fitting them in parallel
+* 
+* This produces the same trees as calling 'add_tree' 'ntrees' times in a row with the same
+* 'random_seed', but fits them with multiple threads, each one with its own working memory.
+* The imputer and indexer (including distances and reference points) are updated for the
+* new trees in the same parallel pass.
+* 
+* The new trees are only appended to the model (along with their imputation nodes and indexer
+* entries) once all of them have been fitted, so if an error or interrupt happens in the
+* middle, the model, imputer and indexer will be left as they were.
+* 
+* Parameters
+* ==========
+* - model_outputs, model_outputs_ext
+*       Same parameters as for 'add_tree' (see the documentation in there for details).
+* - ntrees
+*       Number of trees to add. Must be positive.
+* - All other parameters except for 'nthreads'
+*       Same as for 'add_tree' (see the documentation in there for details).
+* - nthreads
+*       Number of parallel threads to use. If passing a number larger than 'ntrees',
+*       will use 'ntrees' threads instead.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1), in which case the model will be left as it was.
+*/
+template <class real_t, class sparse_ix>
+int add_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
+              real_t numeric_data[],  size_t ncols_numeric,
+              int    categ_data[],    size_t ncols_categ,    int ncat[],
+              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+              size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+              real_t sample_weights[], size_t nrows,
+              size_t max_depth,     size_t ncols_per_tree,
+              bool   limit_depth,   bool penalize_range, bool standardize_data,
+              bool   fast_bratio,
+              real_t col_weights[], bool weigh_by_kurt,
+              double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+              double prob_pick_by_full_gain, double prob_pick_by_dens,
+              double prob_pick_col_by_range, double prob_pick_col_by_var,
+              double prob_pick_col_by_kurt,
+              double min_gain, MissingAction missing_action,
+              CategSplit cat_split_type, NewCategAction new_cat_action,
+              UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+              bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+              TreesIndexer *indexer,
+              real_t ref_numeric_data[], int ref_categ_data[],
+              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+              uint64_t random_seed, bool use_long_double, int nthreads)
 {
     if (use_long_double && !has_long_double()) {
         use_long_double = false;
@@ -1405,8 +1561,8 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
     #ifndef NO_LONG_DOUBLE
     if (likely(!use_long_double))
     #endif
-        return add_tree_internal<real_t, sparse_ix, double>(
-            model_outputs, model_outputs_ext,
+        return add_trees_internal<real_t, sparse_ix, double>(
+            model_outputs, model_outputs_ext, ntrees,
             numeric_data,  ncols_numeric,
             categ_data,    ncols_categ,    ncat,
             Xc, Xc_ind, Xc_indptr,
@@ -1428,12 +1584,12 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             ref_numeric_data, ref_categ_data,
             ref_is_col_major, ref_ld_numeric, ref_ld_categ,
             ref_Xc, ref_Xc_ind, ref_Xc_indptr,
-            random_seed
+            random_seed, nthreads
         );
     #ifndef NO_LONG_DOUBLE
     else
-        return add_tree_internal<real_t, sparse_ix, long double>(
-            model_outputs, model_outputs_ext,
+        return add_trees_internal<real_t, sparse_ix, ldouble_ext>(
+            model_outputs, model_outputs_ext, ntrees,
             numeric_data,  ncols_numeric,
             categ_data,    ncols_categ,    ncat,
             Xc, Xc_ind, Xc_indptr,
@@ -1455,14 +1611,14 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
             ref_numeric_data, ref_categ_data,
             ref_is_col_major, ref_ld_numeric, ref_ld_categ,
             ref_Xc, ref_Xc_ind, ref_Xc_indptr,
-            random_seed
+            random_seed, nthreads
         );
     #endif
 }
 
 template <class real_t, class sparse_ix, class ldouble_safe>
-int add_tree_internal(
-             IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+int add_trees_internal(
+             IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
              real_t numeric_data[],  size_t ncols_numeric,
              int    categ_data[],    size_t ncols_categ,    int ncat[],
              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
@@ -1484,7 +1640,7 @@ int add_tree_internal(
              real_t ref_numeric_data[], int ref_categ_data[],
              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
-             uint64_t random_seed)
+             uint64_t random_seed, int nthreads)
 {
     if (
         prob_pick_by_gain_avg  < 0  || prob_pick_by_gain_pl  < 0 ||
@@ -1506,13 +1662,17 @@ int add_tree_internal(
         if (ref_numeric_data == NULL && ref_categ_data == NULL && ref_Xc_indptr == NULL)
             throw std::runtime_error("'indexer' has reference points. Those points must be passed to index them in the new tree to add.\n");
     }
-
-    std::vector<ImputeNode> *impute_nodes = NULL;
+    if (ntrees == 0)
+        throw std::runtime_error("Must pass a positive 'ntrees'.\n");
 
     int max_categ = 0;
     for (size_t col = 0; col < ncols_categ; col++)
         max_categ = (ncat[col] > max_categ)? ncat[col] : max_categ;
 
+    if (all_perm && model_outputs != NULL && prob_pick_by_gain_pl &&
+        cat_split_type == SubSet && (size_t)max_categ > MAX_CATEG_ALL_PERM)
+        print_errmsg("Passed 'all_perm=true', but nodes with more than 'MAX_CATEG_ALL_PERM' categories present will use the sorted grouping.\n");
+
     if (model_outputs != NULL)
         ntry = std::min(ntry, ncols_numeric + ncols_categ);
 
@@ -1528,11 +1688,13 @@ int add_tree_internal(
                                 false, col_weights,
                                 Xc, Xc_ind, Xc_indptr,
                                 0, 0, std::vector<double>(),
+                                std::vector<double>(), std::vector<size_t>(),
                                 std::vector<char>(), 0, NULL,
                                 (double*)NULL, (double*)NULL, (int*)NULL, std::vector<double>(),
                                 std::vector<double>(), std::vector<double>(),
-                                std::vector<size_t>(), std::vector<size_t>()};
-    ModelParams model_params = {false, nrows, (size_t)1, ncols_per_tree,
+                                std::vector<size_t>(), std::vector<size_t>(),
+                                (size_t)0};
+    ModelParams model_params = {false, nrows, ntrees, ncols_per_tree,
                                 max_depth? max_depth : (nrows - 1),
                                 penalize_range, standardize_data, random_seed, weigh_by_kurt,
                                 prob_pick_by_gain_avg, prob_pick_by_gain_pl,
@@ -1543,7 +1705,8 @@ int add_tree_internal(
                                 (model_outputs != NULL)? model_outputs->scoring_metric : model_outputs_ext->scoring_metric,
                                 fast_bratio, all_perm,
                                 (model_outputs != NULL)? 0 : ndim, ntry,
-                                coef_type, coef_by_prop, false, false, false, depth_imp, weigh_imp_rows, min_imp_obs};
+                                coef_type, coef_by_prop, false, false, false, depth_imp, weigh_imp_rows, min_imp_obs,
+                                false};
 
     if (prob_pick_by_full_gain)
     {
@@ -1555,184 +1718,545 @@ int add_tree_internal(
                                  input_data.Xr, input_data.Xr_ind, input_data.Xr_indptr);
     }
 
-    std::unique_ptr<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> workspace(
-        new WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>()
-    );
+    /* the new trees get the same seeds as if they were added one at a time */
+    size_t last_tree = (model_outputs != NULL)? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
+    bool with_distances = indexer != NULL && !indexer->indices.front().node_distances.empty();
+    size_t n_ref = (indexer != NULL)? indexer->indices.front().reference_points.size() : (size_t)0;
+
+    /* the trees and their associated objects are built aside, and are only
+       moved into the model once all of them have been fitted */
+    std::vector<std::vector<IsoTree>> new_trees;
+    std::vector<std::vector<IsoHPlane>> new_hplanes;
+    std::vector<std::vector<ImputeNode>> new_impute_trees;
+    std::vector<SingleTreeIndex> new_indices;
+    if (model_outputs != NULL)
+        new_trees.resize(ntrees);
+    else
+        new_hplanes.resize(ntrees);
+    if (imputer != NULL)
+        new_impute_trees.resize(ntrees);
+    if (indexer != NULL)
+        new_indices.resize(ntrees);
+
+    /* initialize thread-private memory */
+    if ((size_t)nthreads > ntrees)
+        nthreads = (int)ntrees;
+    #ifdef _OPENMP
+        std::vector<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> worker_memory(nthreads);
+    #else
+        std::vector<WorkerMemory<ImputedData<sparse_ix, ldouble_safe>, ldouble_safe, real_t>> worker_memory(1);
+    #endif
+
+    SignalSwitcher ss = SignalSwitcher();
 
-    size_t last_tree;
-    bool added_tree = false;
-    try
+    bool threw_exception = false;
+    std::exception_ptr ex = NULL;
+
+    #pragma omp parallel for num_threads(nthreads) schedule(dynamic) shared(model_outputs, model_outputs_ext, worker_memory, input_data, model_params, new_trees, new_hplanes, new_impute_trees, new_indices, threw_exception, ex)
+    for (size_t_for tree = 0; tree < (decltype(tree))ntrees; tree++)
     {
-        if (model_outputs != NULL)
-        {
-            last_tree = model_outputs->trees.size();
-            model_outputs->trees.emplace_back();
-            added_tree = true;
-        }
+        if (interrupt_switch || threw_exception)
+            continue; /* Cannot break with OpenMP==2.0 (MSVC) */
 
-        else
+        try
         {
-            last_tree = model_outputs_ext->hplanes.size();
-            model_outputs_ext->hplanes.emplace_back();
-            added_tree = true;
-        }
+            fit_itree<decltype(input_data), typename std::remove_pointer<decltype(worker_memory.data())>::type, ldouble_safe>(
+                      (model_outputs != NULL)? &new_trees[tree] : NULL,
+                      (model_outputs_ext != NULL)? &new_hplanes[tree] : NULL,
+                      worker_memory[omp_get_thread_num()],
+                      input_data,
+                      model_params,
+                      (imputer != NULL)? &new_impute_trees[tree] : NULL,
+                      last_tree + tree);
 
-        if (imputer != NULL)
-        {
-            imputer->imputer_tree.emplace_back();
-            impute_nodes = &(imputer->imputer_tree.back());
-        }
+            if (model_outputs != NULL)
+                new_trees[tree].shrink_to_fit();
+            else
+                new_hplanes[tree].shrink_to_fit();
+            if (imputer != NULL)
+                new_impute_trees[tree].shrink_to_fit();
 
-        if (indexer != NULL)
-        {
-            indexer->indices.emplace_back();
-        }
+            if (indexer != NULL)
+            {
+                SingleTreeIndex &new_index = new_indices[tree];
+                if (model_outputs != NULL)
+                    build_terminal_node_mappings_single_tree(new_index.terminal_node_mappings,
+                                                             new_index.n_terminal,
+                                                             new_trees[tree]);
+                else
+                    build_terminal_node_mappings_single_tree(new_index.terminal_node_mappings,
+                                                             new_index.n_terminal,
+                                                             new_hplanes[tree]);
 
-        SignalSwitcher ss = SignalSwitcher();
-        check_interrupt_switch(ss);
+                if (with_distances)
+                {
+                    std::vector<size_t> temp;
+                    temp.reserve(new_index.n_terminal);
+                    new_index.node_distances.assign(calc_ncomb(new_index.n_terminal), 0.);
+                    new_index.node_distances.shrink_to_fit();
+                    if (model_outputs != NULL)
+                        build_dindex(temp, new_index.terminal_node_mappings, new_index.node_distances,
+                                     new_index.node_depths, new_index.n_terminal, new_trees[tree]);
+                    else
+                        build_dindex(temp, new_index.terminal_node_mappings, new_index.node_distances,
+                                     new_index.node_depths, new_index.n_terminal, new_hplanes[tree]);
+                }
 
-        fit_itree<decltype(input_data), typename std::remove_pointer<decltype(workspace.get())>::type, ldouble_safe>(
-                  (model_outputs != NULL)? &model_outputs->trees.back() : NULL,
-                  (model_outputs_ext != NULL)? &model_outputs_ext->hplanes.back() : NULL,
-                  *workspace,
-                  input_data,
-                  model_params,
-                  impute_nodes,
-                  last_tree);
+                if (n_ref)
+                {
+                    /* The reference points are passed through a model and an indexer that have
+                       only this tree, which are moved in and back out so as not to copy them. */
+                    std::vector<sparse_ix> terminal_indices(n_ref);
+                    std::unique_ptr<double[]> ignored(new double[n_ref]);
+                    TreesIndexer single_tree_indexer;
+                    single_tree_indexer.indices.push_back(std::move(new_index));
+                    if (model_outputs != NULL)
+                    {
+                        IsoForest single_tree_model;
+                        single_tree_model.new_cat_action = model_outputs->new_cat_action;
+                        single_tree_model.cat_split_type = model_outputs->cat_split_type;
+                        single_tree_model.missing_action = model_outputs->missing_action;
+                        single_tree_model.trees.push_back(std::move(new_trees[tree]));
+
+                        predict_iforest(ref_numeric_data, ref_categ_data,
+                                        ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+                                        ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+                                        (real_t*)NULL, (sparse_ix*)NULL, (sparse_ix*)NULL,
+                                        n_ref, 1, false,
+                                        &single_tree_model, (ExtIsoForest*)NULL,
+                                        ignored.get(), terminal_indices.data(),
+                                        (double*)NULL,
+                                        &single_tree_indexer);
+
+                        new_trees[tree] = std::move(single_tree_model.trees.front());
+                    }
 
-        check_interrupt_switch(ss);
+                    else
+                    {
+                        ExtIsoForest single_tree_model;
+                        single_tree_model.new_cat_action = model_outputs_ext->new_cat_action;
+                        single_tree_model.cat_split_type = model_outputs_ext->cat_split_type;
+                        single_tree_model.missing_action = model_outputs_ext->missing_action;
+                        single_tree_model.hplanes.push_back(std::move(new_hplanes[tree]));
+
+                        predict_iforest(ref_numeric_data, ref_categ_data,
+                                        ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+                                        ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+                                        (real_t*)NULL, (sparse_ix*)NULL, (sparse_ix*)NULL,
+                                        n_ref, 1, false,
+                                        (IsoForest*)NULL, &single_tree_model,
+                                        ignored.get(), terminal_indices.data(),
+                                        (double*)NULL,
+                                        &single_tree_indexer);
+
+                        new_hplanes[tree] = std::move(single_tree_model.hplanes.front());
+                    }
 
-        if (model_outputs != NULL) {
-            model_outputs->trees.back().shrink_to_fit();
-            model_outputs->has_range_penalty = model_outputs->has_range_penalty || penalize_range;
+                    new_index = std::move(single_tree_indexer.indices.front());
+                    ignored.reset();
+                    new_index.reference_points.assign(terminal_indices.begin(), terminal_indices.end());
+                    new_index.reference_points.shrink_to_fit();
+                    build_ref_node(new_index);
+                }
+            }
         }
-        else {
-            model_outputs_ext->hplanes.back().shrink_to_fit();
-            model_outputs_ext->has_range_penalty = model_outputs_ext->has_range_penalty || penalize_range;
+
+        catch (...)
+        {
+            #pragma omp critical
+            {
+                if (!threw_exception)
+                {
+                    threw_exception = true;
+                    ex = std::current_exception();
+                }
+            }
         }
+    }
 
-        if (imputer != NULL)
-            imputer->imputer_tree.back().shrink_to_fit();
+    check_interrupt_switch(ss);
+    #if defined(DONT_THROW_ON_INTERRUPT)
+    if (interrupt_switch) return EXIT_FAILURE;
+    #endif
+
+    if (threw_exception)
+        std::rethrow_exception(ex);
 
+    /* All the allocations are done before appending anything, and moving the
+       trees cannot throw, so either every object gets the new trees or none does.
+       The capacities grow geometrically in case this gets called one tree at a time. */
+    size_t new_size = last_tree + ntrees;
+    if (model_outputs != NULL && model_outputs->trees.capacity() < new_size)
+        model_outputs->trees.reserve(std::max(new_size, 2 * last_tree));
+    if (model_outputs_ext != NULL && model_outputs_ext->hplanes.capacity() < new_size)
+        model_outputs_ext->hplanes.reserve(std::max(new_size, 2 * last_tree));
+    if (imputer != NULL && imputer->imputer_tree.capacity() < new_size)
+        imputer->imputer_tree.reserve(std::max(new_size, 2 * last_tree));
+    if (indexer != NULL && indexer->indices.capacity() < new_size)
+        indexer->indices.reserve(std::max(new_size, 2 * last_tree));
+
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        if (model_outputs != NULL)
+            model_outputs->trees.push_back(std::move(new_trees[tree]));
+        else
+            model_outputs_ext->hplanes.push_back(std::move(new_hplanes[tree]));
+        if (imputer != NULL)
+            imputer->imputer_tree.push_back(std::move(new_impute_trees[tree]));
         if (indexer != NULL)
-        {
-            if (model_outputs != NULL)
-                build_terminal_node_mappings_single_tree(indexer->indices.back().terminal_node_mappings,
-                                                         indexer->indices.back().n_terminal,
-                                                         model_outputs->trees.back());
-            else
-                build_terminal_node_mappings_single_tree(indexer->indices.back().terminal_node_mappings,
-                                                         indexer->indices.back().n_terminal,
-                                                         model_outputs_ext->hplanes.back());
+            indexer->indices.push_back(std::move(new_indices[tree]));
+    }
 
-            check_interrupt_switch(ss);
+    if (model_outputs != NULL)
+        model_outputs->has_range_penalty = model_outputs->has_range_penalty || penalize_range;
+    else
+        model_outputs_ext->has_range_penalty = model_outputs_ext->has_range_penalty || penalize_range;
 
+    return EXIT_SUCCESS;
+}
 
-            if (!indexer->indices.front().node_distances.empty())
-            {
-                std::vector<size_t> temp;
-                temp.reserve(indexer->indices.back().n_terminal);
-                if (model_outputs != NULL) {
-                    build_dindex(
-                        temp,
-                        indexer->indices.back().terminal_node_mappings,
-                        indexer->indices.back().node_distances,
-                        indexer->indices.back().node_depths,
-                        indexer->indices.back().n_terminal,
-                        model_outputs->trees.back()
-                    );
-                }
-                else {
-                    build_dindex(
-                        temp,
-                        indexer->indices.back().terminal_node_mappings,
-                        indexer->indices.back().node_distances,
-                        indexer->indices.back().node_depths,
-                        indexer->indices.back().n_terminal,
-                        model_outputs_ext->hplanes.back()
-                    );
-                }
-            }
+/* Replace a tree in an isolation forest model with a new tree fit to the data passed here
+* 
+* This will fit a new tree in the same way as 'add_tree', and then put it in place of the
+* tree at position 'tree_num', discarding the old one along with its associated imputation
+* nodes and indexer entry (if any). The other trees are left in their same positions.
+* 
+* Can be used in a rotating fashion (e.g. replacing the oldest tree each time) in order to
+* have a model that tracks a sliding window of data while keeping a fixed number of trees,
+* at a cost that doesn't depend on the number of trees in the model.
+* 
+* Note that, same as for 'add_tree', the expected isolation depth stored in the model
+* ('exp_avg_depth' and 'exp_avg_sep') will not be modified. If the new tree is fit to a
+* number of rows different from the sample size of the tree that it replaces, these might
+* need to be updated manually (see the object-oriented interface for an example).
+* 
+* Parameters
+* ==========
+* - model_outputs, model_outputs_ext
+*       Same parameters as for 'add_tree' (see the documentation in there for details).
+* - tree_num
+*       Position (zero-based) of the tree to replace. Must be smaller than the number of trees
+*       in the model.
+* - All other parameters
+*       Same as for 'add_tree' (see the documentation in there for details). Note that the
+*       new tree will use the random seed that 'add_tree' would use for the next tree to add,
+*       so 'random_seed' should be varied across calls in order to get different trees.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1), in which case the model will be left as it was.
+*/
+template <class real_t, class sparse_ix>
+int replace_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t tree_num,
+                 real_t numeric_data[],  size_t ncols_numeric,
+                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                 real_t sample_weights[], size_t nrows,
+                 size_t max_depth,     size_t ncols_per_tree,
+                 bool   limit_depth,   bool penalize_range, bool standardize_data,
+                 bool   fast_bratio,
+                 real_t col_weights[], bool weigh_by_kurt,
+                 double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                 double prob_pick_by_full_gain, double prob_pick_by_dens,
+                 double prob_pick_col_by_range, double prob_pick_col_by_var,
+                 double prob_pick_col_by_kurt,
+                 double min_gain, MissingAction missing_action,
+                 CategSplit cat_split_type, NewCategAction new_cat_action,
+                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                 TreesIndexer *indexer,
+                 real_t ref_numeric_data[], int ref_categ_data[],
+                 bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+                 real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+                 uint64_t random_seed, bool use_long_double)
+{
+    if (model_outputs == NULL && model_outputs_ext == NULL)
+        throw std::runtime_error("Must pass an already-fitted model object to replace trees.\n");
+    if (model_outputs != NULL && model_outputs_ext != NULL)
+        throw std::runtime_error("Can only pass one type of model object to 'replace_tree'.\n");
+    size_t ntrees = (model_outputs != NULL)? model_outputs->trees.size() : model_outputs_ext->hplanes.size();
+    if (tree_num >= ntrees)
+        throw std::runtime_error("Passed tree number that is not in the model.\n");
+
+    int ret_val = add_tree<real_t, sparse_ix>(
+        model_outputs, model_outputs_ext,
+        numeric_data,  ncols_numeric,
+        categ_data,    ncols_categ,    ncat,
+        Xc, Xc_ind, Xc_indptr,
+        ndim, ntry, coef_type, coef_by_prop,
+        sample_weights, nrows,
+        max_depth,     ncols_per_tree,
+        limit_depth,   penalize_range, standardize_data,
+        fast_bratio,
+        col_weights, weigh_by_kurt,
+        prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+        prob_pick_by_full_gain, prob_pick_by_dens,
+        prob_pick_col_by_range, prob_pick_col_by_var,
+        prob_pick_col_by_kurt,
+        min_gain, missing_action,
+        cat_split_type, new_cat_action,
+        depth_imp, weigh_imp_rows,
+        all_perm, imputer, min_imp_obs,
+        indexer,
+        ref_numeric_data, ref_categ_data,
+        ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+        ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+        random_seed, use_long_double
+    );
+    if (ret_val != EXIT_SUCCESS)
+        return ret_val;
 
-            check_interrupt_switch(ss);
-            if (!indexer->indices.front().reference_points.empty())
-            {
-                size_t n_ref = indexer->indices.front().reference_points.size();
-                std::vector<sparse_ix> terminal_indices(n_ref);
-                std::unique_ptr<double[]> ignored(new double[n_ref]);
-                if (model_outputs != NULL)
-                {
-                    IsoForest single_tree_model;
-                    single_tree_model.new_cat_action = model_outputs->new_cat_action;
-                    single_tree_model.cat_split_type = model_outputs->cat_split_type;
-                    single_tree_model.missing_action = model_outputs->missing_action;
-                    single_tree_model.trees.push_back(model_outputs->trees.back());
-
-                    predict_iforest(ref_numeric_data, ref_categ_data,
-                                    ref_is_col_major, ref_ld_numeric, ref_ld_categ,
-                                    ref_Xc, ref_Xc_ind, ref_Xc_indptr,
-                                    (real_t*)NULL, (sparse_ix*)NULL, (sparse_ix*)NULL,
-                                    n_ref, 1, false,
-                                    &single_tree_model, (ExtIsoForest*)NULL,
-                                    ignored.get(), terminal_indices.data(),
-                                    (double*)NULL,
-                                    indexer);
-                }
+    /* The new tree was appended at the end - now it gets moved into the slot of the old one.
+       Since the vectors keep their capacity after removing the last element, this doesn't
+       need to re-allocate anything when it is called repeatedly. */
+    if (model_outputs != NULL)
+    {
+        model_outputs->trees[tree_num] = std::move(model_outputs->trees.back());
+        model_outputs->trees.pop_back();
+    }
 
-                else
-                {
-                    ExtIsoForest single_tree_model;
-                    single_tree_model.new_cat_action = model_outputs_ext->new_cat_action;
-                    single_tree_model.cat_split_type = model_outputs_ext->cat_split_type;
-                    single_tree_model.missing_action = model_outputs_ext->missing_action;
-                    single_tree_model.hplanes.push_back(model_outputs_ext->hplanes.back());
-
-                    predict_iforest(ref_numeric_data, ref_categ_data,
-                                    ref_is_col_major, ref_ld_numeric, ref_ld_categ,
-                                    ref_Xc, ref_Xc_ind, ref_Xc_indptr,
-                                    (real_t*)NULL, (sparse_ix*)NULL, (sparse_ix*)NULL,
-                                    n_ref, 1, false,
-                                    (IsoForest*)NULL, &single_tree_model,
-                                    ignored.get(), terminal_indices.data(),
-                                    (double*)NULL,
-                                    indexer);
-                }
+    else
+    {
+        model_outputs_ext->hplanes[tree_num] = std::move(model_outputs_ext->hplanes.back());
+        model_outputs_ext->hplanes.pop_back();
+    }
 
-                ignored.reset();
-                indexer->indices.back().reference_points.assign(terminal_indices.begin(), terminal_indices.end());
-                indexer->indices.back().reference_points.shrink_to_fit();
-                build_ref_node(indexer->indices.back());
-            }
+    if (imputer != NULL && imputer->imputer_tree.size() > ntrees)
+    {
+        imputer->imputer_tree[tree_num] = std::move(imputer->imputer_tree.back());
+        imputer->imputer_tree.pop_back();
+    }
 
-            check_interrupt_switch(ss);
-        }
+    if (indexer != NULL && indexer->indices.size() > ntrees)
+    {
+        indexer->indices[tree_num] = std::move(indexer->indices.back());
+        indexer->indices.pop_back();
     }
 
-    catch (...)
+    return EXIT_SUCCESS;
+}
+
+/* Fit isolation forest model to rows that are read one at a time from a stream
+* 
+* This reads all the rows in a single pass while keeping a separate random sub-sample
+* (reservoir) of 'sample_size' rows for each tree, and then fits all the trees to their
+* reservoirs, thus requiring memory proportional to 'ntrees * sample_size * ncols' instead
+* of the number of rows in the stream. Each tree gets the same sampling distribution that
+* it would get from 'fit_iforest' when sub-sampling without replacement, but the trees
+* are fit to different random samples than 'fit_iforest' would use with the same seed.
+* 
+* Parameters
+* ==========
+* - model_outputs (out)
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - model_outputs_ext (out)
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - next_row
+*       Function that will be called to obtain each row, in the order in which they are to
+*       be sampled. It will receive the pointer 'row_source' as-is, along with arrays of
+*       dimension 'ncols_numeric' and 'ncols_categ' where to write the values for the row
+*       (these can be ignored if the respective number of columns is zero), and a pointer
+*       where to write the row weight (which will be set to 1 before each call and can be
+*       ignored if not using weights). Numeric and categorical values follow the same
+*       conventions as 'numeric_data' and 'categ_data' in 'fit_iforest' (e.g. NAN for
+*       missing numeric values and negative numbers for missing categories).
+*       Should return 'true' when it wrote a new row and 'false' once there are no more rows,
+*       in which case the outputs from that call will be ignored.
+* - row_source
+*       Pointer to arbitrary data that will be passed to 'next_row' in each call.
+* - ncols_numeric
+*       Number of numeric columns in each row.
+* - ncols_categ
+*       Number of categorical columns in each row.
+* - ncat[ncols_categ]
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - ndim, ntry, coef_type, coef_by_prop
+*       Same parameters as for 'fit_iforest' (see the documentation in there for details).
+* - use_weights
+*       Whether to use the row weights produced by 'next_row'. Rows with non-positive weights
+*       will be ignored when the weights are taken as sampling probabilities.
+* - weight_as_sample
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+*       If passing 'true', the reservoirs will be sampled with probabilities proportional to
+*       the row weights, without replacement.
+* - sample_size
+*       Number of rows to keep in the reservoir of each tree. Unlike in 'fit_iforest', this
+*       must be passed as a positive number, since the number of rows is not known in advance.
+*       If the stream ends up having fewer rows than this, all trees will use all the rows.
+* - ntrees
+*       Number of trees (and reservoirs) to build.
+* - max_depth, ncols_per_tree, limit_depth, penalize_range, standardize_data,
+*   scoring_metric, fast_bratio, col_weights, weigh_by_kurt, prob_pick_by_gain_pl,
+*   prob_pick_by_gain_avg, prob_pick_by_full_gain, prob_pick_by_dens, prob_pick_col_by_range,
+*   prob_pick_col_by_var, prob_pick_col_by_kurt, min_gain, missing_action, cat_split_type,
+*   new_cat_action, all_perm, imputer, min_imp_obs, depth_imp, weigh_imp_rows
+*       Same parameters as for 'fit_iforest' (see the documentation in there for details).
+* - random_seed
+*       Seed that will be used for generating random numbers, both for the reservoirs and for
+*       the trees.
+* - use_long_double
+*       Same parameter as for 'fit_iforest' (see the documentation in there for details).
+* - nthreads
+*       Number of parallel threads to use for fitting the trees once the stream is exhausted.
+*       Reading the stream is always done in a single thread.
+* 
+* Returns
+* =======
+* Will return macro 'EXIT_SUCCESS' (typically =0) upon completion.
+* If the process receives an interrupt signal, will return instead
+* 'EXIT_FAILURE' (typically =1).
+*/
+template <class real_t>
+int fit_iforest_from_rows(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          bool (*next_row)(void *row_source, real_t numeric_row[], int categ_row[], real_t *row_weight),
+                          void *row_source,
+                          size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          bool use_weights, bool weight_as_sample,
+                          size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          real_t col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, bool use_long_double, int nthreads)
+{
+    if (next_row == NULL)
+        throw std::runtime_error("Must pass a function to read rows from.\n");
+    if (sample_size == 0)
+        throw std::runtime_error("Must pass a positive 'sample_size' when fitting to a stream of rows.\n");
+    if (ntrees == 0)
+        throw std::runtime_error("Must pass a positive 'ntrees'.\n");
+    if (ncols_numeric + ncols_categ == 0)
+        throw std::runtime_error("Data has no columns.\n");
+    if (use_long_double && !has_long_double()) {
+        use_long_double = false;
+        print_errmsg("Passed 'use_long_double=true', but library was compiled without long double support.\n");
+    }
+
+    /* the trees use seeds 'random_seed' through 'random_seed + ntrees - 1' */
+    RowReservoirs<real_t> reservoirs;
+    reservoirs.initialize(ntrees, sample_size, ncols_numeric, ncols_categ,
+                          use_weights && weight_as_sample, use_weights && !weight_as_sample,
+                          random_seed + (uint64_t)ntrees);
+
+    SignalSwitcher ss = SignalSwitcher();
+
     {
-        if (added_tree)
+        std::unique_ptr<real_t[]> numeric_row(new real_t[std::max(ncols_numeric, (size_t)1)]);
+        std::unique_ptr<int[]> categ_row(new int[std::max(ncols_categ, (size_t)1)]);
+        real_t row_weight = 1;
+        while (next_row(row_source, numeric_row.get(), categ_row.get(), &row_weight))
         {
-            if (model_outputs != NULL)
-                model_outputs->trees.pop_back();
-            else
-                model_outputs_ext->hplanes.pop_back();
-            if (imputer != NULL) {
-                if (model_outputs != NULL)
-                    imputer->imputer_tree.resize(model_outputs->trees.size());
-                else
-                    imputer->imputer_tree.resize(model_outputs_ext->hplanes.size());
-            }
-            if (indexer != NULL) {
-                if (model_outputs != NULL)
-                    indexer->indices.resize(model_outputs->trees.size());
-                else
-                    indexer->indices.resize(model_outputs_ext->hplanes.size());
-            }
+            reservoirs.push_row(numeric_row.get(), categ_row.get(), row_weight);
+            row_weight = 1;
+            if (unlikely(interrupt_switch)) break;
         }
-        throw;
     }
 
-    return EXIT_SUCCESS;
+    check_interrupt_switch(ss);
+    #if defined(DONT_THROW_ON_INTERRUPT)
+    if (interrupt_switch) return EXIT_FAILURE;
+    #endif
+
+    if (!reservoirs.n_filled)
+        throw std::runtime_error("Stream did not produce any usable row.\n");
+
+    size_t nrows, tree_block_size;
+    if (reservoirs.is_full())
+    {
+        nrows = ntrees * sample_size;
+        tree_block_size = sample_size;
+    }
+
+    else
+    {
+        reservoirs.compact();
+        nrows = reservoirs.n_filled;
+        sample_size = nrows;
+        tree_block_size = 0;
+    }
+
+    real_t *sample_weights = reservoirs.keep_weights? reservoirs.sample_weights.data() : (real_t*)NULL;
+    real_t *numeric_data = ncols_numeric? reservoirs.numeric_data.data() : (real_t*)NULL;
+    int *categ_data = ncols_categ? reservoirs.categ_data.data() : (int*)NULL;
+    int ret_val;
+
+    #ifndef NO_LONG_DOUBLE
+    if (likely(!use_long_double))
+    #endif
+        ret_val = fit_iforest_internal<real_t, int, double>(
+            model_outputs, model_outputs_ext,
+            numeric_data,  ncols_numeric,
+            categ_data,    ncols_categ,    ncat,
+            (real_t*)NULL, (int*)NULL, (int*)NULL,
+            ndim, ntry, coef_type, coef_by_prop,
+            sample_weights, false, false,
+            nrows, sample_size, ntrees,
+            max_depth, ncols_per_tree,
+            limit_depth, penalize_range, standardize_data,
+            scoring_metric, fast_bratio,
+            false, (double*)NULL,
+            (double*)NULL, false,
+            col_weights, weigh_by_kurt,
+            prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+            prob_pick_by_full_gain, prob_pick_by_dens,
+            prob_pick_col_by_range, prob_pick_col_by_var,
+            prob_pick_col_by_kurt,
+            min_gain, missing_action,
+            cat_split_type, new_cat_action,
+            all_perm, imputer, min_imp_obs,
+            depth_imp, weigh_imp_rows, false,
+            random_seed, nthreads, tree_block_size, (size_t)0,
+            (size_t)0, NULL, NULL
+        );
+    #ifndef NO_LONG_DOUBLE
+    else
+        ret_val = fit_iforest_internal<real_t, int, ldouble_ext>(
+            model_outputs, model_outputs_ext,
+            numeric_data,  ncols_numeric,
+            categ_data,    ncols_categ,    ncat,
+            (real_t*)NULL, (int*)NULL, (int*)NULL,
+            ndim, ntry, coef_type, coef_by_prop,
+            sample_weights, false, false,
+            nrows, sample_size, ntrees,
+            max_depth, ncols_per_tree,
+            limit_depth, penalize_range, standardize_data,
+            scoring_metric, fast_bratio,
+            false, (double*)NULL,
+            (double*)NULL, false,
+            col_weights, weigh_by_kurt,
+            prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+            prob_pick_by_full_gain, prob_pick_by_dens,
+            prob_pick_col_by_range, prob_pick_col_by_var,
+            prob_pick_col_by_kurt,
+            min_gain, missing_action,
+            cat_split_type, new_cat_action,
+            all_perm, imputer, min_imp_obs,
+            depth_imp, weigh_imp_rows, false,
+            random_seed, nthreads, tree_block_size, (size_t)0,
+            (size_t)0, NULL, NULL
+        );
+    #endif
+
+    if (ret_val == EXIT_SUCCESS)
+    {
+        if (model_outputs != NULL)
+            model_outputs->orig_sample_size = reservoirs.nrows_seen;
+        else
+            model_outputs_ext->orig_sample_size = reservoirs.nrows_seen;
+    }
+    return ret_val;
 }
 
 template <class InputData, class WorkerMemory, class ldouble_safe>
@@ -1744,10 +2268,6 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                std::vector<ImputeNode> *impute_nodes,
                size_t                   tree_num)
 {
-    /* initialize array for depths if called for */
-    if (workspace.ix_arr.empty() && model_params.calc_depth)
-        workspace.row_depths.resize(input_data.nrows, 0);
-
     /* choose random sample of rows */
     if (workspace.ix_arr.empty()) workspace.ix_arr.resize(model_params.sample_size);
     if (input_data.log2_n > 0)
@@ -1755,15 +2275,149 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                        input_data.btree_weights_init.end());
     workspace.rnd_generator.seed(model_params.random_seed + tree_num);
     workspace.rbin  = UniformUnitInterval(0, 1);
-    sample_random_rows<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
-                       workspace.ix_arr, input_data.nrows, model_params.with_replacement,
-                       workspace.rnd_generator, workspace.ix_all,
-                       (input_data.weight_as_sample)? input_data.sample_weights : NULL,
-                       workspace.btree_weights, input_data.log2_n, input_data.btree_offset,
-                       workspace.is_repeated);
+    if (input_data.tree_block_size)
+        std::iota(workspace.ix_arr.begin(), workspace.ix_arr.end(), tree_num * input_data.tree_block_size);
+    else
+        sample_random_rows<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
+                           workspace.ix_arr, input_data.nrows, model_params.with_replacement,
+                           workspace.rnd_generator, workspace.ix_all,
+                           (input_data.weight_as_sample)? input_data.sample_weights : NULL,
+                           workspace.btree_weights, input_data.log2_n, input_data.btree_offset,
+                           workspace.is_repeated,
+                           input_data.alias_prob.empty()? (double*)NULL : input_data.alias_prob.data(),
+                           input_data.alias_ix.empty()? (size_t*)NULL : input_data.alias_ix.data());
     workspace.st  = 0;
     workspace.end = model_params.sample_size - 1;
 
+    /* if the tree takes only a sub-sample of the rows, it can continue with a compact copy of
+       them in which they are numbered 0..sample_size-1, so that the nodes read from contiguous
+       memory and the per-thread buffers indexed by row only need as many entries as the sample */
+    if (prefer_tree_sample_data(input_data, model_params, impute_nodes != NULL))
+    {
+        InputData tree_data = get_tree_sample_data(input_data, workspace, model_params);
+        fit_itree_sample<InputData, WorkerMemory, ldouble_safe>(
+                         tree_root, hplane_root, workspace,
+                         tree_data, model_params, impute_nodes);
+    }
+
+    else
+    {
+        fit_itree_sample<InputData, WorkerMemory, ldouble_safe>(
+                         tree_root, hplane_root, workspace,
+                         input_data, model_params, impute_nodes);
+    }
+}
+
+/* Copying the sampled rows is only done for dense inputs. The copy reads each value of the
+   sample once from the full data, while fitting on the full data reads, at each depth level,
+   the sampled rows of every column that gets examined at the nodes, scattered across memory.
+   Otherwise, the copy can still pay off by making the buffers indexed by row smaller, as long
+   as it doesn't take more memory than what it saves. Since every thread makes its own copy,
+   it is never made when it would exceed 'TREE_SAMPLE_MAX_SIZE' values. */
+template <class InputData>
+bool prefer_tree_sample_data(const InputData &input_data, const ModelParams &model_params, bool build_imputer)
+{
+    if (input_data.tree_block_size || model_params.low_memory)
+        return false;
+    return prefer_tree_sample_data(input_data.Xc_indptr != NULL,
+                                   input_data.sample_weights != NULL && !input_data.weight_as_sample,
+                                   input_data.nrows, input_data.ncols_tot,
+                                   model_params, build_imputer);
+}
+
+bool prefer_tree_sample_data(bool is_sparse, bool has_density_weights, size_t nrows, size_t ncols_tot,
+                             const ModelParams &model_params, bool build_imputer)
+{
+    if (is_sparse || model_params.sample_size >= nrows)
+        return false;
+    if (model_params.sample_size * ncols_tot > TREE_SAMPLE_MAX_SIZE)
+        return false;
+
+    size_t cols_per_node;
+    if (build_imputer || model_params.weigh_by_kurt ||
+        model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var || model_params.prob_pick_col_by_kurt)
+        cols_per_node = ncols_tot;
+    else if (model_params.prob_pick_by_gain_avg || model_params.prob_pick_by_gain_pl ||
+             model_params.prob_pick_by_full_gain || model_params.prob_pick_by_dens)
+        cols_per_node = std::max(model_params.ndim, (size_t)1) * std::max(model_params.ntry, (size_t)1);
+    else
+        cols_per_node = std::max(model_params.ndim, (size_t)1);
+
+    size_t depth = std::min(model_params.max_depth, (size_t)log2ceil(model_params.sample_size));
+    if (ncols_tot <= std::max(depth, (size_t)1) * cols_per_node)
+        return true;
+
+    bool uses_row_buffers = has_density_weights || model_params.missing_action == Divide;
+    return uses_row_buffers && model_params.sample_size * ncols_tot <= nrows;
+}
+
+template <class InputData, class WorkerMemory>
+InputData get_tree_sample_data(InputData &input_data, WorkerMemory &workspace, ModelParams &model_params)
+{
+    size_t ntake = workspace.ix_arr.size();
+    const size_t *restrict ix_arr = workspace.ix_arr.data();
+
+    workspace.sample_numeric.resize(ntake * input_data.ncols_numeric);
+    for (size_t col = 0; col < input_data.ncols_numeric; col++)
+    {
+        auto *restrict x_from = input_data.numeric_data + col * input_data.nrows;
+        auto *restrict x_to = workspace.sample_numeric.data() + col * ntake;
+        for (size_t row = 0; row < ntake; row++)
+            x_to[row] = x_from[ix_arr[row]];
+    }
+
+    workspace.sample_categ.resize(ntake * input_data.ncols_categ);
+    for (size_t col = 0; col < input_data.ncols_categ; col++)
+    {
+        const int *restrict x_from = input_data.categ_data + col * input_data.nrows;
+        int *restrict x_to = workspace.sample_categ.data() + col * ntake;
+        for (size_t row = 0; row < ntake; row++)
+            x_to[row] = x_from[ix_arr[row]];
+    }
+
+    bool take_weights = input_data.sample_weights != NULL && !input_data.weight_as_sample;
+    if (take_weights)
+    {
+        workspace.sample_row_weights.resize(ntake);
+        for (size_t row = 0; row < ntake; row++)
+            workspace.sample_row_weights[row] = input_data.sample_weights[ix_arr[row]];
+    }
+
+    InputData tree_data = {input_data.ncols_numeric? workspace.sample_numeric.data() : NULL,
+                           input_data.ncols_numeric,
+                           input_data.ncols_categ? workspace.sample_categ.data() : NULL,
+                           input_data.ncat, input_data.max_categ, input_data.ncols_categ,
+                           ntake, input_data.ncols_tot,
+                           take_weights? workspace.sample_row_weights.data() : NULL,
+                           input_data.weight_as_sample, input_data.col_weights,
+                           input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
+                           0, 0, std::vector<double>(),
+                           std::vector<double>(), std::vector<size_t>(),
+                           std::vector<char>(), 0, input_data.preinitialized_col_sampler,
+                           input_data.range_low, input_data.range_high, input_data.ncat_, std::vector<double>(),
+                           std::vector<double>(), std::vector<double>(),
+                           std::vector<size_t>(), std::vector<size_t>(),
+                           (size_t)0};
+
+    if (model_params.prob_pick_by_full_gain)
+        colmajor_to_rowmajor(tree_data.numeric_data, tree_data.nrows, tree_data.ncols_numeric, tree_data.X_row_major);
+
+    /* the rows are now numbered by their position in the sample, and the buffers that were
+       filled according to the previous numbering need to be generated again */
+    std::iota(workspace.ix_arr.begin(), workspace.ix_arr.end(), (size_t)0);
+    workspace.weights_arr.clear();
+    workspace.weights_map.clear();
+    return tree_data;
+}
+
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void fit_itree_sample(std::vector<IsoTree>    *tree_root,
+                      std::vector<IsoHPlane>  *hplane_root,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes)
+{
     /* in some cases, it's not possible to use column weights even if they are given,
        because every single column will always need to be checked or end up being used. */
     bool avoid_col_weights = (tree_root != NULL && model_params.ntry >= model_params.ncols_per_tree &&
@@ -1782,11 +2436,7 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
 
     /* set expected tree size and add root node */
     {
-        size_t exp_nodes = mult2(model_params.sample_size);
-        if (model_params.sample_size >= div2(SIZE_MAX))
-            exp_nodes = SIZE_MAX;
-        else if (model_params.max_depth <= (size_t)30)
-            exp_nodes = std::min(exp_nodes, pow2(model_params.max_depth));
+        size_t exp_nodes = reserved_tree_nodes(model_params.sample_size, model_params.max_depth);
         if (tree_root != NULL)
         {
             tree_root->reserve(exp_nodes);
@@ -2100,6 +2750,9 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
     if (model_params.prob_pick_by_full_gain && workspace.col_indices.empty())
         workspace.col_indices.resize(model_params.ncols_per_tree);
 
+    if (workspace.buffer_ix.size() < workspace.ix_arr.size())
+        workspace.buffer_ix.resize(workspace.ix_arr.size());
+
     if (
         (model_params.prob_pick_col_by_range || model_params.prob_pick_col_by_var) &&
         model_params.weigh_by_kurt &&
@@ -2236,7 +2889,8 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                cols_take, input_data.ncols_tot, false,
                                workspace.rnd_generator, buffer1,
                                (double*)NULL, kurt_weights, /* <- will not get used */
-                               (size_t)0, (size_t)0, buffer2);
+                               (size_t)0, (size_t)0, buffer2,
+                               (double*)NULL, (size_t*)NULL);
 
             if (
                 model_params.sample_size == input_data.nrows &&
@@ -2404,7 +3058,70 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                                               col_sampler_is_fresh);
     }
 
-    if (tree_root != NULL)
+    if (tree_root != NULL && is_plain_numeric_itree(workspace, input_data, model_params, impute_nodes))
+    {
+        #ifndef NDEBUG
+        /* In debug builds, the same tree is built again through the general function from a copy
+           of the workspace, which should produce exactly the same nodes. This is skipped when
+           calculating depths, as those are added to arrays shared with other threads. */
+        std::unique_ptr<WorkerMemory> ref_workspace;
+        std::vector<IsoTree> ref_tree;
+        if (!model_params.calc_depth)
+        {
+            ref_workspace = std::unique_ptr<WorkerMemory>(new WorkerMemory(workspace));
+            ref_tree = *tree_root;
+        }
+        #endif
+
+        if (model_params.missing_action == Fail)
+            split_itree_recursive_numeric<InputData, WorkerMemory, ldouble_safe, Fail>(
+                                          *tree_root,
+                                          workspace,
+                                          input_data,
+                                          model_params,
+                                          0);
+        else
+            split_itree_recursive_numeric<InputData, WorkerMemory, ldouble_safe, Impute>(
+                                          *tree_root,
+                                          workspace,
+                                          input_data,
+                                          model_params,
+                                          0);
+
+        #ifndef NDEBUG
+        if (ref_workspace && !interrupt_switch)
+        {
+            split_itree_recursive<InputData, WorkerMemory, ldouble_safe>(
+                                  ref_tree,
+                                  *ref_workspace,
+                                  input_data,
+                                  model_params,
+                                  impute_nodes,
+                                  0);
+            assert(ref_tree.size() == tree_root->size());
+            for (size_t node = 0; node < ref_tree.size(); node++)
+            {
+                const IsoTree &a = (*tree_root)[node], &b = ref_tree[node];
+                assert(a.tree_left == b.tree_left);
+                if (a.tree_left)
+                {
+                    assert(a.col_type == b.col_type);
+                    assert(a.col_num == b.col_num);
+                    assert(a.num_split == b.num_split);
+                    assert(a.pct_tree_left == b.pct_tree_left);
+                    assert(a.tree_right == b.tree_right);
+                    assert(a.range_low == b.range_low && a.range_high == b.range_high);
+                }
+                else
+                {
+                    assert(a.score == b.score);
+                }
+            }
+        }
+        #endif
+    }
+
+    else if (tree_root != NULL)
     {
         split_itree_recursive<InputData, WorkerMemory, ldouble_safe>(
                               *tree_root,
@@ -2426,7 +3143,342 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                                0);
     }
 
+    /* additions to the per-row sums that are still queued need to be made before the tree is
+       done, as they refer to the imputation nodes by their position */
+    if (model_params.calc_depth || model_params.impute_at_fit)
+        flush_row_sums(workspace, impute_nodes);
+
     /* if producing imputation structs, only need to keep the ones for terminal nodes */
     if (impute_nodes != NULL)
         drop_nonterminal_imp_node(*impute_nodes, tree_root, hplane_root);
 }
+
+/* Estimates of the memory (in bytes) that a model and the fitting procedure will take.
+   These count the buffers by the sizes to which they get allocated, and for the trees,
+   use the number of nodes that they were found to have on average when choosing splits
+   at random, which, when limiting the depth to log2(n), grows as ~2.2*n^0.675, and
+   without limit, as ~1.4*n (guided splits and repeated values lead to different sizes).
+   When imputing at fit time, assumes that any row might have missing values, but without
+   the per-value sums for the missing entries, as their number is not known. They do not
+   count the input data nor the output arrays passed by the user, nor the overhead of the
+   memory allocator. */
+size_t estimate_tree_nodes(size_t sample_size, size_t max_depth) noexcept
+{
+    double n = (double)std::max(sample_size, (size_t)1);
+    double log2n = std::log2(n);
+    double depth = (double)max_depth;
+    double n_nodes;
+    if (depth <= log2n)
+    {
+        n_nodes = (2.2 + 1.8 * std::fmin(1., (log2n - depth) / 4.)) * std::exp2(0.675 * depth);
+    }
+
+    else
+    {
+        double n_nodes_log2n = 2.2 * std::pow(n, 0.675);
+        double n_nodes_full = 1.5 * n;
+        n_nodes = n_nodes_log2n + (n_nodes_full - n_nodes_log2n) * (1. - std::exp(-(depth - log2n) / std::fmax(log2n, 1.)));
+    }
+
+    double max_nodes = 2. * n - 1.;
+    if (max_depth < (size_t)60)
+        max_nodes = std::fmin(max_nodes, std::exp2(depth + 1.) - 1.);
+    return (size_t)std::fmax(1., std::fmin(n_nodes, max_nodes));
+}
+
+/* while the tree is being built, it has space reserved for this many nodes */
+size_t reserved_tree_nodes(size_t sample_size, size_t max_depth) noexcept
+{
+    size_t exp_nodes = mult2(sample_size);
+    if (sample_size >= div2(SIZE_MAX))
+        exp_nodes = SIZE_MAX;
+    else if (max_depth <= (size_t)30)
+        exp_nodes = std::min(exp_nodes, pow2(max_depth));
+    return std::max(exp_nodes, (size_t)1);
+}
+
+size_t impute_node_sums_size(size_t ncols_numeric, size_t ncols_categ, int max_categ) noexcept
+{
+    return ncols_numeric * (sizeof(double) + sizeof(double))
+            + ncols_categ * (sizeof(std::vector<double>) + sizeof(double) + (size_t)max_categ * sizeof(double));
+}
+
+size_t estimate_model_size_internal(const ModelParams &model_params,
+                                    size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                                    bool build_imputer, bool build_indexer, bool with_distances) noexcept
+{
+    size_t ncols_tot = ncols_numeric + ncols_categ;
+    size_t n_nodes = estimate_tree_nodes(model_params.sample_size, model_params.max_depth);
+    size_t n_terminal = div2(n_nodes + 1);
+    size_t n_splits = n_nodes - n_terminal;
+    double prop_categ = ncols_tot? ((double)ncols_categ / (double)ncols_tot) : 0.;
+    size_t size_categ_split = 0;
+    if (model_params.cat_split_type == SubSet)
+        size_categ_split = sizeof(uint64_t) * cat_split_nwords(max_categ)
+                            * ((model_params.new_cat_action == Weighted)? 2 : 1);
+
+    size_t size_tree;
+    if (!model_params.ndim)
+    {
+        size_tree  = n_nodes * sizeof(IsoTree);
+        size_tree += (size_t)((double)(n_splits * size_categ_split) * prop_categ);
+    }
+
+    else
+    {
+        size_t ndim = std::min(model_params.ndim, ncols_tot);
+        size_t ndim_categ = (size_t)std::ceil((double)ndim * prop_categ);
+        size_t size_hplane = ndim * (sizeof(size_t) + sizeof(ColType) + sizeof(double))
+                                + (ndim - ndim_categ) * (sizeof(double) + sizeof(double));
+        if (ndim_categ)
+        {
+            size_hplane += ndim * sizeof(std::vector<double>);
+            if (model_params.cat_split_type == SubSet)
+                size_hplane += ndim_categ * (size_t)max_categ * sizeof(double);
+            else
+                size_hplane += ndim_categ * (sizeof(int) + sizeof(double));
+        }
+        size_tree = n_nodes * sizeof(IsoHPlane) + n_splits * size_hplane;
+    }
+
+    /* only the terminal nodes keep their sums after the tree is built */
+    if (build_imputer)
+        size_tree += n_nodes * sizeof(ImputeNode)
+                        + n_terminal * impute_node_sums_size(ncols_numeric, ncols_categ, max_categ);
+
+    if (build_indexer)
+    {
+        size_tree += sizeof(SingleTreeIndex) + n_nodes * sizeof(size_t) + n_terminal * sizeof(double);
+        if (with_distances)
+            size_tree += div2(n_terminal * (n_terminal - 1)) * sizeof(double);
+    }
+
+    return model_params.ntrees * (size_tree + sizeof(std::vector<IsoTree>) + (build_imputer? sizeof(std::vector<ImputeNode>) : 0))
+            + (build_imputer? (ncols_numeric * sizeof(double) + ncols_categ * (sizeof(int) + sizeof(int))) : 0)
+            + std::max(sizeof(IsoForest), sizeof(ExtIsoForest));
+}
+
+size_t estimate_fit_memory_internal(const ModelParams &model_params,
+                                    size_t nrows, size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                                    size_t nnz, bool has_weights, bool weight_as_sample,
+                                    bool build_imputer, bool copy_tree_sample,
+                                    size_t size_real, size_t size_ldouble, int nthreads) noexcept
+{
+    size_t ncols_tot = ncols_numeric + ncols_categ;
+    size_t sample_size = model_params.sample_size;
+    bool is_sparse = nnz > 0;
+    bool gain = model_params.prob_pick_by_gain_avg  > 0 || model_params.prob_pick_by_gain_pl > 0 ||
+                model_params.prob_pick_by_full_gain > 0 || model_params.prob_pick_by_dens    > 0;
+    bool density_weights = has_weights && !weight_as_sample;
+    bool sampling_weights = has_weights && weight_as_sample;
+    size_t nrows_tree = copy_tree_sample? sample_size : nrows;
+    nthreads = std::max(1, std::min(nthreads, (int)std::min(model_params.ntrees, (size_t)INT_MAX)));
+
+    /* shared by all threads */
+    size_t mem_shared = estimate_model_size_internal(model_params, ncols_numeric, ncols_categ, max_categ,
+                                                     build_imputer, false, false);
+    if (model_params.prob_pick_by_full_gain)
+    {
+        if (!is_sparse)
+            mem_shared += nrows * ncols_numeric * sizeof(double);
+        else
+            mem_shared += nnz * (size_real + sizeof(size_t)) + (nrows + 1) * sizeof(size_t);
+    }
+    if (sampling_weights)
+    {
+        if (model_params.with_replacement)
+            mem_shared += nrows * (sizeof(double) + sizeof(size_t));
+        else if (prefer_btree_sampler(sample_size, nrows))
+            mem_shared += pow2(log2ceil(nrows) + 1) * sizeof(double);
+    }
+    if (model_params.weigh_by_kurt || model_params.prob_pick_col_by_range || is_boxed_metric(model_params.scoring_metric))
+        mem_shared += ncols_tot * (sizeof(double) + sizeof(double) + sizeof(size_t) + sizeof(int));
+    if (model_params.impute_at_fit)
+        mem_shared += nrows * sizeof(ImputedData<int, double>)
+                        + (ncols_tot + (size_t)ROW_SUMS_NSTRIPES) * sizeof(size_t);
+    if (model_params.calc_depth)
+        mem_shared += (size_t)ROW_SUMS_NSTRIPES * sizeof(size_t);
+
+    /* a copy for each thread, plus the space reserved for the tree that it is building */
+    size_t mem_thread = sizeof(WorkerMemory<ImputedData<int, double>, double, double>);
+    mem_thread += reserved_tree_nodes(sample_size, model_params.max_depth)
+                    * ((model_params.ndim? sizeof(IsoHPlane) : sizeof(IsoTree)) + (build_imputer? sizeof(ImputeNode) : 0));
+    if (build_imputer)
+        mem_thread += div2(estimate_tree_nodes(sample_size, model_params.max_depth))
+                        * impute_node_sums_size(ncols_numeric, ncols_categ, max_categ);
+    mem_thread += sample_size * sizeof(size_t);
+    if (!model_params.with_replacement && !has_weights && sample_size < nrows)
+    {
+        if (sample_size >= div2(nrows))
+            mem_thread += nrows * sizeof(size_t);
+        else if ((double)sample_size / (double)nrows > 1. / 50.)
+            mem_thread += nrows / CHAR_BIT + 1;
+        else
+            mem_thread += sample_size * (sizeof(size_t) + sizeof(void*));
+    }
+    if (sampling_weights && !model_params.with_replacement && sample_size < nrows)
+    {
+        if (prefer_btree_sampler(sample_size, nrows))
+            mem_thread += pow2(log2ceil(nrows) + 1) * sizeof(double);
+        else
+            mem_thread += mult2(nrows) * sizeof(double);
+    }
+
+    if (copy_tree_sample)
+    {
+        mem_thread += sample_size * (ncols_numeric * size_real + ncols_categ * sizeof(int));
+        if (density_weights)
+            mem_thread += sample_size * size_real;
+        if (model_params.prob_pick_by_full_gain)
+            mem_thread += sample_size * ncols_numeric * sizeof(double);
+    }
+
+    if (density_weights || model_params.missing_action == Divide)
+    {
+        if (is_sparse && sample_size < nrows / 50)
+            mem_thread += sample_size * (sizeof(size_t) + sizeof(double) + sizeof(void*));
+        else
+            mem_thread += nrows_tree * sizeof(double);
+    }
+
+    size_t buffer_size = (gain || model_params.ntry > 1 || model_params.ndim)? sample_size : 0;
+    if (buffer_size)
+    {
+        mem_thread += buffer_size * (sizeof(double) + sizeof(size_t));
+        if (is_sparse && model_params.ndim < 2)
+            mem_thread += buffer_size * sizeof(double);
+    }
+    if (ncols_categ)
+        mem_thread += ((size_t)max_categ + 1) * (sizeof(double) + mult2(sizeof(size_t)) + size_ldouble + 1);
+    if (model_params.prob_pick_by_full_gain || (is_sparse && gain))
+        mem_thread += (sample_size + mult2(ncols_numeric)) * sizeof(double) + sample_size * sizeof(size_t);
+    mem_thread += sample_size * sizeof(size_t);
+    if (!model_params.ndim && model_params.missing_action == Impute && gain && !is_sparse && ncols_numeric)
+        mem_thread += nrows_tree * sizeof(double);
+
+    if (model_params.ndim)
+    {
+        mem_thread += sample_size * sizeof(double);
+        mem_thread += ncols_tot * 4 * sizeof(double);
+        if (ncols_categ && model_params.cat_split_type == SubSet)
+            mem_thread += ncols_tot * (sizeof(std::vector<double>) + (size_t)max_categ * sizeof(double));
+    }
+
+    /* column samplers, for the tree (with its alias table) and for the nodes along with their backups */
+    mem_thread += ncols_tot * (5 * sizeof(size_t) + 4 * sizeof(double));
+    if (model_params.scoring_metric != Depth)
+        mem_thread += (model_params.max_depth + 1) * (mult2(ncols_tot) + (size_t)max_categ + 4) * sizeof(double);
+
+    if (model_params.calc_dist)
+        mem_thread += div2(nrows * (nrows - 1)) * sizeof(double);
+    if (model_params.calc_depth || model_params.impute_at_fit)
+        mem_thread += (size_t)ROW_SUMS_NSTRIPES * (sizeof(std::vector<RowAddition>)
+                                                   + (size_t)ROW_SUMS_QUEUE_SIZE * sizeof(RowAddition));
+
+    return mem_shared + (size_t)nthreads * mem_thread;
+}
+
+/* If the estimated memory usage exceeds the limit, will first try to avoid the copies of the
+   rows of each tree, and then reduce the number of threads, throwing an error if it still
+   cannot fit within the limit with a single thread. */
+template <class InputData>
+void adjust_to_memory_limit(InputData &input_data, ModelParams &model_params, bool build_imputer,
+                            size_t nnz, size_t size_ldouble, int &nthreads, size_t max_memory)
+{
+    bool copy_tree_sample = prefer_tree_sample_data(input_data, model_params, build_imputer);
+    size_t size_real = sizeof(typename std::remove_pointer<decltype(input_data.numeric_data)>::type);
+    size_t mem_needed = SIZE_MAX;
+    for (int nthreads_try = std::max(nthreads, 1); nthreads_try >= 1; nthreads_try--)
+    {
+        for (bool copy : {copy_tree_sample, false})
+        {
+            size_t mem_estimate = estimate_fit_memory_internal(model_params,
+                                                               input_data.nrows, input_data.ncols_numeric,
+                                                               input_data.ncols_categ, input_data.max_categ, nnz,
+                                                               input_data.sample_weights != NULL, input_data.weight_as_sample,
+                                                               build_imputer, copy, size_real, size_ldouble, nthreads_try);
+            mem_needed = std::min(mem_needed, mem_estimate);
+            if (mem_estimate <= max_memory)
+            {
+                nthreads = nthreads_try;
+                model_params.low_memory = copy_tree_sample && !copy;
+                return;
+            }
+            if (!copy_tree_sample) break;
+        }
+    }
+
+    throw std::runtime_error("Fitting the model would take an estimated "
+                             + std::to_string(mem_needed / ((size_t)1 << 20))
+                             + "MB of memory, which exceeds 'max_memory'.\n");
+}
+
+size_t estimate_model_size(size_t ndim, size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth, CategSplit cat_split_type,
+                           bool build_imputer, bool build_indexer, bool with_distances)
+{
+    if (sample_size == 0 || sample_size > nrows)
+        sample_size = nrows;
+    ModelParams model_params = {};
+    model_params.sample_size = sample_size;
+    model_params.ntrees = ntrees;
+    model_params.max_depth = limit_depth? log2ceil(sample_size) : max_depth? max_depth : (sample_size - 1);
+    model_params.ndim = (ndim == 1)? 0 : ndim;
+    model_params.cat_split_type = cat_split_type;
+    return estimate_model_size_internal(model_params, ncols_numeric, ncols_categ, max_categ,
+                                        build_imputer, build_indexer, with_distances);
+}
+
+size_t estimate_fit_memory(size_t ndim, size_t ntry,
+                           size_t ncols_numeric, size_t ncols_categ, int max_categ, size_t nnz,
+                           bool has_sample_weights, bool with_replacement, bool weight_as_sample,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth,
+                           ScoringMetric scoring_metric, bool calc_dist, bool calc_depth,
+                           bool weigh_by_kurt,
+                           double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                           double prob_pick_by_full_gain, double prob_pick_by_dens,
+                           double prob_pick_col_by_range, double prob_pick_col_by_var,
+                           double prob_pick_col_by_kurt,
+                           MissingAction missing_action, CategSplit cat_split_type,
+                           bool build_imputer, bool impute_at_fit,
+                           bool use_long_double, int nthreads)
+{
+    if (sample_size == 0 || sample_size > nrows)
+        sample_size = nrows;
+    ModelParams model_params = {};
+    model_params.with_replacement = with_replacement;
+    model_params.sample_size = sample_size;
+    model_params.ntrees = ntrees;
+    model_params.max_depth = limit_depth? log2ceil(sample_size) : max_depth? max_depth : (sample_size - 1);
+    model_params.weigh_by_kurt = weigh_by_kurt;
+    model_params.prob_pick_by_gain_avg = prob_pick_by_gain_avg;
+    model_params.prob_pick_by_gain_pl = prob_pick_by_gain_pl;
+    model_params.prob_pick_by_full_gain = prob_pick_by_full_gain;
+    model_params.prob_pick_by_dens = prob_pick_by_dens;
+    model_params.prob_pick_col_by_range = prob_pick_col_by_range;
+    model_params.prob_pick_col_by_var = prob_pick_col_by_var;
+    model_params.prob_pick_col_by_kurt = prob_pick_col_by_kurt;
+    model_params.cat_split_type = cat_split_type;
+    model_params.missing_action = missing_action;
+    model_params.scoring_metric = scoring_metric;
+    model_params.ndim = (ndim == 1)? 0 : ndim;
+    model_params.ntry = (ndim == 1)? std::min(ntry, ncols_numeric + ncols_categ) : ntry;
+    model_params.calc_dist = calc_dist;
+    model_params.calc_depth = calc_depth;
+    model_params.impute_at_fit = impute_at_fit;
+
+    bool copy_tree_sample = prefer_tree_sample_data(nnz > 0, has_sample_weights && !weight_as_sample,
+                                                    nrows, ncols_numeric + ncols_categ,
+                                                    model_params, build_imputer);
+    #ifndef NO_LONG_DOUBLE
+    size_t size_ldouble = (use_long_double && has_long_double())? sizeof(ldouble_ext) : sizeof(double);
+    #else
+    size_t size_ldouble = sizeof(double);
+    #endif
+    return estimate_fit_memory_internal(model_params, nrows, ncols_numeric, ncols_categ, max_categ, nnz,
+                                        has_sample_weights, weight_as_sample,
+                                        build_imputer, copy_tree_sample,
+                                        sizeof(double), size_ldouble, nthreads);
+}
@@ -433,12 +433,12 @@ void traverse_isoforest_graphviz
                 {
                     curr_labels.append(categ_colnames[tree->col_num] + "={");
                     bool added_left = false;
-                    for (size_t categ = 0; categ < tree->cat_split.size(); categ++)
+                    for (size_t categ = 0; categ < (size_t)tree->ncat_split; categ++)
                     {
                         if (
-                            tree->cat_split[categ] == 1 ||
+                            get_cat_split(*tree, (int)categ) == 1 ||
                             (
-                                tree->cat_split[categ] == -1 &&
+                                get_cat_split(*tree, (int)categ) == -1 &&
                                 (
                                     (model.new_cat_action == Smallest && tree->pct_tree_left < .5) ||
                                     (model.missing_action == Impute && tree->pct_tree_left >= .5)
@@ -948,7 +948,7 @@ void traverse_isoforest_json
                 case SubSet:
                 {
                     curr_json.append("map\", \"value\":{");
-                    for (size_t categ = 0; categ < tree->cat_split.size(); categ++)
+                    for (size_t categ = 0; categ < (size_t)tree->ncat_split; categ++)
                     {
                         if (categ > 0) curr_json.append(",");
                         curr_json.append(
@@ -956,7 +956,7 @@ void traverse_isoforest_json
                             categ_levels[tree->col_num][categ] +
                             "\":\""
                         );
-                        switch (tree->cat_split[categ])
+                        switch (get_cat_split(*tree, (int)categ))
                         {
                             case 1:
                             {
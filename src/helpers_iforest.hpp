@@ -182,6 +182,30 @@ void set_col_as_taken(std::vector<bool> &col_is_taken, hashed_set<size_t> &col_i
         col_is_taken_s.insert(col_num);
 }
 
+/* Whether the tree can be built through 'split_itree_recursive_numeric', which needs to be
+   checked after the column sampler and the weights for the tree have been initialized. */
+template <class InputData, class WorkerMemory>
+bool is_plain_numeric_itree(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                            std::vector<ImputeNode> *impute_nodes)
+{
+    return
+        impute_nodes == NULL &&
+        !model_params.impute_at_fit &&
+        input_data.ncols_categ == 0 &&
+        input_data.Xc_indptr == NULL &&
+        !workspace.changed_weights &&
+        !workspace.col_sampler.has_weights() &&
+        (model_params.missing_action == Fail || model_params.missing_action == Impute) &&
+        model_params.scoring_metric == Depth &&
+        model_params.prob_pick_by_gain_avg  == 0 &&
+        model_params.prob_pick_by_gain_pl   == 0 &&
+        model_params.prob_pick_by_full_gain == 0 &&
+        model_params.prob_pick_by_dens      == 0 &&
+        model_params.prob_pick_col_by_range == 0 &&
+        model_params.prob_pick_col_by_var   == 0 &&
+        model_params.prob_pick_col_by_kurt  == 0;
+}
+
 template <class InputData, class WorkerMemory>
 void add_separation_step(WorkerMemory &workspace, InputData &input_data, double remainder)
 {
@@ -211,6 +235,86 @@ void add_remainder_separation_steps(WorkerMemory &workspace, InputData &input_da
     }
 }
 
+/* Depths are weighted the same way as the node remainders in the single-variable model,
+   while imputations are weighted by whatever row weights are present. */
+template <class InputData, class WorkerMemory>
+void add_terminal_to_row_sums(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                              std::vector<ImputeNode> *impute_nodes, double depth, bool weigh_depth)
+{
+    if (workspace.row_additions.size() != workspace.row_stripes->nstripes)
+        workspace.row_additions.resize(workspace.row_stripes->nstripes);
+
+    size_t impute_node = model_params.impute_at_fit? (impute_nodes->size() - 1) : SIZE_MAX;
+    bool depth_uses_weights = weigh_depth && workspace.changed_weights;
+    RowAddition addition;
+    size_t stripe;
+    double w;
+    for (size_t row = workspace.st; row <= workspace.end; row++)
+    {
+        addition.row = workspace.ix_arr[row];
+        addition.impute_node = (impute_node != SIZE_MAX && input_data.has_missing[addition.row])?
+                                impute_node : SIZE_MAX;
+        if (!model_params.calc_depth && addition.impute_node == SIZE_MAX)
+            continue;
+
+        if (!workspace.weights_arr.empty())
+            w = workspace.weights_arr[addition.row];
+        else if (!workspace.weights_map.empty())
+            w = workspace.weights_map[addition.row];
+        else
+            w = 1;
+        addition.weight = w;
+        addition.depth  = depth_uses_weights? (w * depth) : depth;
+
+        stripe = workspace.row_stripes->get_stripe(addition.row);
+        workspace.row_additions[stripe].push_back(addition);
+        if (workspace.row_additions[stripe].size() >= ROW_SUMS_QUEUE_SIZE)
+            flush_row_sums(workspace, impute_nodes, stripe);
+    }
+}
+
+template <class WorkerMemory>
+void flush_row_sums(WorkerMemory &workspace, std::vector<ImputeNode> *impute_nodes, size_t stripe)
+{
+    std::vector<RowAddition> &queue = workspace.row_additions[stripe];
+    if (queue.empty()) return;
+
+    workspace.row_stripes->lock(stripe);
+    for (const RowAddition &addition : queue)
+    {
+        if (workspace.row_depths != NULL)
+            workspace.row_depths[addition.row] += addition.depth;
+        if (addition.impute_node != SIZE_MAX)
+        {
+            if (!workspace.impute_vec->empty())
+                add_from_impute_node((*impute_nodes)[addition.impute_node],
+                                     (*workspace.impute_vec)[addition.row],
+                                     addition.weight);
+            else
+            {
+                /* Several threads look up rows in this same map while holding different
+                   locks, which is only safe as long as nothing gets inserted into it. All
+                   the rows with missing values were added before fitting, and only those
+                   rows have imputations to add. */
+                auto imputed = workspace.impute_map->find(addition.row);
+                assert(imputed != workspace.impute_map->end());
+                add_from_impute_node((*impute_nodes)[addition.impute_node],
+                                     imputed->second,
+                                     addition.weight);
+            }
+        }
+    }
+    workspace.row_stripes->unlock(stripe);
+    queue.clear();
+}
+
+template <class WorkerMemory>
+void flush_row_sums(WorkerMemory &workspace, std::vector<ImputeNode> *impute_nodes)
+{
+    for (size_t stripe = 0; stripe < workspace.row_additions.size(); stripe++)
+        flush_row_sums(workspace, impute_nodes, stripe);
+}
+
 template <class PredictionData, class sparse_ix>
 void remap_terminal_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                           PredictionData &prediction_data, sparse_ix *restrict tree_num, int nthreads)
@@ -273,10 +377,8 @@ RecursionState::RecursionState(WorkerMemory &workspace, bool full_state)
     this->end              =  workspace.end;
     if (!workspace.col_sampler.has_weights())
         this->sampler_pos  =  workspace.col_sampler.curr_pos;
-    else {
-        this->col_sampler_weights = workspace.col_sampler.tree_weights;
-        this->n_dropped           = workspace.col_sampler.n_dropped;
-    }
+    else
+        this->sampler_log_size =  workspace.col_sampler.get_drop_log_size();
 
     if (this->full_state)
     {
@@ -314,10 +416,8 @@ void RecursionState::restore_state(WorkerMemory &workspace)
     workspace.end              =  this->end;
     if (!workspace.col_sampler.has_weights())
         workspace.col_sampler.curr_pos = this->sampler_pos;
-    else  {
-        workspace.col_sampler.tree_weights  =  std::move(this->col_sampler_weights);
-        workspace.col_sampler.n_dropped     =  this->n_dropped;
-    }
+    else
+        workspace.col_sampler.undo_drops(this->sampler_log_size);
 
     if (this->full_state)
     {
@@ -347,7 +447,8 @@ void RecursionState::restore_state(WorkerMemory &workspace)
 }
 
 template <class InputData, class ldouble_safe>
-std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &model_params, RNG_engine &rnd_generator)
+std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &model_params, RNG_engine &rnd_generator,
+                                           int nthreads)
 {
     std::unique_ptr<double[]> buffer_double;
     std::unique_ptr<size_t[]> buffer_size_t;
@@ -363,53 +464,28 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
 
 
     std::vector<double> kurt_weights(input_data.ncols_numeric + input_data.ncols_categ);
-    for (size_t col = 0; col < input_data.ncols_tot; col++)
+
+    /* numeric columns do not use the RNG, so they can be processed in parallel */
+    #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(input_data, model_params, kurt_weights)
+    for (size_t_for col = 0; col < (size_t_for)input_data.ncols_numeric; col++)
     {
-        if (col < input_data.ncols_numeric)
+        if (input_data.Xc_indptr == NULL)
         {
-            if (input_data.Xc_indptr == NULL)
+            if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
             {
-                if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
-                {
-                    kurt_weights[col]
-                        = calc_kurtosis<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
-                                        input_data.numeric_data + col * input_data.nrows,
-                                        input_data.nrows, model_params.missing_action);
-                }
-
-                else
-                {
-                    kurt_weights[col]
-                        = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.numeric_data)>::type,
-                                                 ldouble_safe>(
-                                                 input_data.numeric_data + col * input_data.nrows, input_data.nrows,
-                                                 model_params.missing_action, input_data.sample_weights);
-                }
+                kurt_weights[col]
+                    = calc_kurtosis<typename std::remove_pointer<decltype(input_data.numeric_data)>::type, ldouble_safe>(
+                                    input_data.numeric_data + col * input_data.nrows,
+                                    input_data.nrows, model_params.missing_action);
             }
 
             else
             {
-                if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
-                {
-                    kurt_weights[col]
-                        = calc_kurtosis<typename std::remove_pointer<decltype(input_data.Xc)>::type,
-                                        typename std::remove_pointer<decltype(input_data.Xc_indptr)>::type,
-                                        ldouble_safe>(
-                                        col, input_data.nrows,
-                                        input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
-                                        model_params.missing_action);
-                }
-
-                else
-                {
-                    kurt_weights[col]
-                        = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.Xc)>::type,
-                                                 typename std::remove_pointer<decltype(input_data.Xc_indptr)>::type,
-                                                 ldouble_safe>(
-                                                 col, input_data.nrows,
-                                                 input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
-                                                 model_params.missing_action, input_data.sample_weights);
-                }
+                kurt_weights[col]
+                    = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.numeric_data)>::type,
+                                             ldouble_safe>(
+                                             input_data.numeric_data + col * input_data.nrows, input_data.nrows,
+                                             model_params.missing_action, input_data.sample_weights);
             }
         }
 
@@ -418,29 +494,54 @@ std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &m
             if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
             {
                 kurt_weights[col]
-                        = calc_kurtosis<ldouble_safe>(input_data.nrows,
-                                        input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
-                                        input_data.ncat[col - input_data.ncols_numeric],
-                                        buffer_size_t.get(), buffer_double.get(),
-                                        model_params.missing_action, model_params.cat_split_type, rnd_generator);
+                    = calc_kurtosis<typename std::remove_pointer<decltype(input_data.Xc)>::type,
+                                    typename std::remove_pointer<decltype(input_data.Xc_indptr)>::type,
+                                    ldouble_safe>(
+                                    col, input_data.nrows,
+                                    input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
+                                    model_params.missing_action);
             }
 
             else
             {
                 kurt_weights[col]
-                        = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.sample_weights)>::type,
-                                                 ldouble_safe>(
-                                                 input_data.nrows,
-                                                 input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
-                                                 input_data.ncat[col - input_data.ncols_numeric],
-                                                 buffer_double.get(),
-                                                 model_params.missing_action, model_params.cat_split_type,
-                                                 rnd_generator, input_data.sample_weights,
-                                                 buffer_ldbl.get());
+                    = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.Xc)>::type,
+                                             typename std::remove_pointer<decltype(input_data.Xc_indptr)>::type,
+                                             ldouble_safe>(
+                                             col, input_data.nrows,
+                                             input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr,
+                                             model_params.missing_action, input_data.sample_weights);
             }
         }
     }
 
+    for (size_t col = input_data.ncols_numeric; col < input_data.ncols_tot; col++)
+    {
+        if (!(input_data.sample_weights != NULL && !input_data.weight_as_sample))
+        {
+            kurt_weights[col]
+                    = calc_kurtosis<ldouble_safe>(input_data.nrows,
+                                    input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
+                                    input_data.ncat[col - input_data.ncols_numeric],
+                                    buffer_size_t.get(), buffer_double.get(),
+                                    model_params.missing_action, model_params.cat_split_type, rnd_generator);
+        }
+
+        else
+        {
+            kurt_weights[col]
+                    = calc_kurtosis_weighted<typename std::remove_pointer<decltype(input_data.sample_weights)>::type,
+                                             ldouble_safe>(
+                                             input_data.nrows,
+                                             input_data.categ_data + (col- input_data.ncols_numeric) * input_data.nrows,
+                                             input_data.ncat[col - input_data.ncols_numeric],
+                                             buffer_double.get(),
+                                             model_params.missing_action, model_params.cat_split_type,
+                                             rnd_generator, input_data.sample_weights,
+                                             buffer_ldbl.get());
+        }
+    }
+
     for (auto &w : kurt_weights) w = (w == -HUGE_VAL)? 0. : std::fmax(1e-8, -1. + w);
     if (input_data.col_weights != NULL)
     {
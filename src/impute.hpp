@@ -159,7 +159,7 @@ void impute_missing_values(real_t numeric_data[], int categ_data[], bool is_col_
         );
     #ifndef NO_LONG_DOUBLE
     else
-        impute_missing_values_internal<real_t, sparse_ix, long double>(
+        impute_missing_values_internal<real_t, sparse_ix, ldouble_ext>(
             numeric_data, categ_data, is_col_major,
             Xr, Xr_ind, Xr_indptr,
             nrows, nthreads,
@@ -515,6 +515,7 @@ void build_impute_node(ImputeNode &imputer,    WorkerMemory &workspace,
     {
         size_t *ix_arr = workspace.ix_arr.data();
         size_t st_col, end_col, ind_end_col, curr_pos;
+        bool gallop;
         std::fill(imputer.num_weight.begin(), imputer.num_weight.end(), wsum);
 
         for (size_t col = 0; col < input_data.ncols_numeric; col++)
@@ -523,6 +524,7 @@ void build_impute_node(ImputeNode &imputer,    WorkerMemory &workspace,
             end_col     =  input_data.Xc_indptr[col + 1] - 1;
             ind_end_col =  input_data.Xc_ind[end_col];
             curr_pos    =  st_col;
+            gallop      =  prefer_galloping(workspace.end - workspace.st + 1, end_col - st_col + 1);
             for (size_t *row = std::lower_bound(ix_arr + workspace.st, ix_arr + workspace.end + 1, input_data.Xc_ind[st_col]);
                  row != ix_arr + workspace.end + 1 && curr_pos != end_col + 1 && ind_end_col >= *row;
                 )
@@ -548,15 +550,15 @@ void build_impute_node(ImputeNode &imputer,    WorkerMemory &workspace,
                     }
 
                     if (row == ix_arr + workspace.end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(input_data.Xc_ind + curr_pos, input_data.Xc_ind + end_col + 1, *(++row)) - input_data.Xc_ind;
+                    curr_pos = advance_sorted(input_data.Xc_ind + curr_pos, input_data.Xc_ind + end_col + 1, *(++row), gallop) - input_data.Xc_ind;
                 }
 
                 else
                 {
                     if (input_data.Xc_ind[curr_pos] > static_cast<typename std::remove_pointer<decltype(input_data.Xc_ind)>::type>(*row))
-                        row = std::lower_bound(row + 1, ix_arr + workspace.end + 1, input_data.Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + workspace.end + 1, input_data.Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(input_data.Xc_ind + curr_pos + 1, input_data.Xc_ind + end_col + 1, *row) - input_data.Xc_ind;
+                        curr_pos = advance_sorted(input_data.Xc_ind + curr_pos + 1, input_data.Xc_ind + end_col + 1, *row, gallop) - input_data.Xc_ind;
                 }
             }
 
@@ -773,57 +775,6 @@ void drop_nonterminal_imp_node(std::vector<ImputeNode>  &imputer_tree,
     imputer_tree.shrink_to_fit();
 }
 
-template <class ImputedData>
-void combine_imp_single(ImputedData &restrict imp_addfrom, ImputedData &restrict imp_addto)
-{
-    size_t col;
-    for (size_t ix = 0; ix < imp_addfrom.n_missing_num; ix++)
-    {
-        imp_addto.num_sum[ix]    += imp_addfrom.num_sum[ix];
-        imp_addto.num_weight[ix] += imp_addfrom.num_weight[ix];
-    }
-
-    for (size_t ix = 0; ix < imp_addfrom.n_missing_cat; ix++)
-    {
-        col = imp_addfrom.missing_cat[ix];
-        for (size_t cat = 0; cat < imp_addto.cat_sum[col].size(); cat++)
-        {
-            imp_addto.cat_sum[col][cat] += imp_addfrom.cat_sum[col][cat];
-        }
-    }
-
-    for (size_t ix = 0; ix < imp_addfrom.n_missing_sp; ix++)
-    {
-        imp_addto.sp_num_sum[ix]    += imp_addfrom.sp_num_sum[ix];
-        imp_addto.sp_num_weight[ix] += imp_addfrom.sp_num_weight[ix];
-    }
-}
-
-template <class ImputedData, class WorkerMemory>
-void combine_tree_imputations(WorkerMemory &workspace,
-                              std::vector<ImputedData> &impute_vec,
-                              hashed_map<size_t, ImputedData> &impute_map,
-                              std::vector<char> &has_missing,
-                              int nthreads)
-{
-    if (workspace.impute_vec.size())
-    {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(has_missing, workspace, impute_vec)
-        for (size_t_for row = 0; row < (decltype(row))has_missing.size(); row++)
-            if (has_missing[row])
-                combine_imp_single(workspace.impute_vec[row], impute_vec[row]);
-    }
-
-    else if (workspace.impute_map.size())
-    {
-        #pragma omp parallel for schedule(dynamic) num_threads(nthreads) shared(has_missing, workspace, impute_map)
-        for (size_t_for row = 0; row < (decltype(row))has_missing.size(); row++)
-            if (has_missing[row])
-                combine_imp_single(workspace.impute_map[row], impute_map[row]);
-    }
-}
-
-
 template <class ImputedData>
 void add_from_impute_node(ImputeNode &imputer, ImputedData &imputed_data, double w)
 {
@@ -851,70 +802,6 @@ void add_from_impute_node(ImputeNode &imputer, ImputedData &imputed_data, double
 }
 
 
-template <class InputData, class WorkerMemory>
-void add_from_impute_node(ImputeNode &imputer, WorkerMemory &workspace, InputData &input_data)
-{
-    if (workspace.impute_vec.size())
-    {
-        if (!workspace.weights_arr.size() && !workspace.weights_map.size())
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_vec[workspace.ix_arr[row]],
-                                         (double)1);
-        }
-
-        else if (workspace.weights_arr.size())
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_vec[workspace.ix_arr[row]],
-                                         workspace.weights_arr[workspace.ix_arr[row]]);
-        }
-
-        else
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_vec[workspace.ix_arr[row]],
-                                         workspace.weights_map[workspace.ix_arr[row]]);
-        }
-    }
-
-    else if (workspace.impute_map.size())
-    {
-        if (!workspace.weights_arr.size() && !workspace.weights_map.size())
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_map[workspace.ix_arr[row]],
-                                         (double)1);
-        }
-
-        else if (workspace.weights_arr.size())
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_map[workspace.ix_arr[row]],
-                                         workspace.weights_arr[workspace.ix_arr[row]]);
-        }
-
-        else
-        {
-            for (size_t row = workspace.st; row <= workspace.end;  row++)
-                if (input_data.has_missing[workspace.ix_arr[row]])
-                    add_from_impute_node(imputer,
-                                         workspace.impute_map[workspace.ix_arr[row]],
-                                         workspace.weights_map[workspace.ix_arr[row]]);
-        }
-    }
-}
-
 template <class imp_arr, class InputData>
 void apply_imputation_results(imp_arr    &impute_vec,
                               Imputer    &imputer,
@@ -61,6 +61,53 @@
 *     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+ISOTREE_EXPORTED int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                real_t numeric_data[],  size_t ncols_numeric,
+                int    categ_data[],    size_t ncols_categ,    int ncat[],
+                real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                real_t sample_weights[], bool with_replacement, bool weight_as_sample,
+                size_t nrows, size_t sample_size, size_t ntrees,
+                size_t max_depth,   size_t ncols_per_tree,
+                bool   limit_depth, bool penalize_range, bool standardize_data,
+                ScoringMetric scoring_metric, bool fast_bratio,
+                bool   standardize_dist, double tmat[],
+                double output_depths[], bool standardize_depth,
+                real_t col_weights[], bool weigh_by_kurt,
+                double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                double prob_pick_by_full_gain, double prob_pick_by_dens,
+                double prob_pick_col_by_range, double prob_pick_col_by_var,
+                double prob_pick_col_by_kurt,
+                double min_gain, MissingAction missing_action,
+                CategSplit cat_split_type, NewCategAction new_cat_action,
+                bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
+                uint64_t random_seed, bool use_long_double, int nthreads, size_t max_memory)
+{
+    return fit_iforest<real_t, sparse_ix>
+               (model_outputs, model_outputs_ext,
+                numeric_data,  ncols_numeric,
+                categ_data,    ncols_categ,    ncat,
+                Xc, Xc_ind, Xc_indptr,
+                ndim, ntry, coef_type, coef_by_prop,
+                sample_weights, with_replacement, weight_as_sample,
+                nrows, sample_size, ntrees,
+                max_depth,   ncols_per_tree,
+                limit_depth, penalize_range, standardize_data,
+                scoring_metric, fast_bratio,
+                standardize_dist, tmat,
+                output_depths, standardize_depth,
+                col_weights, weigh_by_kurt,
+                prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+                prob_pick_by_full_gain, prob_pick_by_dens,
+                prob_pick_col_by_range, prob_pick_col_by_var,
+                prob_pick_col_by_kurt,
+                min_gain, missing_action,
+                cat_split_type, new_cat_action,
+                all_perm, imputer, min_imp_obs,
+                depth_imp, weigh_imp_rows, impute_at_fit,
+                random_seed, use_long_double, nthreads, max_memory);
+}
 ISOTREE_EXPORTED int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
                 int    categ_data[],    size_t ncols_categ,    int ncat[],
@@ -106,7 +153,7 @@ ISOTREE_EXPORTED int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_o
                 cat_split_type, new_cat_action,
                 all_perm, imputer, min_imp_obs,
                 depth_imp, weigh_imp_rows, impute_at_fit,
-                random_seed, use_long_double, nthreads);
+                random_seed, use_long_double, nthreads, (size_t)0);
 }
 ISOTREE_EXPORTED int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t numeric_data[],  size_t ncols_numeric,
@@ -157,6 +204,148 @@ ISOTREE_EXPORTED int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outp
              ref_Xc, ref_Xc_ind, ref_Xc_indptr,
              random_seed, use_long_double);
 }
+ISOTREE_EXPORTED int replace_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t tree_num,
+                 real_t numeric_data[],  size_t ncols_numeric,
+                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                 real_t sample_weights[], size_t nrows,
+                 size_t max_depth,     size_t ncols_per_tree,
+                 bool   limit_depth,   bool penalize_range, bool standardize_data,
+                 bool   fast_bratio,
+                 real_t col_weights[], bool weigh_by_kurt,
+                 double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                 double prob_pick_by_full_gain, double prob_pick_by_dens,
+                 double prob_pick_col_by_range, double prob_pick_col_by_var,
+                 double prob_pick_col_by_kurt,
+                 double min_gain, MissingAction missing_action,
+                 CategSplit cat_split_type, NewCategAction new_cat_action,
+                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                 TreesIndexer *indexer,
+                 real_t ref_numeric_data[], int ref_categ_data[],
+                 bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+                 real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+                 uint64_t random_seed, bool use_long_double)
+{
+    return replace_tree<real_t, sparse_ix>
+            (model_outputs, model_outputs_ext, tree_num,
+             numeric_data,  ncols_numeric,
+             categ_data,    ncols_categ,    ncat,
+             Xc, Xc_ind, Xc_indptr,
+             ndim, ntry, coef_type, coef_by_prop,
+             sample_weights, nrows,
+             max_depth,     ncols_per_tree,
+             limit_depth,   penalize_range, standardize_data,
+             fast_bratio,
+             col_weights, weigh_by_kurt,
+             prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+             prob_pick_by_full_gain, prob_pick_by_dens,
+             prob_pick_col_by_range, prob_pick_col_by_var,
+             prob_pick_col_by_kurt,
+             min_gain, missing_action,
+             cat_split_type, new_cat_action,
+             depth_imp, weigh_imp_rows,
+             all_perm, imputer, min_imp_obs,
+             indexer,
+             ref_numeric_data, ref_categ_data,
+             ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+             ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+             random_seed, use_long_double);
+}
+ISOTREE_EXPORTED int add_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
+              real_t numeric_data[],  size_t ncols_numeric,
+              int    categ_data[],    size_t ncols_categ,    int ncat[],
+              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+              size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+              real_t sample_weights[], size_t nrows,
+              size_t max_depth,     size_t ncols_per_tree,
+              bool   limit_depth,   bool penalize_range, bool standardize_data,
+              bool   fast_bratio,
+              real_t col_weights[], bool weigh_by_kurt,
+              double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+              double prob_pick_by_full_gain, double prob_pick_by_dens,
+              double prob_pick_col_by_range, double prob_pick_col_by_var,
+              double prob_pick_col_by_kurt,
+              double min_gain, MissingAction missing_action,
+              CategSplit cat_split_type, NewCategAction new_cat_action,
+              UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+              bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+              TreesIndexer *indexer,
+              real_t ref_numeric_data[], int ref_categ_data[],
+              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+              uint64_t random_seed, bool use_long_double, int nthreads)
+{
+    return add_trees<real_t, sparse_ix>
+            (model_outputs, model_outputs_ext, ntrees,
+             numeric_data,  ncols_numeric,
+             categ_data,    ncols_categ,    ncat,
+             Xc, Xc_ind, Xc_indptr,
+             ndim, ntry, coef_type, coef_by_prop,
+             sample_weights, nrows,
+             max_depth,     ncols_per_tree,
+             limit_depth,   penalize_range, standardize_data,
+             fast_bratio,
+             col_weights, weigh_by_kurt,
+             prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+             prob_pick_by_full_gain, prob_pick_by_dens,
+             prob_pick_col_by_range, prob_pick_col_by_var,
+             prob_pick_col_by_kurt,
+             min_gain, missing_action,
+             cat_split_type, new_cat_action,
+             depth_imp, weigh_imp_rows,
+             all_perm, imputer, min_imp_obs,
+             indexer,
+             ref_numeric_data, ref_categ_data,
+             ref_is_col_major, ref_ld_numeric, ref_ld_categ,
+             ref_Xc, ref_Xc_ind, ref_Xc_indptr,
+             random_seed, use_long_double, nthreads);
+}
+#ifndef _NO_SPARSE_IX
+ISOTREE_EXPORTED int fit_iforest_from_rows(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          bool (*next_row)(void *row_source, real_t numeric_row[], int categ_row[], real_t *row_weight),
+                          void *row_source,
+                          size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          bool use_weights, bool weight_as_sample,
+                          size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          real_t col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, bool use_long_double, int nthreads)
+{
+    return fit_iforest_from_rows<real_t>
+                         (model_outputs, model_outputs_ext,
+                          next_row, row_source,
+                          ncols_numeric, ncols_categ, ncat,
+                          ndim, ntry, coef_type, coef_by_prop,
+                          use_weights, weight_as_sample,
+                          sample_size, ntrees,
+                          max_depth,   ncols_per_tree,
+                          limit_depth, penalize_range, standardize_data,
+                          scoring_metric, fast_bratio,
+                          col_weights, weigh_by_kurt,
+                          prob_pick_by_gain_pl, prob_pick_by_gain_avg,
+                          prob_pick_by_full_gain, prob_pick_by_dens,
+                          prob_pick_col_by_range, prob_pick_col_by_var,
+                          prob_pick_col_by_kurt,
+                          min_gain, missing_action,
+                          cat_split_type, new_cat_action,
+                          all_perm, imputer, min_imp_obs,
+                          depth_imp, weigh_imp_rows,
+                          random_seed, use_long_double, nthreads);
+}
+#endif
 ISOTREE_EXPORTED void predict_iforest(real_t numeric_data[], int categ_data[],
                      bool is_col_major, size_t ncols_numeric, size_t ncols_categ,
                      real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
@@ -72,13 +72,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 {
     if (interrupt_switch) return;
     ldouble_safe sum_weight = -HUGE_VAL;
+    workspace.node_cat_split.clear();
 
     /* calculate imputation statistics if desired */
     if (impute_nodes != NULL)
     {
         if (input_data.Xc_indptr != NULL)
-            std::sort(workspace.ix_arr.begin() + workspace.st,
-                      workspace.ix_arr.begin() + workspace.end + 1);
+            sort_ix_arr(workspace.ix_arr.data(), workspace.st, workspace.end);
         build_impute_node<decltype(input_data), decltype(workspace), ldouble_safe>(
                           impute_nodes->back(), workspace,
                           input_data, model_params,
@@ -106,7 +106,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
     /* for sparse matrices, need to sort the indices */
     if (input_data.Xc_indptr != NULL && impute_nodes == NULL)
-        std::sort(workspace.ix_arr.begin() + workspace.st, workspace.ix_arr.begin() + workspace.end + 1);
+        sort_ix_arr(workspace.ix_arr.data(), workspace.st, workspace.end);
 
     /* pick column to split according to criteria */
     workspace.prob_split_type = workspace.rbin(workspace.rnd_generator);
@@ -647,7 +647,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                             case SubSet:
                             {
-                                trees.back().cat_split.assign(workspace.this_split_categ.begin(),
+                                workspace.node_cat_split.assign(workspace.this_split_categ.begin(),
                                                               workspace.this_split_categ.begin()
                                                                 + input_data.ncat[trees.back().col_num]);
                                 break;
@@ -909,11 +909,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         if (input_data.Xc_indptr == NULL)
             divide_subset_split(workspace.ix_arr.data(), input_data.numeric_data + input_data.nrows * trees.back().col_num,
                                 workspace.st, workspace.end, trees.back().num_split, model_params.missing_action,
-                                workspace.st_NA, workspace.end_NA, workspace.split_ix);
+                                workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                                workspace.buffer_ix.data());
         else
             divide_subset_split(workspace.ix_arr.data(), workspace.st, workspace.end, trees.back().col_num,
                                 input_data.Xc, input_data.Xc_ind, input_data.Xc_indptr, trees.back().num_split,
-                                model_params.missing_action, workspace.st_NA, workspace.end_NA, workspace.split_ix);
+                                model_params.missing_action, workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                                workspace.buffer_ix.data());
     } 
 
     /* for categorical, there are different ways of splitting */
@@ -925,9 +927,9 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
             trees.back().chosen_cat = 0;
             divide_subset_split(workspace.ix_arr.data(), input_data.categ_data + input_data.nrows * trees.back().col_num,
                                 workspace.st, workspace.end, (int)0, model_params.missing_action,
-                                workspace.st_NA, workspace.end_NA, workspace.split_ix);
-            trees.back().cat_split.clear();
-            trees.back().cat_split.shrink_to_fit();
+                                workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                                workspace.buffer_ix.data());
+            workspace.node_cat_split.clear();
         }
 
         /* otherwise, split according to desired type (single/subset) */
@@ -999,7 +1001,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                     divide_subset_split(workspace.ix_arr.data(), input_data.categ_data + input_data.nrows * trees.back().col_num,
                                         workspace.st, workspace.end, trees.back().chosen_cat, model_params.missing_action,
-                                        workspace.st_NA, workspace.end_NA, workspace.split_ix);
+                                        workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                                        workspace.buffer_ix.data());
                     break;
                 }
 
@@ -1030,13 +1033,13 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                     }
                                 }
 
-                                trees.back().cat_split.assign(workspace.categs.begin(), workspace.categs.begin() + input_data.ncat[trees.back().col_num]);
+                                workspace.node_cat_split.assign(workspace.categs.begin(), workspace.categs.begin() + input_data.ncat[trees.back().col_num]);
                                 break; /* NoCrit */
                             }
 
                             default:
                             {
-                                trees.back().cat_split.resize(input_data.ncat[trees.back().col_num]);
+                                workspace.node_cat_split.resize(input_data.ncat[trees.back().col_num]);
                                 if (!workspace.changed_weights)
                                     workspace.this_gain =
                                         eval_guided_crit<ldouble_safe>(
@@ -1044,7 +1047,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                          input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                          &workspace.best_cat_mode,
                                                          workspace.buffer_szt.data(), workspace.buffer_szt.data() + input_data.max_categ,
-                                                         workspace.buffer_dbl.data(), trees.back().chosen_cat, trees.back().cat_split.data(),
+                                                         workspace.buffer_dbl.data(), trees.back().chosen_cat, workspace.node_cat_split.data(),
                                                          workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                          model_params.all_perm, model_params.missing_action, model_params.cat_split_type);
                                 else if (!workspace.weights_arr.empty())
@@ -1054,7 +1057,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, trees.back().cat_split.data(),
+                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, workspace.node_cat_split.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_arr,
@@ -1066,7 +1069,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                                   input_data.categ_data + trees.back().col_num * input_data.nrows, input_data.ncat[trees.back().col_num],
                                                                   &workspace.best_cat_mode,
                                                                   workspace.buffer_szt.data(),
-                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, trees.back().cat_split.data(),
+                                                                  workspace.buffer_dbl.data(), trees.back().chosen_cat, workspace.node_cat_split.data(),
                                                                   workspace.buffer_chr.data(), workspace.criterion, model_params.min_gain,
                                                                   model_params.all_perm, model_params.missing_action, model_params.cat_split_type,
                                                                   workspace.weights_map,
@@ -1083,17 +1086,18 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                     {
                         if (model_params.scoring_metric == Density)
                         {
-                            workspace.density_calculator.save_n_present_and_left(trees.back().cat_split.data(), input_data.ncat[trees.back().col_num]);
+                            workspace.density_calculator.save_n_present_and_left(workspace.node_cat_split.data(), input_data.ncat[trees.back().col_num]);
                         }
 
                         for (int cat = 0; cat < input_data.ncat[trees.back().col_num]; cat++)
-                            if (trees.back().cat_split[cat] < 0)
-                                trees.back().cat_split[cat] = workspace.rbin(workspace.rnd_generator) < 0.5;
+                            if (workspace.node_cat_split[cat] < 0)
+                                workspace.node_cat_split[cat] = workspace.rbin(workspace.rnd_generator) < 0.5;
                     }
 
                     divide_subset_split(workspace.ix_arr.data(), input_data.categ_data + input_data.nrows * trees.back().col_num,
-                                        workspace.st, workspace.end, trees.back().cat_split.data(), model_params.missing_action,
-                                        workspace.st_NA, workspace.end_NA, workspace.split_ix);
+                                        workspace.st, workspace.end, workspace.node_cat_split.data(), model_params.missing_action,
+                                        workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                                        workspace.buffer_ix.data());
                 }
 
             }
@@ -1113,7 +1117,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         /* if it split by a categorical variable with only 2 values,
            the column will no longer be splittable in either branch */
         if (trees.back().col_type == Categorical &&
-            ((model_params.cat_split_type == SubSet && trees.back().cat_split.empty()) ||
+            ((model_params.cat_split_type == SubSet && workspace.node_cat_split.empty()) ||
              (model_params.cat_split_type == SingleCateg && input_data.ncat[trees.back().col_num] == 2)))
         {
             workspace.col_sampler.drop_col(trees.back().col_num + input_data.ncols_numeric,
@@ -1141,10 +1145,10 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                 else
                 {
-                    if (trees.back().cat_split.empty())
+                    if (workspace.node_cat_split.empty())
                         move_NAs_left = workspace.best_cat_mode == trees.back().chosen_cat;
                     else
-                        move_NAs_left = trees.back().cat_split[workspace.best_cat_mode] == 1;
+                        move_NAs_left = workspace.node_cat_split[workspace.best_cat_mode] == 1;
                 }
 
                 if (move_NAs_left)
@@ -1324,7 +1328,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                         {
                             if (model_params.scoring_metric == Density)
                             {
-                                if (!trees.back().cat_split.size())
+                                if (!workspace.node_cat_split.size())
                                 {
                                     workspace.density_calculator.push_density();
                                 }
@@ -1339,7 +1343,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                             else
                             {
-                                if (!trees.back().cat_split.size())
+                                if (!workspace.node_cat_split.size())
                                 {
                                     workspace.density_calculator.push_adj(trees.back().pct_tree_left,
                                                                           model_params.scoring_metric);
@@ -1355,7 +1359,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                                          input_data.categ_data + trees.back().col_num * input_data.nrows,
                                                          input_data.ncat[trees.back().col_num],
                                                          workspace.density_calculator.counts.data());
-                                            workspace.density_calculator.push_adj(trees.back().cat_split.data(),
+                                            workspace.density_calculator.push_adj(workspace.node_cat_split.data(),
                                                                                   workspace.density_calculator.counts.data(),
                                                                                   input_data.ncat[trees.back().col_num],
                                                                                   model_params.scoring_metric);
@@ -1363,7 +1367,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                                         else
                                         {
-                                            workspace.density_calculator.push_adj(trees.back().cat_split.data(),
+                                            workspace.density_calculator.push_adj(workspace.node_cat_split.data(),
                                                                                   workspace.buffer_szt.data(),
                                                                                   input_data.ncat[trees.back().col_num],
                                                                                   model_params.scoring_metric);
@@ -1372,7 +1376,7 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                                     else
                                     {
-                                        workspace.density_calculator.push_adj(trees.back().cat_split.data(),
+                                        workspace.density_calculator.push_adj(workspace.node_cat_split.data(),
                                                                               workspace.density_calculator.counts.data(),
                                                                               input_data.ncat[trees.back().col_num],
                                                                               model_params.scoring_metric);
@@ -1414,14 +1418,14 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
 
                         case SubSet:
                         {
-                            if (trees.back().cat_split.empty())
+                            if (workspace.node_cat_split.empty())
                             {
                                 workspace.density_calculator.push_bdens((int)1, trees.back().col_num);
                             }
 
                             else
                             {
-                                workspace.density_calculator.push_bdens(trees.back().cat_split, trees.back().col_num);
+                                workspace.density_calculator.push_bdens(workspace.node_cat_split, trees.back().col_num);
                             }
                             break;
                         }
@@ -1446,8 +1450,8 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         {
             bool new_to_left = trees.back().pct_tree_left < 0.5;
             for (int cat = 0; cat < input_data.ncat[trees.back().col_num]; cat++)
-                if (trees.back().cat_split[cat] < 0)
-                    trees.back().cat_split[cat] = new_to_left;
+                if (workspace.node_cat_split[cat] < 0)
+                    workspace.node_cat_split[cat] = new_to_left;
         }
 
         /* If doing single-category splits, the branch that got only one category will not
@@ -1461,6 +1465,9 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                                            workspace.end - workspace.st + 1);
         }
 
+        if (trees.back().col_type == Categorical && model_params.cat_split_type == SubSet && !workspace.node_cat_split.empty())
+            set_cat_split(trees.back(), workspace.node_cat_split.data(), input_data.ncat[trees.back().col_num]);
+
         /* left branch */
         trees.back().tree_left = trees.size();
         trees.emplace_back();
@@ -1637,9 +1644,6 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
             }
         }
 
-        trees.back().cat_split.clear();
-        trees.back().cat_split.shrink_to_fit();
-
         trees.back().remainder = workspace.changed_weights?
                                     (double)sum_weight : (double)(workspace.end - workspace.st + 1);
 
@@ -1647,31 +1651,159 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
         if (model_params.calc_dist)
             add_remainder_separation_steps<InputData, WorkerMemory, ldouble_safe>(workspace, input_data, sum_weight);
 
-        /* add this depth right away if requested */
-        if (!workspace.row_depths.empty())
+        /* add this depth and the imputations from this node right away if requested */
+        if (model_params.calc_depth || model_params.impute_at_fit)
+            add_terminal_to_row_sums(workspace, input_data, model_params, impute_nodes, trees.back().score, true);
+    }
+
+}
+
+/* Builder for the most common configuration, in which all columns are dense and numeric, there
+   are no row or column weights, no imputer, the metric is 'Depth', and both the column and the
+   split point are chosen uniformly at random. It produces the same trees as the general function
+   above (draws the same random numbers in the same order), but without the per-node checks for
+   everything that cannot happen here. The missing action is passed as a template parameter so
+   that the handling of NAs gets resolved at compile time. Whether a tree can be built with it
+   is determined by 'is_plain_numeric_itree' in 'helpers_iforest.hpp'. */
+template <class InputData, class WorkerMemory, class ldouble_safe, MissingAction missing_action>
+void split_itree_recursive_numeric(std::vector<IsoTree>     &trees,
+                                   WorkerMemory             &workspace,
+                                   InputData                &input_data,
+                                   ModelParams              &model_params,
+                                   size_t                   curr_depth)
+{
+    static_assert(missing_action == Fail || missing_action == Impute, "Unsupported missing action.");
+    if (interrupt_switch) return;
+
+    if (workspace.end == workspace.st || (workspace.end - workspace.st) == 1 || curr_depth >= model_params.max_depth)
+        goto terminal_statistics;
+
+    if (!workspace.col_sampler.get_remaining_cols())
+        goto terminal_statistics;
+
+    /* the general function draws one number to choose the split criterion and another one
+       to choose the column criterion, which need to be consumed here too */
+    workspace.rbin(workspace.rnd_generator);
+    if (workspace.col_sampler.get_remaining_cols() > 1)
+        workspace.rbin(workspace.rnd_generator);
+
+    while (workspace.col_sampler.sample_col(trees.back().col_num, workspace.rnd_generator))
+    {
+        if (interrupt_switch) return;
+
+        get_range(workspace.ix_arr.data(), input_data.numeric_data + input_data.nrows * trees.back().col_num,
+                  workspace.st, workspace.end, missing_action,
+                  workspace.xmin, workspace.xmax, workspace.unsplittable);
+        if (workspace.unsplittable)
+            workspace.col_sampler.drop_col(trees.back().col_num);
+        else
+            goto produce_split;
+    }
+    goto terminal_statistics;
+
+    produce_split:
+    {
+        trees.back().col_type = Numeric;
+        trees.back().num_split = sample_random_uniform(workspace.xmin, workspace.xmax, workspace.rnd_generator);
+        if (model_params.penalize_range)
         {
-            if (!workspace.changed_weights)
-            {
-                for (size_t row = workspace.st; row <= workspace.end; row++)
-                    workspace.row_depths[workspace.ix_arr[row]] += trees.back().score;
-            }
+            trees.back().range_low  = workspace.xmin - workspace.xmax + trees.back().num_split;
+            trees.back().range_high = workspace.xmax - workspace.xmin + trees.back().num_split;
+        }
 
-            else if (!workspace.weights_arr.empty())
-            {
-                for (size_t row = workspace.st; row <= workspace.end; row++)
-                    workspace.row_depths[workspace.ix_arr[row]] += workspace.weights_arr[workspace.ix_arr[row]] * trees.back().score;
-            }
+        if (missing_action == Fail && std::isnan(trees.back().num_split))
+            throw std::runtime_error("Data has missing values. Try using a different value for 'missing_action'.\n");
+
+        divide_subset_split(workspace.ix_arr.data(), input_data.numeric_data + input_data.nrows * trees.back().col_num,
+                            workspace.st, workspace.end, trees.back().num_split, missing_action,
+                            workspace.st_NA, workspace.end_NA, workspace.split_ix,
+                            workspace.buffer_ix.data());
+    }
+
+    {
+        if (model_params.calc_dist && curr_depth > 0)
+            add_separation_step(workspace, input_data, (double)(-1));
+
+        /* nothing here needs to be copied, so the state is kept in the stack instead of
+           going through 'RecursionState' */
+        size_t tree_from = trees.size() - 1;
+        size_t saved_end = workspace.end;
+        size_t saved_st_NA = workspace.st_NA;
+        size_t saved_end_NA = workspace.end_NA;
+        size_t saved_split_ix = workspace.split_ix;
+        size_t saved_sampler_pos = workspace.col_sampler.curr_pos;
+        trees.back().score = -1;
+
+        if (missing_action == Fail)
+        {
+            trees.back().pct_tree_left = (ldouble_safe) (workspace.split_ix - workspace.st)
+                                            /
+                                         (ldouble_safe) (workspace.end - workspace.st + 1);
+            workspace.end = workspace.split_ix - 1;
+        }
 
+        else
+        {
+            trees.back().pct_tree_left = (ldouble_safe)(workspace.st_NA - workspace.st)
+                                            /
+                                         (ldouble_safe)(workspace.end - workspace.st + 1 - (workspace.end_NA - workspace.st_NA));
+            if (trees.back().pct_tree_left >= .5)
+                workspace.end = workspace.end_NA - 1;
             else
-            {
-                for (size_t row = workspace.st; row <= workspace.end; row++)
-                    workspace.row_depths[workspace.ix_arr[row]] += workspace.weights_map[workspace.ix_arr[row]] * trees.back().score;
-            }
+                workspace.end = workspace.st_NA - 1;
+        }
+
+        /* left branch */
+        trees.back().tree_left = trees.size();
+        trees.emplace_back();
+        split_itree_recursive_numeric<InputData, WorkerMemory, ldouble_safe, missing_action>(
+                                      trees,
+                                      workspace,
+                                      input_data,
+                                      model_params,
+                                      curr_depth + 1);
+
+        /* right branch */
+        workspace.end = saved_end;
+        workspace.split_ix = saved_split_ix;
+        workspace.col_sampler.curr_pos = saved_sampler_pos;
+        if (missing_action == Fail)
+        {
+            workspace.st = workspace.split_ix;
+        }
+
+        else
+        {
+            workspace.st_NA = saved_st_NA;
+            workspace.end_NA = saved_end_NA;
+            if (trees[tree_from].pct_tree_left >= .5)
+                workspace.st = workspace.end_NA;
+            else
+                workspace.st = workspace.st_NA;
         }
 
-        /* add imputations from node if requested */
-        if (model_params.impute_at_fit)
-            add_from_impute_node(impute_nodes->back(), workspace, input_data);
+        trees[tree_from].tree_right = trees.size();
+        trees.emplace_back();
+        split_itree_recursive_numeric<InputData, WorkerMemory, ldouble_safe, missing_action>(
+                                      trees,
+                                      workspace,
+                                      input_data,
+                                      model_params,
+                                      curr_depth + 1);
     }
+    return;
 
+    terminal_statistics:
+    {
+        trees.back().tree_left = 0;
+        trees.back().score = curr_depth + expected_avg_depth<ldouble_safe>(workspace.end - workspace.st + 1);
+        trees.back().remainder = (double)(workspace.end - workspace.st + 1);
+
+        if (model_params.calc_dist)
+            add_remainder_separation_steps<InputData, WorkerMemory, ldouble_safe>(workspace, input_data, (ldouble_safe)(-HUGE_VAL));
+
+        if (model_params.calc_depth)
+            add_terminal_to_row_sums(workspace, input_data, model_params,
+                                     (std::vector<ImputeNode>*)NULL, trees.back().score, true);
+    }
 }
@@ -243,10 +243,30 @@ using std::memcpy;
 /* MSVC doesn't support long doubles, so this avoids unnecessarily increasing library size.
    MinGW supports them but has issues with their computations.
    See https://sourceforge.net/p/mingw-w64/bugs/909/ */
-#if defined(_WIN32) && !defined(NO_LONG_DOUBLE)
+#if defined(_WIN32) && !defined(NO_LONG_DOUBLE) && !defined(USE_DOUBLE_DOUBLE)
     #define NO_LONG_DOUBLE
 #endif
 
+/* Type used for the calculations with extended precision ('use_long_double=true'). If compiling
+   with 'USE_DOUBLE_DOUBLE', will use a double-double type instead of 'long double', which is
+   faster in platforms in which 'long double' is a software-emulated type, and provides extended
+   precision in platforms in which 'long double' is the same as 'double'. On x86, it is slower
+   than the x87 'long double'. */
+#ifdef USE_DOUBLE_DOUBLE
+    #include "double_double.hpp"
+    #define ldouble_ext DoubleDouble
+#else
+    #define ldouble_ext long double
+#endif
+
+/* The partitions of rows, the statistics of the values at each node, the traversal of trees in
+   predictions and the accumulation of distances can use vector instructions, through kernels that
+   are compiled separately for each instruction set and chosen at runtime according to the CPU. */
+#include "simd_kernels.hpp"
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+#endif
+
 
 /* Aliasing for compiler optimizations */
 #if defined(__GNUG__) || defined(__GNUC__) || defined(_MSC_VER) || defined(__clang__) || defined(__INTEL_COMPILER) || defined(__IBMCPP__) || defined(__ibmxl__) || defined(SUPPORTS_RESTRICT)
@@ -312,6 +332,24 @@ using std::memcpy;
 /* Some aggregation functions will prefer more precise data types when the data is large */
 #define THRESHOLD_LONG_DOUBLE (size_t)1e6
 
+/* Largest number of categories present in a node for which 'all_perm' evaluates every possible subset
+   as a split - with more than this, categories are sorted by frequency and split in that order instead */
+#ifndef MAX_CATEG_ALL_PERM
+    #define MAX_CATEG_ALL_PERM (size_t)16
+#endif
+
+/* Upper limit on the number of values (rows x columns) in the copy of a tree's sampled rows
+   that each thread can make - larger samples are fit directly from the input data */
+#define TREE_SAMPLE_MAX_SIZE ((size_t)1 << 23)
+
+/* Number of lock-guarded stripes into which rows are divided for per-row sums at fit time,
+   and how many additions each thread queues for a stripe before taking its lock */
+#define ROW_SUMS_NSTRIPES (size_t)256
+#define ROW_SUMS_QUEUE_SIZE (size_t)64
+
+/* Number of rows for which each tree is traversed at once when predicting with vector instructions */
+#define SIMD_PREDICT_BLOCK 256
+
 /* Types used through the package */
 typedef enum  NewCategAction {Weighted=0,  Smallest=11,    Random=12}  NewCategAction; /* Weighted means Impute in the extended model */
 typedef enum  MissingAction  {Divide=21,   Impute=22,      Fail=0}     MissingAction;  /* Divide is only for non-extended model */
@@ -344,8 +382,9 @@ typedef struct IsoTree {
     ColType  col_type = NotUsed; /* issues with uninitialized values when serializing */
     size_t   col_num;
     double   num_split;
-    std::vector<signed char> cat_split;
+    std::vector<uint64_t> cat_split; /* packed bitset, see 'get_cat_split' */
     int      chosen_cat;
+    int      ncat_split = 0; /* number of categories covered by 'cat_split' */
     size_t   tree_left;
     size_t   tree_right;
     double   pct_tree_left;
@@ -357,6 +396,72 @@ typedef struct IsoTree {
     IsoTree() = default;
 } IsoTree;
 
+/* Splits by subsets of categories are stored as bitsets: the first 'ncat_split' bits tell whether
+   each category goes to the left branch, and when using new_cat_action='Weighted', there might be
+   a second group of 'ncat_split' bits (starting at the next word) marking the categories that
+   were not present in the node when the split was made, which are sent to both branches.
+   An empty 'cat_split' (with 'ncat_split' = 0) means that the column had only two categories. */
+#define CAT_SPLIT_WORD_BITS 64
+
+static inline size_t cat_split_nwords(int ncat)
+{
+    return ((size_t)ncat + (CAT_SPLIT_WORD_BITS - 1)) / CAT_SPLIT_WORD_BITS;
+}
+
+/* negative categories (NAs passed with 'missing_action=Fail') are never set */
+static inline bool cat_split_bit(const uint64_t *bits, int cat)
+{
+    return cat >= 0 && (bits[(size_t)cat / CAT_SPLIT_WORD_BITS] >> ((size_t)cat % CAT_SPLIT_WORD_BITS)) & (uint64_t)1;
+}
+
+/* second group of bits, or NULL if there aren't any */
+static inline const uint64_t* cat_split_absent_bits(const IsoTree &node)
+{
+    size_t nwords = cat_split_nwords(node.ncat_split);
+    return (node.cat_split.size() > nwords)? (node.cat_split.data() + nwords) : (const uint64_t*)NULL;
+}
+
+static inline bool cat_goes_left(const IsoTree &node, int cat)
+{
+    return cat_split_bit(node.cat_split.data(), cat);
+}
+
+static inline bool cat_was_absent(const IsoTree &node, int cat)
+{
+    const uint64_t *absent = cat_split_absent_bits(node);
+    return absent != NULL && cat_split_bit(absent, cat);
+}
+
+/* same encoding as produced while fitting: 1 = left, 0 = right, -1 = not present */
+static inline signed char get_cat_split(const IsoTree &node, int cat)
+{
+    return cat_was_absent(node, cat)? (signed char)(-1) : (signed char)cat_goes_left(node, cat);
+}
+
+static inline void set_cat_split(IsoTree &node, const signed char *split_categ, int ncat)
+{
+    size_t nwords = cat_split_nwords(ncat);
+    bool has_absent = false;
+    for (int cat = 0; cat < ncat; cat++)
+        has_absent |= split_categ[cat] < 0;
+
+    node.ncat_split = ncat;
+    node.cat_split.assign(has_absent? (2 * nwords) : nwords, (uint64_t)0);
+    for (int cat = 0; cat < ncat; cat++)
+    {
+        if (split_categ[cat] > 0)
+            node.cat_split[(size_t)cat / CAT_SPLIT_WORD_BITS] |= (uint64_t)1 << ((size_t)cat % CAT_SPLIT_WORD_BITS);
+        else if (split_categ[cat] < 0)
+            node.cat_split[nwords + (size_t)cat / CAT_SPLIT_WORD_BITS] |= (uint64_t)1 << ((size_t)cat % CAT_SPLIT_WORD_BITS);
+    }
+}
+
+static inline void get_cat_split(const IsoTree &node, signed char *split_categ)
+{
+    for (int cat = 0; cat < node.ncat_split; cat++)
+        split_categ[cat] = get_cat_split(node, cat);
+}
+
 typedef struct IsoHPlane {
     std::vector<size_t>   col_num;
     std::vector<ColType>  col_type;
@@ -452,6 +557,30 @@ typedef struct TreesIndexer {
     TreesIndexer() = default;
 } TreesIndexer;
 
+typedef struct RandomCutTree {
+    std::vector<size_t> parent;
+    std::vector<size_t> n_points;
+    std::vector<double> box_low;  /* [node*ncols + col] */
+    std::vector<double> box_high; /* [node*ncols + col] */
+    std::vector<size_t> point_leaf;
+    std::vector<size_t> free_nodes;
+
+    RandomCutTree() = default;
+} RandomCutTree;
+
+typedef struct RandomCutForest {
+    IsoForest model;
+    std::vector<RandomCutTree> cut_trees;
+    std::vector<char> point_is_active;
+    std::vector<size_t> free_point_ids;
+    size_t ncols;
+    size_t n_points;
+    uint64_t random_seed;
+    uint64_t n_inserted;
+
+    RandomCutForest() = default;
+} RandomCutForest;
+
 
 /* Structs that are only used internally */
 template <class real_t, class sparse_ix>
@@ -473,6 +602,8 @@ struct InputData {
     size_t      log2_n;       /* only when using weights for sampling */
     size_t      btree_offset; /* only when using weights for sampling */
     std::vector<double> btree_weights_init;  /* only when using weights for sampling */
+    std::vector<double> alias_prob;          /* only when using weights for sampling with replacement */
+    std::vector<size_t> alias_ix;            /* only when using weights for sampling with replacement */
     std::vector<char>   has_missing;         /* only used when producing missing imputations on-the-fly */
     size_t              n_missing;           /* only used when producing missing imputations on-the-fly */
     void*       preinitialized_col_sampler;  /* only when using column weights */
@@ -485,6 +616,7 @@ struct InputData {
     std::vector<double>  Xr;          /* created by this library, only used when calculating full gain */
     std::vector<size_t>  Xr_ind;      /* created by this library, only used when calculating full gain */
     std::vector<size_t>  Xr_indptr;   /* created by this library, only used when calculating full gain */
+    size_t      tree_block_size; /* only when each tree has its own block of pre-sampled rows */
 };
 
 
@@ -541,6 +673,8 @@ typedef struct {
     UseDepthImp   depth_imp;      /* only when building NA imputer */
     WeighImpRows  weigh_imp_rows; /* only when building NA imputer */
     size_t        min_imp_obs;    /* only when building NA imputer */
+
+    bool low_memory;    /* when fitting under a memory limit, avoids copying the rows of each tree */
 } ModelParams;
 
 template <class sparse_ix, class ldouble_safe>
@@ -578,7 +712,12 @@ struct ImputedData {
     It can be used in 3 modes:
     - As a uniform sampler with replacement.
     - As a weighted sampler with replacement.
-    - As an array that keeps track of which columns are still splittable. */
+    - As an array that keeps track of which columns are still splittable.
+    When using weights, columns dropped at a node are logged with their weights so that
+    going back to the parent only needs to undo those. Once a tree has made enough draws
+    to pay for it, these come from an alias table built for the weights that the tree
+    started with, rejecting columns that were dropped, as long as most of the weight is
+    still left - otherwise, they come from the binary tree of sums. */
 template <class ldouble_safe>
 class ColumnSampler
 {
@@ -592,6 +731,11 @@ public:
     size_t tree_levels;
     size_t offset;
     size_t n_dropped;
+    std::vector<std::pair<size_t, double>> drop_log; /* only when using weights */
+    std::vector<double> alias_prob;
+    std::vector<size_t> alias_col;
+    double alias_wtot;
+    size_t n_tree_draws;
     template <class real_t>
     void initialize(real_t weights[], size_t n_cols);
     void initialize(size_t n_cols);
@@ -603,15 +747,94 @@ public:
     void drop_col(size_t col, size_t nobs_left);
     void drop_col(size_t col);
     void drop_from_tail(size_t col);
+    size_t get_drop_log_size();
+    void undo_drops(size_t drop_log_size);
     void shuffle_remainder(RNG_engine &rnd_generator);
     bool has_weights();
     size_t get_remaining_cols();
     void get_array_remaining_cols(std::vector<size_t> &restrict cols);
+    void build_alias_table();
     template <class other_t>
     ColumnSampler& operator=(const ColumnSampler<other_t> &other);
     ColumnSampler() = default;
 };
 
+/*  This keeps one reservoir of rows per tree while reading rows from a stream in a
+    single pass, so that each tree gets its own sub-sample without the full data ever
+    being in memory. The reservoirs are stored together as one column-major matrix
+    in which the rows of tree 't' are at [t*sample_size, (t+1)*sample_size).
+    Without weights, each reservoir follows algorithm 'L' (geometric jumps), and with
+    weights it follows algorithm 'A-ExpJ' (exponential jumps). The trees are kept in
+    a min-heap by the cumulative weight at which they take their next row, so rows
+    that no reservoir takes cost only one comparison. */
+template <class real_t>
+class RowReservoirs
+{
+public:
+    size_t ntrees;
+    size_t sample_size;
+    size_t ncols_numeric;
+    size_t ncols_categ;
+    bool   use_weights;  /* weights as sampling probabilities */
+    bool   keep_weights; /* weights as density, stored along with the rows */
+    size_t nrows_seen;
+    size_t n_filled;
+    double cum_weight;
+    std::vector<real_t> numeric_data;
+    std::vector<int>    categ_data;
+    std::vector<real_t> sample_weights;
+    std::vector<double> jump_param; /* 'W' for algorithm 'L', smallest log-key for 'A-ExpJ' */
+    std::vector<double> log_keys;   /* only for 'A-ExpJ' */
+    std::vector<size_t> key_heap;   /* only for 'A-ExpJ' */
+    std::vector<std::pair<double, size_t>> next_take;
+    std::vector<size_t> trees_taking;
+    RNG_engine rnd_generator;
+
+    void initialize(size_t ntrees, size_t sample_size, size_t ncols_numeric, size_t ncols_categ,
+                    bool use_weights, bool keep_weights, uint64_t random_seed);
+    void push_row(const real_t numeric_row[], const int categ_row[], double weight);
+    bool is_full();
+    void compact();
+    RowReservoirs() = default;
+private:
+    void write_row(size_t row, const real_t numeric_row[], const int categ_row[], double weight);
+    void finish_filling();
+    void set_next_jump(size_t tree);
+    double draw_positive_unif();
+};
+
+/*  Per-row sums to which all the trees add at fit time (depths for 'output_depths' and
+    imputations for 'impute_at_fit'). Instead of each thread keeping its own copy of them
+    for all the rows, the threads add to the same arrays, in which the rows are divided
+    into stripes that are each guarded by a lock. Each thread queues its additions by
+    stripe and only takes the lock of a stripe when the queue for it fills up or when a
+    tree is finished. */
+class RowStripes
+{
+public:
+    size_t nstripes;
+    size_t stripe_shift;
+    #ifdef _OPENMP
+    std::vector<omp_lock_t> locks;
+    #endif
+
+    void initialize(size_t nrows, int nthreads);
+    size_t get_stripe(size_t row);
+    void lock(size_t stripe);
+    void unlock(size_t stripe);
+    RowStripes() = default;
+    RowStripes(const RowStripes&) = delete;
+    RowStripes& operator=(const RowStripes&) = delete;
+    ~RowStripes();
+};
+
+typedef struct RowAddition {
+    size_t row;
+    size_t impute_node; /* SIZE_MAX when the row doesn't need imputations */
+    double weight;      /* for the imputations */
+    double depth;
+} RowAddition;
+
 template <class ldouble_safe, class real_t>
 class DensityCalculator
 {
@@ -815,6 +1038,7 @@ struct WorkerMemory {
     std::vector<ldouble_safe> buffer_ldbl;   /* for categorical count buffers (ncat+1) */
     std::vector<double>       buffer_dbl2;   /* for FullGain temp_buffer, sparse weight buffer */
     std::vector<size_t>       buffer_szt2;   /* for FullGain argsorted indices */
+    std::vector<size_t>       buffer_ix;     /* for the out-of-place partitions of rows */
     double               prob_split_type;
     ColCriterion         col_criterion;
     GainCriterion        criterion;
@@ -822,6 +1046,7 @@ struct WorkerMemory {
     double               this_split_point;
     int                  this_categ;
     std::vector<signed char> this_split_categ;
+    std::vector<signed char> node_cat_split; /* split of the current node, before packing it */
     bool                 determine_split;
     std::vector<double>  imputed_x_buffer;
     double               saved_xmedian;
@@ -863,15 +1088,21 @@ struct WorkerMemory {
     /* for similarity/distance calculations */
     std::vector<double> tmat_sep;
 
-    /* when calculating average depth on-the-fly */
-    std::vector<double> row_depths;
-
-    /* when imputing NAs on-the-fly */
-    std::vector<ImputedData> impute_vec;
-    hashed_map<size_t, ImputedData> impute_map;
+    /* when calculating average depth or imputing NAs on-the-fly, these point to the
+       arrays shared by all threads, to which additions are queued by stripe of rows */
+    RowStripes *row_stripes = NULL;
+    double     *row_depths = NULL;
+    std::vector<ImputedData> *impute_vec = NULL;
+    hashed_map<size_t, ImputedData> *impute_map = NULL;
+    std::vector<std::vector<RowAddition>> row_additions;
 
     /* for non-depth scoring metric */
     DensityCalculator<ldouble_safe, real_t> density_calculator;
+
+    /* when the rows of a tree are copied and numbered by their position in the sample */
+    std::vector<real_t> sample_numeric;
+    std::vector<int>    sample_categ;
+    std::vector<real_t> sample_row_weights;
 };
 
 typedef struct WorkerForSimilarity {
@@ -903,12 +1134,11 @@ public:
     size_t  split_ix;
     size_t  end;
     size_t  sampler_pos;
-    size_t  n_dropped;
+    size_t  sampler_log_size;
     bool    changed_weights;
     bool    full_state;
     std::vector<size_t> ix_arr;
     std::vector<bool>   cols_possible;
-    std::vector<double> col_sampler_weights;
     std::unique_ptr<double[]> weights_arr;
 
     RecursionState() = default;
@@ -944,7 +1174,9 @@ int fit_iforest_internal(
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, int nthreads);
+                uint64_t random_seed, int nthreads, size_t tree_block_size, size_t max_memory,
+                size_t ntrees_per_round, bool (*continue_fit)(void *fit_monitor, size_t ntrees_fitted),
+                void *fit_monitor);
 template <class real_t, class sparse_ix>
 int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 real_t numeric_data[],  size_t ncols_numeric,
@@ -967,7 +1199,28 @@ int fit_iforest(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                 CategSplit cat_split_type, NewCategAction new_cat_action,
                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows, bool impute_at_fit,
-                uint64_t random_seed, bool use_long_double, int nthreads);
+                uint64_t random_seed, bool use_long_double, int nthreads, size_t max_memory);
+int fit_iforest_in_rounds(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          double numeric_data[],  size_t ncols_numeric,
+                          int    categ_data[],    size_t ncols_categ,    int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          double sample_weights[], bool with_replacement, bool weight_as_sample,
+                          size_t nrows, size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          double col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, int nthreads, size_t max_memory,
+                          size_t ntrees_per_round, bool (*continue_fit)(void *fit_monitor, size_t ntrees_fitted),
+                          void *fit_monitor);
 template <class real_t, class sparse_ix>
 int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              real_t numeric_data[],  size_t ncols_numeric,
@@ -992,9 +1245,33 @@ int add_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
              uint64_t random_seed, bool use_long_double);
+template <class real_t, class sparse_ix>
+int add_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
+              real_t numeric_data[],  size_t ncols_numeric,
+              int    categ_data[],    size_t ncols_categ,    int ncat[],
+              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+              size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+              real_t sample_weights[], size_t nrows,
+              size_t max_depth,     size_t ncols_per_tree,
+              bool   limit_depth,   bool penalize_range, bool standardize_data,
+              bool   fast_bratio,
+              real_t col_weights[], bool weigh_by_kurt,
+              double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+              double prob_pick_by_full_gain, double prob_pick_by_dens,
+              double prob_pick_col_by_range, double prob_pick_col_by_var,
+              double prob_pick_col_by_kurt,
+              double min_gain, MissingAction missing_action,
+              CategSplit cat_split_type, NewCategAction new_cat_action,
+              UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+              bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+              TreesIndexer *indexer,
+              real_t ref_numeric_data[], int ref_categ_data[],
+              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+              uint64_t random_seed, bool use_long_double, int nthreads);
 template <class real_t, class sparse_ix, class ldouble_safe>
-int add_tree_internal(
-             IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+int add_trees_internal(
+             IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t ntrees,
              real_t numeric_data[],  size_t ncols_numeric,
              int    categ_data[],    size_t ncols_categ,    int ncat[],
              real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
@@ -1016,7 +1293,52 @@ int add_tree_internal(
              real_t ref_numeric_data[], int ref_categ_data[],
              bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
              real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
-             uint64_t random_seed);
+             uint64_t random_seed, int nthreads);
+template <class real_t, class sparse_ix>
+int replace_tree(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext, size_t tree_num,
+                 real_t numeric_data[],  size_t ncols_numeric,
+                 int    categ_data[],    size_t ncols_categ,    int ncat[],
+                 real_t Xc[], sparse_ix Xc_ind[], sparse_ix Xc_indptr[],
+                 size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                 real_t sample_weights[], size_t nrows,
+                 size_t max_depth,     size_t ncols_per_tree,
+                 bool   limit_depth,   bool penalize_range, bool standardize_data,
+                 bool   fast_bratio,
+                 real_t col_weights[], bool weigh_by_kurt,
+                 double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                 double prob_pick_by_full_gain, double prob_pick_by_dens,
+                 double prob_pick_col_by_range, double prob_pick_col_by_var,
+                 double prob_pick_col_by_kurt,
+                 double min_gain, MissingAction missing_action,
+                 CategSplit cat_split_type, NewCategAction new_cat_action,
+                 UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                 bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                 TreesIndexer *indexer,
+                 real_t ref_numeric_data[], int ref_categ_data[],
+                 bool ref_is_col_major, size_t ref_ld_numeric, size_t ref_ld_categ,
+                 real_t ref_Xc[], sparse_ix ref_Xc_ind[], sparse_ix ref_Xc_indptr[],
+                 uint64_t random_seed, bool use_long_double);
+template <class real_t>
+int fit_iforest_from_rows(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
+                          bool (*next_row)(void *row_source, real_t numeric_row[], int categ_row[], real_t *row_weight),
+                          void *row_source,
+                          size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                          size_t ndim, size_t ntry, CoefType coef_type, bool coef_by_prop,
+                          bool use_weights, bool weight_as_sample,
+                          size_t sample_size, size_t ntrees,
+                          size_t max_depth,   size_t ncols_per_tree,
+                          bool   limit_depth, bool penalize_range, bool standardize_data,
+                          ScoringMetric scoring_metric, bool fast_bratio,
+                          real_t col_weights[], bool weigh_by_kurt,
+                          double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                          double prob_pick_by_full_gain, double prob_pick_by_dens,
+                          double prob_pick_col_by_range, double prob_pick_col_by_var,
+                          double prob_pick_col_by_kurt,
+                          double min_gain, MissingAction missing_action,
+                          CategSplit cat_split_type, NewCategAction new_cat_action,
+                          bool   all_perm, Imputer *imputer, size_t min_imp_obs,
+                          UseDepthImp depth_imp, WeighImpRows weigh_imp_rows,
+                          uint64_t random_seed, bool use_long_double, int nthreads);
 template <class InputData, class WorkerMemory, class ldouble_safe>
 void fit_itree(std::vector<IsoTree>    *tree_root,
                std::vector<IsoHPlane>  *hplane_root,
@@ -1025,6 +1347,53 @@ void fit_itree(std::vector<IsoTree>    *tree_root,
                ModelParams              &model_params,
                std::vector<ImputeNode> *impute_nodes,
                size_t                   tree_num);
+template <class InputData>
+bool prefer_tree_sample_data(const InputData &input_data, const ModelParams &model_params, bool build_imputer);
+bool prefer_tree_sample_data(bool is_sparse, bool has_density_weights, size_t nrows, size_t ncols_tot,
+                             const ModelParams &model_params, bool build_imputer);
+template <class InputData, class WorkerMemory>
+InputData get_tree_sample_data(InputData &input_data, WorkerMemory &workspace, ModelParams &model_params);
+template <class InputData, class WorkerMemory, class ldouble_safe>
+void fit_itree_sample(std::vector<IsoTree>    *tree_root,
+                      std::vector<IsoHPlane>  *hplane_root,
+                      WorkerMemory             &workspace,
+                      InputData                &input_data,
+                      ModelParams              &model_params,
+                      std::vector<ImputeNode> *impute_nodes);
+size_t estimate_tree_nodes(size_t sample_size, size_t max_depth) noexcept;
+size_t reserved_tree_nodes(size_t sample_size, size_t max_depth) noexcept;
+size_t impute_node_sums_size(size_t ncols_numeric, size_t ncols_categ, int max_categ) noexcept;
+size_t estimate_model_size_internal(const ModelParams &model_params,
+                                    size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                                    bool build_imputer, bool build_indexer, bool with_distances) noexcept;
+size_t estimate_fit_memory_internal(const ModelParams &model_params,
+                                    size_t nrows, size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                                    size_t nnz, bool has_weights, bool weight_as_sample,
+                                    bool build_imputer, bool copy_tree_sample,
+                                    size_t size_real, size_t size_ldouble, int nthreads) noexcept;
+template <class InputData>
+void adjust_to_memory_limit(InputData &input_data, ModelParams &model_params, bool build_imputer,
+                            size_t nnz, size_t size_ldouble, int &nthreads, size_t max_memory);
+ISOTREE_EXPORTED
+size_t estimate_model_size(size_t ndim, size_t ncols_numeric, size_t ncols_categ, int max_categ,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth, CategSplit cat_split_type,
+                           bool build_imputer, bool build_indexer, bool with_distances);
+ISOTREE_EXPORTED
+size_t estimate_fit_memory(size_t ndim, size_t ntry,
+                           size_t ncols_numeric, size_t ncols_categ, int max_categ, size_t nnz,
+                           bool has_sample_weights, bool with_replacement, bool weight_as_sample,
+                           size_t nrows, size_t sample_size, size_t ntrees,
+                           size_t max_depth, bool limit_depth,
+                           ScoringMetric scoring_metric, bool calc_dist, bool calc_depth,
+                           bool weigh_by_kurt,
+                           double prob_pick_by_gain_pl, double prob_pick_by_gain_avg,
+                           double prob_pick_by_full_gain, double prob_pick_by_dens,
+                           double prob_pick_col_by_range, double prob_pick_col_by_var,
+                           double prob_pick_col_by_kurt,
+                           MissingAction missing_action, CategSplit cat_split_type,
+                           bool build_imputer, bool impute_at_fit,
+                           bool use_long_double, int nthreads);
 
 /* isoforest.cpp */
 template <class InputData, class WorkerMemory, class ldouble_safe>
@@ -1034,6 +1403,12 @@ void split_itree_recursive(std::vector<IsoTree>     &trees,
                            ModelParams              &model_params,
                            std::vector<ImputeNode> *impute_nodes,
                            size_t                   curr_depth);
+template <class InputData, class WorkerMemory, class ldouble_safe, MissingAction missing_action>
+void split_itree_recursive_numeric(std::vector<IsoTree>     &trees,
+                                   WorkerMemory             &workspace,
+                                   InputData                &input_data,
+                                   ModelParams              &model_params,
+                                   size_t                   curr_depth);
 
 /* extended.cpp */
 template <class InputData, class WorkerMemory, class ldouble_safe>
@@ -1074,6 +1449,11 @@ void traverse_itree_fast(std::vector<IsoTree>  &tree,
                          sparse_ix *restrict   tree_num,
                          double *restrict      tree_depth,
                          size_t                row) noexcept;
+SimdTreeLayout get_simd_tree_layout() noexcept;
+template <class real_t, class sparse_ix>
+bool traverse_itrees_simd(IsoForest &model_outputs, PredictionData<real_t, sparse_ix> &prediction_data,
+                          size_t nrows, int nthreads, double *restrict output_depths,
+                          sparse_ix *restrict tree_num, double *restrict per_tree_depths);
 template <class PredictionData, class sparse_ix>
 [[gnu::hot]]
 void traverse_itree_no_recurse(std::vector<IsoTree>  &tree,
@@ -1280,17 +1660,7 @@ void drop_nonterminal_imp_node(std::vector<ImputeNode>  &imputer_tree,
                                std::vector<IsoTree>     *trees,
                                std::vector<IsoHPlane>   *hplanes);
 template <class ImputedData>
-void combine_imp_single(ImputedData &restrict imp_addfrom, ImputedData &restrict imp_addto);
-template <class ImputedData, class WorkerMemory>
-void combine_tree_imputations(WorkerMemory &workspace,
-                              std::vector<ImputedData> &impute_vec,
-                              hashed_map<size_t, ImputedData> &impute_map,
-                              std::vector<char> &has_missing,
-                              int nthreads);
-template <class ImputedData>
 void add_from_impute_node(ImputeNode &imputer, ImputedData &imputed_data, double w);
-template <class InputData, class WorkerMemory>
-void add_from_impute_node(ImputeNode &imputer, WorkerMemory &workspace, InputData &input_data);
 template <class imp_arr, class InputData>
 void apply_imputation_results(imp_arr    &impute_vec,
                               Imputer    &imputer,
@@ -1368,14 +1738,25 @@ template <class InputData>
 void set_col_as_taken(std::vector<bool> &col_is_taken, hashed_set<size_t> &col_is_taken_s,
                       InputData &input_data, size_t col_num);
 template <class InputData, class WorkerMemory>
+bool is_plain_numeric_itree(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                            std::vector<ImputeNode> *impute_nodes);
+template <class InputData, class WorkerMemory>
 void add_separation_step(WorkerMemory &workspace, InputData &input_data, double remainder);
 template <class InputData, class WorkerMemory, class ldouble_safe>
 void add_remainder_separation_steps(WorkerMemory &workspace, InputData &input_data, ldouble_safe sum_weight);
+template <class InputData, class WorkerMemory>
+void add_terminal_to_row_sums(WorkerMemory &workspace, InputData &input_data, ModelParams &model_params,
+                              std::vector<ImputeNode> *impute_nodes, double depth, bool weigh_depth);
+template <class WorkerMemory>
+void flush_row_sums(WorkerMemory &workspace, std::vector<ImputeNode> *impute_nodes, size_t stripe);
+template <class WorkerMemory>
+void flush_row_sums(WorkerMemory &workspace, std::vector<ImputeNode> *impute_nodes);
 template <class PredictionData, class sparse_ix>
 void remap_terminal_trees(IsoForest *model_outputs, ExtIsoForest *model_outputs_ext,
                           PredictionData &prediction_data, sparse_ix *restrict tree_num, int nthreads);
 template <class InputData, class ldouble_safe>
-std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &model_params, RNG_engine &rnd_generator);
+std::vector<double> calc_kurtosis_all_data(InputData &input_data, ModelParams &model_params, RNG_engine &rnd_generator,
+                                           int nthreads);
 template <class InputData, class WorkerMemory>
 void calc_ranges_all_cols(InputData &input_data, WorkerMemory &workspace, ModelParams &model_params,
                           double *restrict ranges, double *restrict saved_xmin, double *restrict saved_xmax);
@@ -1411,6 +1792,7 @@ template <class ldouble_safe>
 [[gnu::optimize("no-trapping-math"), gnu::optimize("no-math-errno")]]
 #endif
 double expected_avg_depth(ldouble_safe approx_sample_size);
+double expected_avg_depth_dbl(size_t sample_size);
 double expected_separation_depth(size_t n);
 double expected_separation_depth_hotstart(double curr, size_t n_curr, size_t n_final);
 template <class ldouble_safe>
@@ -1425,35 +1807,79 @@ void increase_comb_counter_in_groups(size_t ix_arr[], size_t st, size_t end, siz
 void increase_comb_counter_in_groups(size_t ix_arr[], size_t st, size_t end, size_t split_ix, size_t n,
                                      double *restrict counter, double *restrict weights, double exp_remainder);
 void tmat_to_dense(double *restrict tmat, double *restrict dmat, size_t n, double fill_diag);
+void calc_ranks(const double x[], size_t n, double ranks[], size_t buffer_ix[]);
+double calc_rank_corr(const double x[], const double y[], size_t n);
 template <class real_t=double>
 void build_btree_sampler(std::vector<double> &btree_weights, real_t *restrict sample_weights,
                          size_t nrows, size_t &restrict log2_n, size_t &restrict btree_offset);
+template <class real_t=double>
+void build_alias_sampler(std::vector<double> &alias_prob, std::vector<size_t> &alias_ix,
+                         real_t *restrict sample_weights, size_t nrows);
+bool prefer_btree_sampler(size_t ntake, size_t nrows) noexcept;
 template <class real_t=double, class ldouble_safe>
 void sample_random_rows(std::vector<size_t> &restrict ix_arr, size_t nrows, bool with_replacement,
                         RNG_engine &rnd_generator, std::vector<size_t> &restrict ix_all,
                         real_t *restrict sample_weights, std::vector<double> &restrict btree_weights,
-                        size_t log2_n, size_t btree_offset, std::vector<bool> &is_repeated);
+                        size_t log2_n, size_t btree_offset, std::vector<bool> &is_repeated,
+                        const double *restrict alias_prob, const size_t *restrict alias_ix);
 template <class real_t=double>
 void weighted_shuffle(size_t *restrict outp, size_t n, real_t *restrict weights, double *restrict buffer_arr, RNG_engine &rnd_generator);
 double sample_random_uniform(double xmin, double xmax, RNG_engine &rng) noexcept;
 size_t divide_subset_split(size_t ix_arr[], double x[], size_t st, size_t end, double split_point) noexcept;
+bool prefer_galloping(size_t n_rows, size_t n_nonzero) noexcept;
+template <class T, class V>
+T* advance_sorted(T *first, T *last, V val, bool gallop) noexcept;
+template <class side_getter>
+void stable_divide_subset(size_t *restrict ix_arr, size_t st, size_t end, size_t *restrict buffer,
+                          side_getter side, size_t &restrict st_NA, size_t &restrict end_NA,
+                          size_t pos = 0, size_t n_left = 0, size_t n_NA = 0) noexcept;
+template <class real_t>
+size_t simd_divide_subset(size_t *restrict ix_arr_st, size_t n, const real_t *restrict x, bool gather_x,
+                          double split_point, bool separate_NA, size_t *restrict buffer,
+                          size_t &restrict n_left, size_t &restrict n_NA) noexcept;
+size_t simd_divide_subset(size_t *restrict ix_arr_st, size_t n, const double *restrict x, bool gather_x,
+                          double split_point, bool separate_NA, size_t *restrict buffer,
+                          size_t &restrict n_left, size_t &restrict n_NA) noexcept;
+size_t divide_subset_split(size_t ix_arr[], double x[], size_t st, size_t end, double split_point,
+                           size_t *restrict buffer) noexcept;
 template <class real_t=double>
 void divide_subset_split(size_t *restrict ix_arr, real_t x[], size_t st, size_t end, double split_point,
                          MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
+template <class real_t=double>
+void divide_subset_split(size_t *restrict ix_arr, real_t x[], size_t st, size_t end, double split_point,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept;
 template <class real_t, class sparse_ix>
 void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
                          real_t Xc[], sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr, double split_point,
                          MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
+template <class real_t, class sparse_ix>
+void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
+                         real_t Xc[], sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr, double split_point,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept;
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, signed char split_categ[],
                          MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, signed char split_categ[],
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept;
+void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end,
+                         const uint64_t split_left[], const uint64_t split_absent[],
                          int ncat, MissingAction missing_action, NewCategAction new_cat_action,
                          bool move_new_to_left, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, int split_categ,
                          MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
+void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, int split_categ,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept;
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end,
                          MissingAction missing_action, NewCategAction new_cat_action,
                          bool move_new_to_left, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept;
+template <class real_t>
+bool simd_get_range(const size_t *restrict ix_arr, const real_t *restrict x, size_t n,
+                    double &restrict xmin, double &restrict xmax) noexcept;
+bool simd_get_range(const size_t *restrict ix_arr, const double *restrict x, size_t n,
+                    double &restrict xmin, double &restrict xmax) noexcept;
 template <class real_t=double>
 void get_range(size_t ix_arr[], real_t *restrict x, size_t st, size_t end,
                MissingAction missing_action, double &restrict xmin, double &restrict xmax, bool &unsplittable) noexcept;
@@ -1471,6 +1897,9 @@ void get_range(size_t col_num, size_t nrows,
 void get_categs(size_t *restrict ix_arr, int x[], size_t st, size_t end, int ncat,
                 MissingAction missing_action, signed char categs[], size_t &restrict npresent, bool &unsplittable) noexcept;
 template <class real_t>
+size_t simd_count_equal(const size_t *restrict ix_arr, const real_t *restrict x, size_t n, double x0, bool skip_NA) noexcept;
+size_t simd_count_equal(const size_t *restrict ix_arr, const double *restrict x, size_t n, double x0, bool skip_NA) noexcept;
+template <class real_t>
 bool check_more_than_two_unique_values(size_t ix_arr[], size_t st, size_t end, real_t x[], MissingAction missing_action);
 bool check_more_than_two_unique_values(size_t ix_arr[], size_t st, size_t end, int x[], MissingAction missing_action);
 template <class real_t, class sparse_ix>
@@ -1506,6 +1935,8 @@ void check_interrupt_switch(SignalSwitcher &ss);
 bool has_long_double();
 int return_EXIT_SUCCESS();
 int return_EXIT_FAILURE();
+const SimdKernels* choose_simd_kernels();
+extern const SimdKernels *simd_kernels;
 
 
 
@@ -1515,6 +1946,7 @@ template <class real_t, class sparse_ix>
 size_t move_NAs_to_front(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num, real_t Xc[], sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr);
 size_t move_NAs_to_front(size_t ix_arr[], size_t st, size_t end, int x[]);
 size_t center_NAs(size_t ix_arr[], size_t st_left, size_t st, size_t curr_pos);
+void sort_ix_arr(size_t ix_arr[], size_t st, size_t end);
 template <class real_t>
 void fill_NAs_with_median(size_t *restrict ix_arr, size_t st_orig, size_t st, size_t end, real_t *restrict x,
                           double *restrict buffer_imputed_x, double *restrict xmedian);
@@ -1544,6 +1976,11 @@ template <class real_t_, class ldouble_safe>
 void calc_mean_and_sd(size_t ix_arr[], size_t st, size_t end, real_t_ *restrict x,
                       MissingAction missing_action, double &restrict x_sd, double &restrict x_mean);
 template <class real_t_>
+bool calc_mean_and_sd_simd(const size_t *restrict ix_arr, const real_t_ *restrict x, size_t n, bool skip_NA,
+                           double &restrict x_sd, double &restrict x_mean) noexcept;
+bool calc_mean_and_sd_simd(const size_t *restrict ix_arr, const double *restrict x, size_t n, bool skip_NA,
+                           double &restrict x_sd, double &restrict x_mean) noexcept;
+template <class real_t_>
 double calc_mean_only(size_t ix_arr[], size_t st, size_t end, real_t_ *restrict x);
 template <class real_t_, class mapping, class ldouble_safe>
 void calc_mean_and_sd_weighted(size_t ix_arr[], size_t st, size_t end, real_t_ *restrict x, mapping &restrict w,
@@ -1648,8 +2085,8 @@ template <class int_t, class ldouble_safe>
 double expected_sd_cat(double p[], size_t n, int_t pos[]);
 template <class number, class int_t, class ldouble_safe>
 double expected_sd_cat(number *restrict counts, double *restrict p, size_t n, int_t *restrict pos);
-template <class number, class int_t, class ldouble_safe>
-double expected_sd_cat_single(number *restrict counts, double *restrict p, size_t n, int_t *restrict pos, size_t cat_exclude, number cnt);
+template <class ldouble_safe>
+double expected_sd_cat_from_sums(ldouble_safe cnt, ldouble_safe cnt_sq, size_t n);
 template <class number, class int_t, class ldouble_safe>
 double expected_sd_cat_internal(int ncat, number *restrict buffer_cnt, ldouble_safe cnt_l,
                                 int_t *restrict buffer_pos, double *restrict buffer_prob);
@@ -1941,6 +2378,16 @@ void subset_model(const IsoForest*     model,      IsoForest*     model_new,
                   const TreesIndexer*  indexer,    TreesIndexer*  indexer_new,
                   const size_t *trees_take, size_t ntrees_take);
 
+/* random_cut.cpp */
+ISOTREE_EXPORTED
+void initialize_random_cut_forest(RandomCutForest &forest, size_t ncols, size_t ntrees, uint64_t random_seed);
+ISOTREE_EXPORTED
+size_t insert_point_random_cut(RandomCutForest &forest, const double point[]);
+ISOTREE_EXPORTED
+void delete_point_random_cut(RandomCutForest &forest, size_t point_id);
+ISOTREE_EXPORTED
+double codisp_random_cut(const RandomCutForest &forest, size_t point_id);
+
 /* serialize.cpp */
 [[noreturn]]
 void throw_errno();
@@ -2213,6 +2660,47 @@ ISOTREE_EXPORTED
 void incremental_serialize_Imputer(const Imputer &model, char *old_bytes_reallocated);
 ISOTREE_EXPORTED
 void incremental_serialize_Indexer(const TreesIndexer &model, char *old_bytes_reallocated);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+size_t determine_serialized_size_trees_delta(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+void serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees, char *out);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+std::string serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const char *in);
+ISOTREE_EXPORTED
+void apply_trees_delta_IsoForest(IsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Imputer(Imputer &model, const std::string &in);
+ISOTREE_EXPORTED
+void apply_trees_delta_Indexer(TreesIndexer &model, const std::string &in);
+
 ISOTREE_EXPORTED
 size_t determine_serialized_size_combined
 (
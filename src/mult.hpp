@@ -117,9 +117,35 @@ void calc_mean_and_sd_t(size_t ix_arr[], size_t st, size_t end, real_t_ *restric
     }
 }
 
+/* Same as above, but using vector instructions to accumulate the sums of deviations and their squares
+   with respect to the first value, from which the mean and variance are then calculated. These
+   sums are kept separately for each lane, and since the values are centered around one of them,
+   the subtraction of the squared mean does not lose much precision for the sizes at which these
+   are used (below 'THRESHOLD_LONG_DOUBLE'). 'ix_arr' can be NULL, in which case the values are
+   taken from 'x' directly. Returns 'false' without calculating anything when vector instructions
+   are not available or the values are not of type 'double'. */
+template <class real_t_>
+bool calc_mean_and_sd_simd(const size_t *restrict, const real_t_ *restrict, size_t, bool,
+                           double &restrict, double &restrict) noexcept
+{
+    return false;
+}
+
+bool calc_mean_and_sd_simd(const size_t *restrict ix_arr, const double *restrict x, size_t n, bool skip_NA,
+                           double &restrict x_sd, double &restrict x_mean) noexcept
+{
+    if (simd_kernels == NULL) return false;
+    simd_kernels->mean_and_sd(ix_arr, x, n, skip_NA, x_sd, x_mean);
+    return true;
+}
+
 template <class real_t_>
 double calc_mean_only(size_t ix_arr[], size_t st, size_t end, real_t_ *restrict x)
 {
+    double x_mean, unused;
+    if (calc_mean_and_sd_simd(ix_arr + st, x, end - st + 1, true, unused, x_mean))
+        return x_mean;
+
     size_t cnt = 0;
     double m = 0;
     real_t_ xval;
@@ -141,7 +167,10 @@ void calc_mean_and_sd(size_t ix_arr[], size_t st, size_t end, real_t_ *restrict
                       MissingAction missing_action, double &restrict x_sd, double &restrict x_mean)
 {
     if (end - st + 1 < THRESHOLD_LONG_DOUBLE)
-        calc_mean_and_sd_t<double, real_t_>(ix_arr, st, end, x, missing_action, x_sd, x_mean);
+    {
+        if (!calc_mean_and_sd_simd(ix_arr + st, x, end - st + 1, missing_action != Fail, x_sd, x_mean))
+            calc_mean_and_sd_t<double, real_t_>(ix_arr, st, end, x, missing_action, x_sd, x_mean);
+    }
     else
         calc_mean_and_sd_t<ldouble_safe, real_t_>(ix_arr, st, end, x, missing_action, x_sd, x_mean);
     x_sd = std::fmax(x_sd, SD_MIN);
@@ -214,6 +243,7 @@ void calc_mean_and_sd_(size_t *restrict ix_arr, size_t st, size_t end, size_t co
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = (size_t) Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, (size_t)Xc_ind[st_col]);
 
@@ -243,15 +273,15 @@ void calc_mean_and_sd_(size_t *restrict ix_arr, size_t st, size_t end, size_t co
             }
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -300,6 +330,7 @@ double calc_mean_only(size_t *restrict ix_arr, size_t st, size_t end, size_t col
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = (size_t) Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, (size_t)Xc_ind[st_col]);
 
@@ -319,15 +350,15 @@ double calc_mean_only(size_t *restrict ix_arr, size_t st, size_t end, size_t col
                 m += (Xc[curr_pos] - m) / (double)(++added);
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -355,6 +386,7 @@ void calc_mean_and_sd_weighted(size_t *restrict ix_arr, size_t st, size_t end, s
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = (size_t) Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, (size_t)Xc_ind[st_col]);
 
@@ -389,15 +421,15 @@ void calc_mean_and_sd_weighted(size_t *restrict ix_arr, size_t st, size_t end, s
             }
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -435,6 +467,7 @@ double calc_mean_only_weighted(size_t *restrict ix_arr, size_t st, size_t end, s
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = (size_t) Xc_ind[end_col];
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, (size_t)Xc_ind[st_col]);
 
@@ -462,15 +495,15 @@ double calc_mean_only_weighted(size_t *restrict ix_arr, size_t st, size_t end, s
             }
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -689,6 +722,7 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, size_
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     const size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, (size_t)Xc_ind[st_col]);
 
     size_t cnt_non_NA = 0; /* when NAs need to be imputed */
@@ -733,15 +767,15 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, size_
 
                     nmatches++;
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
                 {
                     if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                        row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
         }
@@ -758,15 +792,15 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, size_
                     res[row - ix_arr_plus_st] += is_na_or_inf(Xc[curr_pos])?
                                                   (fill_val + offset) : (Xc[curr_pos] * coef);
                     if (row == ix_arr + end) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
                 {
                     if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                        row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
 
@@ -856,15 +890,15 @@ void add_linear_comb(const size_t *restrict ix_arr, size_t st, size_t end, size_
             {
                 res[row - ix_arr_plus_st] += Xc[curr_pos] * coef;
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
     }
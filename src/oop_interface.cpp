@@ -152,7 +152,7 @@ void IsolationForest::fit(double X[], size_t nrows, size_t ncols)
         this->cat_split_type, this->new_cat_action,
         this->all_perm, &this->imputer, this->min_imp_obs,
         this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
+        this->random_seed, false, this->nthreads, this->max_memory
     );
     if (retcode != EXIT_SUCCESS) unexpected_error();
     this->is_fitted = true;
@@ -191,7 +191,7 @@ void IsolationForest::fit(double numeric_data[],   size_t ncols_numeric,  size_t
         this->cat_split_type, this->new_cat_action,
         this->all_perm, &this->imputer, this->min_imp_obs,
         this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
+        this->random_seed, false, this->nthreads, this->max_memory
     );
     if (retcode != EXIT_SUCCESS) unexpected_error();
     this->is_fitted = true;
@@ -231,12 +231,261 @@ void IsolationForest::fit(double Xc[], int Xc_ind[], int Xc_indptr[],
         this->cat_split_type, this->new_cat_action,
         this->all_perm, &this->imputer, this->min_imp_obs,
         this->depth_imp, this->weigh_imp_rows, false,
-        this->random_seed, false, this->nthreads
+        this->random_seed, false, this->nthreads, this->max_memory
     );
     if (retcode != EXIT_SUCCESS) unexpected_error();
     this->is_fitted = true;
 }
 
+/* State for 'fit_early_stop', which gets checked after each round of trees. The non-standardized
+   scores are averages over trees (in log-space for the density metrics), so the sums of the
+   per-round averages (weighted by their number of trees) rank the rows in the same order as
+   the scores of the model with all the trees fitted so far. */
+struct EarlyStopMonitor {
+    IsoForest *model;
+    ExtIsoForest *model_ext;
+    double *numeric_data;
+    int *categ_data;
+    size_t nrows;
+    int nthreads;
+    bool log_scores;
+    double min_rank_corr;
+    size_t ntrees_prev;
+    std::vector<double> round_scores;
+    std::vector<double> sum_scores;
+    std::vector<double> prev_sum_scores;
+};
+
+/* Predicts with only the trees of the last round, by temporarily leaving those alone in the model */
+static bool continue_early_stop(void *fit_monitor, size_t ntrees_fitted)
+{
+    EarlyStopMonitor &monitor = *(EarlyStopMonitor*)fit_monitor;
+    size_t ntrees_round = ntrees_fitted - monitor.ntrees_prev;
+    std::vector<std::vector<IsoTree>> trees;
+    std::vector<std::vector<IsoHPlane>> hplanes;
+    if (monitor.model != nullptr)
+    {
+        trees.swap(monitor.model->trees);
+        monitor.model->trees.assign(std::make_move_iterator(trees.begin() + monitor.ntrees_prev),
+                                    std::make_move_iterator(trees.begin() + ntrees_fitted));
+    }
+    else
+    {
+        hplanes.swap(monitor.model_ext->hplanes);
+        monitor.model_ext->hplanes.assign(std::make_move_iterator(hplanes.begin() + monitor.ntrees_prev),
+                                          std::make_move_iterator(hplanes.begin() + ntrees_fitted));
+    }
+
+    predict_iforest(
+        monitor.numeric_data, monitor.categ_data,
+        true, (size_t)0, (size_t)0,
+        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+        monitor.nrows, monitor.nthreads, false,
+        monitor.model, monitor.model_ext,
+        monitor.round_scores.data(), (int*)nullptr, (double*)nullptr,
+        (TreesIndexer*)nullptr);
+
+    if (monitor.model != nullptr)
+    {
+        std::move(monitor.model->trees.begin(), monitor.model->trees.end(), trees.begin() + monitor.ntrees_prev);
+        monitor.model->trees.swap(trees);
+    }
+    else
+    {
+        std::move(monitor.model_ext->hplanes.begin(), monitor.model_ext->hplanes.end(), hplanes.begin() + monitor.ntrees_prev);
+        monitor.model_ext->hplanes.swap(hplanes);
+    }
+
+    for (size_t row = 0; row < monitor.nrows; row++)
+        monitor.sum_scores[row] += (double)ntrees_round * (monitor.log_scores?
+                                                           std::log(monitor.round_scores[row]) : monitor.round_scores[row]);
+    bool converged = monitor.ntrees_prev &&
+                     calc_rank_corr(monitor.sum_scores.data(), monitor.prev_sum_scores.data(), monitor.nrows) >= monitor.min_rank_corr;
+    monitor.ntrees_prev = ntrees_fitted;
+    monitor.prev_sum_scores.assign(monitor.sum_scores.begin(), monitor.sum_scores.end());
+    return !converged;
+}
+
+size_t IsolationForest::fit_early_stop(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                                       int    categ_data[],     size_t ncols_categ,    int ncat[],
+                                       double sample_weights[], double col_weights[],
+                                       double monitor_numeric_data[], int monitor_categ_data[], size_t nrows_monitor,
+                                       size_t ntrees_per_round, double min_rank_corr)
+{
+    this->check_params();
+    this->override_previous_fit();
+    if (!ntrees_per_round)
+        throw std::runtime_error("'ntrees_per_round' must be positive.\n");
+    if (monitor_numeric_data == nullptr && monitor_categ_data == nullptr) {
+        monitor_numeric_data = numeric_data;
+        monitor_categ_data = categ_data;
+        nrows_monitor = nrows;
+    }
+    if (!nrows_monitor)
+        throw std::runtime_error("Must pass rows on which to monitor the scores.\n");
+
+    EarlyStopMonitor monitor;
+    monitor.model = (this->ndim == 1)? &this->model : nullptr;
+    monitor.model_ext = (this->ndim != 1)? &this->model_ext : nullptr;
+    monitor.numeric_data = monitor_numeric_data;
+    monitor.categ_data = monitor_categ_data;
+    monitor.nrows = nrows_monitor;
+    monitor.nthreads = this->nthreads;
+    monitor.log_scores = this->scoring_metric == Density ||
+                         this->scoring_metric == BoxedDensity ||
+                         this->scoring_metric == BoxedDensity2;
+    monitor.min_rank_corr = min_rank_corr;
+    monitor.ntrees_prev = 0;
+    monitor.round_scores.resize(nrows_monitor);
+    monitor.sum_scores.assign(nrows_monitor, 0.);
+    monitor.prev_sum_scores.resize(nrows_monitor);
+
+    auto retcode = fit_iforest_in_rounds(
+        monitor.model, monitor.model_ext,
+        numeric_data,  ncols_numeric,
+        categ_data, ncols_categ, ncat,
+        this->ndim, this->ntry, this->coef_type, this->coef_by_prop,
+        sample_weights, this->with_replacement, this->weight_as_sample,
+        nrows, this->sample_size, this->ntrees,
+        this->max_depth, this->ncols_per_tree,
+        this->limit_depth, this->penalize_range, this->standardize_data,
+        this->scoring_metric, this->fast_bratio,
+        col_weights, this->weigh_by_kurt,
+        this->prob_pick_by_gain_pl,
+        this->prob_pick_by_gain_avg,
+        this->prob_pick_by_full_gain,
+        this->prob_pick_by_dens,
+        this->prob_pick_col_by_range,
+        this->prob_pick_col_by_var,
+        this->prob_pick_col_by_kurt,
+        this->min_gain, this->missing_action,
+        this->cat_split_type, this->new_cat_action,
+        this->all_perm, &this->imputer, this->min_imp_obs,
+        this->depth_imp, this->weigh_imp_rows,
+        this->random_seed, this->nthreads, this->max_memory,
+        ntrees_per_round, continue_early_stop, &monitor
+    );
+    if (retcode != EXIT_SUCCESS) unexpected_error();
+    this->imputer.imputer_tree.shrink_to_fit();
+    this->is_fitted = true;
+    return (this->ndim == 1)? this->model.trees.size() : this->model_ext.hplanes.size();
+}
+
+size_t IsolationForest::estimate_fit_memory(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                                            size_t nnz, bool has_sample_weights)
+{
+    this->check_nthreads();
+    int max_categ = ncols_categ? *std::max_element(ncat, ncat + ncols_categ) : 0;
+    /* note: 'fit' always passes the imputer object, so it gets built regardless of 'build_imputer' */
+    return ::estimate_fit_memory(
+        this->ndim, this->ntry,
+        ncols_numeric, ncols_categ, max_categ, nnz,
+        has_sample_weights, this->with_replacement, this->weight_as_sample,
+        nrows, this->sample_size, this->ntrees,
+        this->max_depth, this->limit_depth,
+        this->scoring_metric, false, false,
+        this->weigh_by_kurt,
+        this->prob_pick_by_gain_pl,
+        this->prob_pick_by_gain_avg,
+        this->prob_pick_by_full_gain,
+        this->prob_pick_by_dens,
+        this->prob_pick_col_by_range,
+        this->prob_pick_col_by_var,
+        this->prob_pick_col_by_kurt,
+        this->missing_action, this->cat_split_type,
+        true, false,
+        false, this->nthreads
+    );
+}
+
+size_t IsolationForest::estimate_model_size(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                                            bool with_indexer, bool with_distances)
+{
+    int max_categ = ncols_categ? *std::max_element(ncat, ncat + ncols_categ) : 0;
+    return ::estimate_model_size(
+        this->ndim, ncols_numeric, ncols_categ, max_categ,
+        nrows, this->sample_size, this->ntrees,
+        this->max_depth, this->limit_depth, this->cat_split_type,
+        true, with_indexer, with_distances
+    );
+}
+
+size_t IsolationForest::rotate_tree(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                                    int    categ_data[],     size_t ncols_categ,    int ncat[],
+                                    double sample_weights[], double col_weights[])
+{
+    this->check_is_fitted();
+    if (!this->indexer.indices.empty() && !this->indexer.indices.front().reference_points.empty())
+        throw std::runtime_error("Cannot rotate trees in a model with reference points.\n");
+    if (!nrows)
+        throw std::runtime_error("Cannot fit a tree to zero rows.\n");
+
+    const size_t ntrees = this->get_ntrees();
+    const size_t tree_num = this->n_rotated % ntrees;
+    double &exp_avg_depth = (!this->model.trees.empty())? this->model.exp_avg_depth : this->model_ext.exp_avg_depth;
+    double &exp_avg_sep = (!this->model.trees.empty())? this->model.exp_avg_sep : this->model_ext.exp_avg_sep;
+    const ScoringMetric scoring_metric = (!this->model.trees.empty())? this->model.scoring_metric : this->model_ext.scoring_metric;
+    if (this->tree_exp_depths.size() != ntrees) {
+        this->tree_exp_depths.assign(ntrees, exp_avg_depth);
+        this->tree_exp_seps.assign(ntrees, exp_avg_sep);
+    }
+
+    auto retcode = replace_tree(
+        (!this->model.trees.empty())? &this->model : nullptr,
+        (!this->model_ext.hplanes.empty())? &this->model_ext : nullptr,
+        tree_num,
+        numeric_data,  ncols_numeric,
+        categ_data, ncols_categ, ncat,
+        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+        this->ndim, this->ntry, this->coef_type, this->coef_by_prop,
+        sample_weights, nrows,
+        this->max_depth, this->ncols_per_tree,
+        this->limit_depth, this->penalize_range, this->standardize_data,
+        this->fast_bratio,
+        col_weights, this->weigh_by_kurt,
+        this->prob_pick_by_gain_pl,
+        this->prob_pick_by_gain_avg,
+        this->prob_pick_by_full_gain,
+        this->prob_pick_by_dens,
+        this->prob_pick_col_by_range,
+        this->prob_pick_col_by_var,
+        this->prob_pick_col_by_kurt,
+        this->min_gain, this->missing_action,
+        this->cat_split_type, this->new_cat_action,
+        this->depth_imp, this->weigh_imp_rows,
+        this->all_perm, this->imputer.imputer_tree.empty()? nullptr : &this->imputer, this->min_imp_obs,
+        this->indexer.indices.empty()? nullptr : &this->indexer,
+        (double*)nullptr, (int*)nullptr,
+        true, (size_t)0, (size_t)0,
+        (double*)nullptr, (int*)nullptr, (int*)nullptr,
+        this->random_seed + this->n_rotated, false
+    );
+    if (retcode != EXIT_SUCCESS) unexpected_error();
+    this->n_rotated++;
+
+    /* Each tree has its own expected depth according to the number of rows it was
+       fit to, and the model uses the average across all trees. This is updated
+       incrementally, and recalculated in full once per cycle to avoid accumulating
+       numerical errors. */
+    if (scoring_metric != Density && scoring_metric != BoxedDensity &&
+        scoring_metric != BoxedDensity2 && scoring_metric != BoxedRatio)
+    {
+        double new_exp_depth = expected_avg_depth_dbl(nrows);
+        exp_avg_depth += (new_exp_depth - this->tree_exp_depths[tree_num]) / (double)ntrees;
+        this->tree_exp_depths[tree_num] = new_exp_depth;
+        if (tree_num == ntrees - 1)
+            exp_avg_depth = std::accumulate(this->tree_exp_depths.begin(), this->tree_exp_depths.end(), 0.) / (double)ntrees;
+    }
+    double new_exp_sep = expected_separation_depth(nrows);
+    exp_avg_sep += (new_exp_sep - this->tree_exp_seps[tree_num]) / (double)ntrees;
+    this->tree_exp_seps[tree_num] = new_exp_sep;
+    if (tree_num == ntrees - 1)
+        exp_avg_sep = std::accumulate(this->tree_exp_seps.begin(), this->tree_exp_seps.end(), 0.) / (double)ntrees;
+
+    return tree_num;
+}
+
 std::vector<double> IsolationForest::predict(double X[], size_t nrows, bool standardize)
 {
     this->check_is_fitted();
@@ -675,6 +924,9 @@ void IsolationForest::override_previous_fit()
         this->imputer = Imputer();
         this->indexer = TreesIndexer();
     }
+    this->n_rotated = 0;
+    this->tree_exp_depths.clear();
+    this->tree_exp_seps.clear();
 }
 
 void IsolationForest::check_params()
@@ -99,6 +99,8 @@ class ISOTREE_EXPORTED IsolationForest
 public:
     int nthreads = -1;
 
+    size_t max_memory = 0;
+
     uint64_t random_seed = 1;
 
     size_t ndim = 1;
@@ -175,6 +177,22 @@ public:
              int    categ_data[],       size_t ncols_categ,   int ncat[],
              double sample_weights[],   double col_weights[]);
 
+    size_t fit_early_stop(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                          int    categ_data[],     size_t ncols_categ,    int ncat[],
+                          double sample_weights[], double col_weights[],
+                          double monitor_numeric_data[], int monitor_categ_data[], size_t nrows_monitor,
+                          size_t ntrees_per_round, double min_rank_corr);
+
+    size_t rotate_tree(double numeric_data[],   size_t ncols_numeric,  size_t nrows,
+                       int    categ_data[],     size_t ncols_categ,    int ncat[],
+                       double sample_weights[], double col_weights[]);
+
+    size_t estimate_fit_memory(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                               size_t nnz, bool has_sample_weights);
+
+    size_t estimate_model_size(size_t nrows, size_t ncols_numeric, size_t ncols_categ, int ncat[],
+                               bool with_indexer, bool with_distances);
+
     std::vector<double> predict(double X[], size_t nrows, bool standardize);
 
     void predict(double numeric_data[], int categ_data[], bool is_col_major,
@@ -286,6 +304,9 @@ public:
 
 private:
     bool is_fitted = false;
+    size_t n_rotated = 0;
+    std::vector<double> tree_exp_depths;
+    std::vector<double> tree_exp_seps;
 
     void override_previous_fit();
     void check_params();
@@ -232,7 +232,16 @@ void predict_iforest(real_t *restrict numeric_data, int *restrict categ_data,
             !model_outputs->has_range_penalty
             )
         {
-            if (prediction_data.categ_data == NULL && (nrows == 1 || !prediction_data.is_col_major))
+            if (
+                prediction_data.categ_data == NULL && !prediction_data.is_col_major &&
+                traverse_itrees_simd(*model_outputs, prediction_data, nrows, nthreads,
+                                     output_depths, tree_num, per_tree_depths)
+                )
+            {
+                /* already calculated */
+            }
+
+            else if (prediction_data.categ_data == NULL && (nrows == 1 || !prediction_data.is_col_major))
             {
                 #pragma omp parallel for if(nrows > 1) schedule(static) num_threads(nthreads) \
                         shared(nrows, model_outputs, prediction_data, output_depths, tree_num, per_tree_depths)
@@ -568,6 +577,70 @@ void traverse_itree_fast(std::vector<IsoTree>  &tree,
     }
 }
 
+/* Offsets of the fields of 'IsoTree' that the vectorized kernels read */
+SimdTreeLayout get_simd_tree_layout() noexcept
+{
+    IsoTree node;
+    SimdTreeLayout layout;
+    layout.node_size  = sizeof(IsoTree);
+    layout.col_num    = (size_t)((char*)&node.col_num - (char*)&node);
+    layout.num_split  = (size_t)((char*)&node.num_split - (char*)&node);
+    layout.tree_left  = (size_t)((char*)&node.tree_left - (char*)&node);
+    layout.tree_right = (size_t)((char*)&node.tree_right - (char*)&node);
+    return layout;
+}
+
+/* Same as calling 'traverse_itree_fast' for each row and tree, but traversing each tree for a block
+   of rows at once with the vectorized kernels, one row per lane. The scores are added in the same
+   order as in the loop over rows. Returns 'false' without doing anything if the CPU does not
+   support vector instructions, if the data is not of type 'double', or if there are too few rows. */
+template <class real_t, class sparse_ix>
+bool traverse_itrees_simd(IsoForest &model_outputs, PredictionData<real_t, sparse_ix> &prediction_data,
+                          size_t nrows, int nthreads, double *restrict output_depths,
+                          sparse_ix *restrict tree_num, double *restrict per_tree_depths)
+{
+    if (
+        simd_kernels == NULL || !std::is_same<real_t, double>::value ||
+        nrows < simd_kernels->width ||
+        prediction_data.ncols_numeric > (size_t)UINT32_MAX / simd_kernels->width
+        )
+        return false;
+    for (const auto &tree : model_outputs.trees)
+        if (tree.size() > (size_t)UINT32_MAX) return false;
+
+    const SimdTreeLayout layout = get_simd_tree_layout();
+    const size_t ld = prediction_data.ncols_numeric;
+    const size_t ntrees = model_outputs.trees.size();
+    const size_t nblocks = (nrows + SIMD_PREDICT_BLOCK - 1) / SIMD_PREDICT_BLOCK;
+    const double *restrict X = reinterpret_cast<const double*>(prediction_data.numeric_data);
+
+    #pragma omp parallel for schedule(static) num_threads(nthreads) \
+            shared(model_outputs, X, nrows, output_depths, tree_num, per_tree_depths)
+    for (size_t_for block = 0; block < (decltype(block))nblocks; block++)
+    {
+        size_t terminal[SIMD_PREDICT_BLOCK];
+        const size_t st = (size_t)block * SIMD_PREDICT_BLOCK;
+        const size_t n_block = std::min((size_t)SIMD_PREDICT_BLOCK, nrows - st);
+        std::fill(output_depths + st, output_depths + st + n_block, 0.);
+
+        for (size_t tree = 0; tree < ntrees; tree++)
+        {
+            const IsoTree *restrict nodes = model_outputs.trees[tree].data();
+            simd_kernels->traverse_tree((const char*)nodes, layout, X + st * ld, ld, n_block, terminal);
+            for (size_t ix = 0; ix < n_block; ix++)
+                output_depths[st + ix] += nodes[terminal[ix]].score;
+            if (unlikely(tree_num != NULL))
+                for (size_t ix = 0; ix < n_block; ix++)
+                    tree_num[nrows * tree + st + ix] = terminal[ix];
+            if (unlikely(per_tree_depths != NULL))
+                for (size_t ix = 0; ix < n_block; ix++)
+                    per_tree_depths[tree + (st + ix) * ntrees] = nodes[terminal[ix]].score;
+        }
+    }
+
+    return true;
+}
+
 template <class PredictionData, class sparse_ix>
 void traverse_itree_no_recurse(std::vector<IsoTree>  &tree,
                                IsoForest             &model_outputs,
@@ -644,23 +717,23 @@ void traverse_itree_no_recurse(std::vector<IsoTree>  &tree,
                                 {
                                     case Random:
                                     {
-                                        cval = (cval >= (int)tree[curr_lev].cat_split.size())?
-                                                (cval % (int)tree[curr_lev].cat_split.size()) : cval;
-                                        curr_lev = (tree[curr_lev].cat_split[cval])?
+                                        cval = (cval >= tree[curr_lev].ncat_split)?
+                                                (cval % tree[curr_lev].ncat_split) : cval;
+                                        curr_lev = cat_goes_left(tree[curr_lev], cval)?
                                                     tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                         break;
                                     }
 
                                     case Smallest:
                                     {
-                                        if (unlikely(cval >= (int)tree[curr_lev].cat_split.size()))
+                                        if (unlikely(cval >= tree[curr_lev].ncat_split))
                                         {
                                             curr_lev =  (tree[curr_lev].pct_tree_left < .5)? tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                         }
 
                                         else
                                         {
-                                            curr_lev = (tree[curr_lev].cat_split[cval])?
+                                            curr_lev = cat_goes_left(tree[curr_lev], cval)?
                                                         tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                         }
                                         break;
@@ -924,23 +997,23 @@ double traverse_itree(std::vector<IsoTree>     &tree,
                                     {
                                         case Random:
                                         {
-                                            cval = (cval >= (int)tree[curr_lev].cat_split.size())?
-                                                    (cval % (int)tree[curr_lev].cat_split.size()) : cval;
-                                            curr_lev = (tree[curr_lev].cat_split[cval])?
+                                            cval = (cval >= tree[curr_lev].ncat_split)?
+                                                    (cval % tree[curr_lev].ncat_split) : cval;
+                                            curr_lev = cat_goes_left(tree[curr_lev], cval)?
                                                         tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                             break;
                                         }
 
                                         case Smallest:
                                         {
-                                            if (unlikely(cval >= (int)tree[curr_lev].cat_split.size()))
+                                            if (unlikely(cval >= tree[curr_lev].ncat_split))
                                             {
                                                 curr_lev =  (tree[curr_lev].pct_tree_left < .5)? tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                             }
 
                                             else
                                             {
-                                                curr_lev = (tree[curr_lev].cat_split[cval])?
+                                                curr_lev = cat_goes_left(tree[curr_lev], cval)?
                                                             tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                             }
                                             break;
@@ -948,9 +1021,9 @@ double traverse_itree(std::vector<IsoTree>     &tree,
 
                                         case Weighted:
                                         {
-                                            if (cval >= (int)tree[curr_lev].cat_split.size()
+                                            if (cval >= tree[curr_lev].ncat_split
                                                     ||
-                                                tree[curr_lev].cat_split[cval] == (-1))
+                                                cat_was_absent(tree[curr_lev], cval))
                                             {
                                                 if (tree_num || tree_depth) throw_unsupported_pred_error();
                                                 return
@@ -967,7 +1040,7 @@ double traverse_itree(std::vector<IsoTree>     &tree,
 
                                             else
                                             {
-                                                curr_lev = (tree[curr_lev].cat_split[cval])?
+                                                curr_lev = cat_goes_left(tree[curr_lev], cval)?
                                                             tree[curr_lev].tree_left : tree[curr_lev].tree_right;
                                             }
                                             break;
@@ -1484,8 +1557,9 @@ void traverse_itree_csc(WorkerForPredictCSC   &workspace,
                     else
                         divide_subset_split(workspace.ix_arr.data(),
                                             prediction_data.categ_data + prediction_data.nrows * trees[curr_tree].col_num,
-                                            workspace.st, workspace.end, trees[curr_tree].cat_split.data(),
-                                            (int) trees[curr_tree].cat_split.size(),
+                                            workspace.st, workspace.end,
+                                            trees[curr_tree].cat_split.data(), cat_split_absent_bits(trees[curr_tree]),
+                                            trees[curr_tree].ncat_split,
                                             model_outputs.missing_action, model_outputs.new_cat_action,
                                             (bool)(trees[curr_tree].pct_tree_left < .5), st_NA, end_NA, split_ix);
                     break;
@@ -0,0 +1,539 @@
+/*    Isolation forests and variations thereof, with adjustments for incorporation
+*     of categorical variables and missing values.
+*     Writen for C++11 standard and aimed at being used in R and Python.
+*     
+*     This library is based on the following works:
+*     [1] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation forest."
+*         2008 Eighth IEEE International Conference on Data Mining. IEEE, 2008.
+*     [2] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "Isolation-based anomaly detection."
+*         ACM Transactions on Knowledge Discovery from Data (TKDD) 6.1 (2012): 3.
+*     [3] Hariri, Sahand, Matias Carrasco Kind, and Robert J. Brunner.
+*         "Extended Isolation Forest."
+*         arXiv preprint arXiv:1811.02141 (2018).
+*     [4] Liu, Fei Tony, Kai Ming Ting, and Zhi-Hua Zhou.
+*         "On detecting clustered anomalies using SCiForest."
+*         Joint European Conference on Machine Learning and Knowledge Discovery in Databases. Springer, Berlin, Heidelberg, 2010.
+*     [5] https://sourceforge.net/projects/iforest/
+*     [6] https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree
+*     [7] Quinlan, J. Ross. C4. 5: programs for machine learning. Elsevier, 2014.
+*     [8] Cortes, David.
+*         "Distance approximation using Isolation Forests."
+*         arXiv preprint arXiv:1910.12362 (2019).
+*     [9] Cortes, David.
+*         "Imputing missing values with unsupervised random trees."
+*         arXiv preprint arXiv:1911.06646 (2019).
+*     [10] https://math.stackexchange.com/questions/3333220/expected-average-depth-in-random-binary-tree-constructed-top-to-bottom
+*     [11] Cortes, David.
+*          "Revisiting randomized choices in isolation forests."
+*          arXiv preprint arXiv:2110.13402 (2021).
+*     [12] Guha, Sudipto, et al.
+*          "Robust random cut forest based anomaly detection on streams."
+*          International conference on machine learning. PMLR, 2016.
+*     [13] Cortes, David.
+*          "Isolation forests: looking beyond tree depth."
+*          arXiv preprint arXiv:2111.11639 (2021).
+*     [14] Ting, Kai Ming, Yue Zhu, and Zhi-Hua Zhou.
+*          "Isolation kernel and its effect on SVM"
+*          Proceedings of the 24th ACM SIGKDD
+*          International Conference on Knowledge Discovery & Data Mining. 2018.
+* 
+*     BSD 2-Clause License
+*     Copyright (c) 2019-2024, David Cortes
+*     All rights reserved.
+*     Redistribution and use in source and binary forms, with or without
+*     modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and/or other materials provided with the distribution.
+*     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+*     AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+*     IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*     FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*     DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*     SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*     CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*     OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "isotree.hpp"
+
+/*  Trees that can have points inserted and deleted one at a time, following the procedures
+    from the 'Robust Random Cut Forest' paper [12]. Each tree contains all of the points that
+    are currently in the forest, with each terminal node corresponding to a distinct point
+    (duplicated points are counted in the same terminal node).
+
+    The nodes are kept in the same format as the trees from 'fit_iforest' (inside member
+    'model'), so they can be used directly with 'predict_iforest' and similar functions,
+    while the parents, bounding boxes and number of points under each node are kept
+    separately. Node zero is always the root, and nodes that get removed are recycled
+    through a list of free nodes.
+
+    Inserting or deleting a point visits only the nodes in the path from the root to the
+    terminal node where the point is. The only additional work is in updating the depths
+    of the terminal nodes in the sub-tree that gets moved one level up or down, which are
+    needed in order to make predictions with 'predict_iforest'.  */
+
+static inline bool is_terminal_node(const IsoTree &node)
+{
+    return node.tree_left == 0;
+}
+
+static inline double expected_remainder_depth(size_t n_points)
+{
+    return (n_points > 1)? expected_avg_depth_dbl(n_points) : 0.;
+}
+
+static size_t get_free_node(RandomCutTree &cut_tree, std::vector<IsoTree> &tree, size_t ncols)
+{
+    if (!cut_tree.free_nodes.empty())
+    {
+        size_t node = cut_tree.free_nodes.back();
+        cut_tree.free_nodes.pop_back();
+        tree[node] = IsoTree();
+        return node;
+    }
+
+    tree.emplace_back();
+    cut_tree.parent.push_back(0);
+    cut_tree.n_points.push_back(0);
+    cut_tree.box_low.resize(cut_tree.box_low.size() + ncols);
+    cut_tree.box_high.resize(cut_tree.box_high.size() + ncols);
+    return tree.size() - 1;
+}
+
+static void set_terminal_node(IsoTree &node, size_t n_points, double depth)
+{
+    node.col_type = NotUsed;
+    node.tree_left = 0;
+    node.tree_right = 0;
+    node.score = depth + expected_remainder_depth(n_points);
+    node.remainder = (double)n_points;
+}
+
+/* Adds 'shift' to the depths of all terminal nodes under 'node' */
+static void shift_depths(std::vector<IsoTree> &tree, size_t node, double shift, std::vector<size_t> &node_stack)
+{
+    node_stack.clear();
+    node_stack.push_back(node);
+    while (!node_stack.empty())
+    {
+        size_t curr = node_stack.back();
+        node_stack.pop_back();
+        if (is_terminal_node(tree[curr])) {
+            tree[curr].score += shift;
+        }
+        else {
+            node_stack.push_back(tree[curr].tree_left);
+            node_stack.push_back(tree[curr].tree_right);
+        }
+    }
+}
+
+static void update_pct_left(RandomCutTree &cut_tree, std::vector<IsoTree> &tree, size_t node)
+{
+    tree[node].pct_tree_left = (double)cut_tree.n_points[tree[node].tree_left] / (double)cut_tree.n_points[node];
+}
+
+/* Moves the contents of a node into the slot of the root, which must have been left unused */
+static void move_to_root(RandomCutForest &forest, RandomCutTree &cut_tree, std::vector<IsoTree> &tree, size_t node)
+{
+    const size_t ncols = forest.ncols;
+    tree[0] = std::move(tree[node]);
+    cut_tree.parent[0] = 0;
+    cut_tree.n_points[0] = cut_tree.n_points[node];
+    std::copy(cut_tree.box_low.begin() + node * ncols, cut_tree.box_low.begin() + (node + 1) * ncols, cut_tree.box_low.begin());
+    std::copy(cut_tree.box_high.begin() + node * ncols, cut_tree.box_high.begin() + (node + 1) * ncols, cut_tree.box_high.begin());
+
+    if (!is_terminal_node(tree[0]))
+    {
+        cut_tree.parent[tree[0].tree_left] = 0;
+        cut_tree.parent[tree[0].tree_right] = 0;
+    }
+
+    /* If the root is a terminal node, then all the points in the tree are in it */
+    else
+    {
+        for (size_t point_id = 0; point_id < forest.point_is_active.size(); point_id++)
+            if (forest.point_is_active[point_id])
+                cut_tree.point_leaf[point_id] = 0;
+    }
+
+    tree[node] = IsoTree();
+    cut_tree.free_nodes.push_back(node);
+}
+
+static void insert_point_single_tree(RandomCutForest &forest, RandomCutTree &cut_tree, std::vector<IsoTree> &tree,
+                                     const double *restrict point, size_t point_id, RNG_engine &rnd_generator,
+                                     std::vector<double> &buffer, std::vector<size_t> &node_stack)
+{
+    const size_t ncols = forest.ncols;
+    UniformUnitInterval runif(0, 1);
+
+    if (tree.empty())
+    {
+        size_t leaf = get_free_node(cut_tree, tree, ncols);
+        set_terminal_node(tree[leaf], 1, 0.);
+        cut_tree.n_points[leaf] = 1;
+        std::copy(point, point + ncols, cut_tree.box_low.begin());
+        std::copy(point, point + ncols, cut_tree.box_high.begin());
+        cut_tree.point_leaf[point_id] = leaf;
+        return;
+    }
+
+    double *restrict new_low = buffer.data();
+    double *restrict new_high = buffer.data() + ncols;
+    size_t node = 0;
+    size_t depth = 0;
+
+    while (true)
+    {
+        double *restrict box_low = cut_tree.box_low.data() + node * ncols;
+        double *restrict box_high = cut_tree.box_high.data() + node * ncols;
+        double range_sum = 0;
+        for (size_t col = 0; col < ncols; col++)
+        {
+            new_low[col] = std::fmin(box_low[col], point[col]);
+            new_high[col] = std::fmax(box_high[col], point[col]);
+            range_sum += new_high[col] - new_low[col];
+        }
+
+        /* Same point as one that is already in the tree */
+        if (range_sum <= 0)
+        {
+            if (unlikely(!is_terminal_node(tree[node]))) unexpected_error();
+            cut_tree.n_points[node]++;
+            set_terminal_node(tree[node], cut_tree.n_points[node], (double)depth);
+            cut_tree.point_leaf[point_id] = node;
+            return;
+        }
+
+        /* Cut is chosen with probability proportional to the range of each column in the
+           bounding box that includes the new point, and it separates the new point from
+           the rest if it falls outside of the bounding box of the node. */
+        size_t col;
+        double split_point;
+        bool separates_left, separates_right;
+        do
+        {
+            double pos = runif(rnd_generator) * range_sum;
+            for (col = 0; col < ncols - 1; col++)
+            {
+                if (pos < new_high[col] - new_low[col])
+                    break;
+                pos -= new_high[col] - new_low[col];
+            }
+            split_point = std::fmin(new_low[col] + pos, new_high[col]);
+            separates_left = point[col] <= split_point && box_low[col] > split_point;
+            separates_right = point[col] > split_point && box_high[col] <= split_point;
+        }
+        while (unlikely(is_terminal_node(tree[node]) && !separates_left && !separates_right));
+
+        if (separates_left || separates_right)
+        {
+            /* Note: adding new nodes might re-allocate the arrays */
+            size_t new_node = get_free_node(cut_tree, tree, ncols);
+            size_t leaf = get_free_node(cut_tree, tree, ncols);
+            if (node == 0)
+            {
+                /* The root needs to stay at index zero */
+                size_t moved = new_node;
+                new_node = 0;
+                tree[moved] = std::move(tree[0]);
+                cut_tree.n_points[moved] = cut_tree.n_points[0];
+                std::copy(cut_tree.box_low.begin(), cut_tree.box_low.begin() + ncols, cut_tree.box_low.begin() + moved * ncols);
+                std::copy(cut_tree.box_high.begin(), cut_tree.box_high.begin() + ncols, cut_tree.box_high.begin() + moved * ncols);
+                if (!is_terminal_node(tree[moved])) {
+                    cut_tree.parent[tree[moved].tree_left] = moved;
+                    cut_tree.parent[tree[moved].tree_right] = moved;
+                }
+                else {
+                    for (size_t id = 0; id < forest.point_is_active.size(); id++)
+                        if (forest.point_is_active[id] && id != point_id)
+                            cut_tree.point_leaf[id] = moved;
+                }
+                tree[0] = IsoTree();
+                cut_tree.parent[0] = 0;
+                node = moved;
+            }
+
+            else
+            {
+                size_t parent = cut_tree.parent[node];
+                if (tree[parent].tree_left == node)
+                    tree[parent].tree_left = new_node;
+                else
+                    tree[parent].tree_right = new_node;
+                cut_tree.parent[new_node] = parent;
+            }
+
+            tree[new_node].col_type = Numeric;
+            tree[new_node].col_num = col;
+            tree[new_node].num_split = split_point;
+            tree[new_node].score = 0;
+            tree[new_node].remainder = 0;
+            tree[new_node].tree_left = separates_left? leaf : node;
+            tree[new_node].tree_right = separates_left? node : leaf;
+            cut_tree.parent[node] = new_node;
+            cut_tree.n_points[new_node] = cut_tree.n_points[node] + 1;
+            std::copy(new_low, new_low + ncols, cut_tree.box_low.begin() + new_node * ncols);
+            std::copy(new_high, new_high + ncols, cut_tree.box_high.begin() + new_node * ncols);
+
+            set_terminal_node(tree[leaf], 1, (double)(depth + 1));
+            cut_tree.parent[leaf] = new_node;
+            cut_tree.n_points[leaf] = 1;
+            std::copy(point, point + ncols, cut_tree.box_low.begin() + leaf * ncols);
+            std::copy(point, point + ncols, cut_tree.box_high.begin() + leaf * ncols);
+            cut_tree.point_leaf[point_id] = leaf;
+
+            update_pct_left(cut_tree, tree, new_node);
+            shift_depths(tree, node, 1., node_stack);
+            return;
+        }
+
+        cut_tree.n_points[node]++;
+        std::copy(new_low, new_low + ncols, box_low);
+        std::copy(new_high, new_high + ncols, box_high);
+        size_t next_node = (point[tree[node].col_num] <= tree[node].num_split)?
+                            tree[node].tree_left : tree[node].tree_right;
+        cut_tree.n_points[next_node]++; /* <- temporarily, for calculating the proportion */
+        update_pct_left(cut_tree, tree, node);
+        cut_tree.n_points[next_node]--;
+        node = next_node;
+        depth++;
+    }
+}
+
+static void delete_point_single_tree(RandomCutForest &forest, RandomCutTree &cut_tree, std::vector<IsoTree> &tree,
+                                     size_t point_id, std::vector<size_t> &node_stack)
+{
+    const size_t ncols = forest.ncols;
+    size_t leaf = cut_tree.point_leaf[point_id];
+    size_t node;
+
+    if (cut_tree.n_points[leaf] > 1)
+    {
+        cut_tree.n_points[leaf]--;
+        double depth = tree[leaf].score - expected_remainder_depth(cut_tree.n_points[leaf] + 1);
+        set_terminal_node(tree[leaf], cut_tree.n_points[leaf], depth);
+        node = leaf;
+    }
+
+    else if (leaf == 0)
+    {
+        tree.clear();
+        cut_tree.parent.clear();
+        cut_tree.n_points.clear();
+        cut_tree.box_low.clear();
+        cut_tree.box_high.clear();
+        cut_tree.free_nodes.clear();
+        return;
+    }
+
+    else
+    {
+        /* The parent of the point gets replaced by its sibling */
+        size_t parent = cut_tree.parent[leaf];
+        size_t sibling = (tree[parent].tree_left == leaf)? tree[parent].tree_right : tree[parent].tree_left;
+        tree[leaf] = IsoTree();
+        cut_tree.free_nodes.push_back(leaf);
+        shift_depths(tree, sibling, -1., node_stack);
+
+        if (parent == 0)
+        {
+            move_to_root(forest, cut_tree, tree, sibling);
+            return;
+        }
+
+        size_t grandparent = cut_tree.parent[parent];
+        if (tree[grandparent].tree_left == parent)
+            tree[grandparent].tree_left = sibling;
+        else
+            tree[grandparent].tree_right = sibling;
+        cut_tree.parent[sibling] = grandparent;
+        tree[parent] = IsoTree();
+        cut_tree.free_nodes.push_back(parent);
+        node = sibling;
+    }
+
+    /* Now update the counts and bounding boxes of the nodes above */
+    while (node != 0)
+    {
+        node = cut_tree.parent[node];
+        cut_tree.n_points[node]--;
+        update_pct_left(cut_tree, tree, node);
+        size_t left = tree[node].tree_left;
+        size_t right = tree[node].tree_right;
+        for (size_t col = 0; col < ncols; col++)
+        {
+            cut_tree.box_low[node * ncols + col] = std::fmin(cut_tree.box_low[left * ncols + col], cut_tree.box_low[right * ncols + col]);
+            cut_tree.box_high[node * ncols + col] = std::fmax(cut_tree.box_high[left * ncols + col], cut_tree.box_high[right * ncols + col]);
+        }
+    }
+}
+
+static void update_expected_depths(RandomCutForest &forest)
+{
+    forest.model.orig_sample_size = forest.n_points;
+    forest.model.exp_avg_depth = expected_remainder_depth(forest.n_points);
+    forest.model.exp_avg_sep = expected_separation_depth(forest.n_points);
+}
+
+/* Initialize a forest of random cut trees to which points can be added and removed one at a time
+* 
+* Parameters
+* ==========
+* - forest (out)
+*       Object to initialize. Any points or trees that it had will be removed.
+* - ncols
+*       Number of (numeric) columns in the points that will be added to it.
+* - ntrees
+*       Number of trees in the forest.
+* - random_seed
+*       Seed that will be used to generate random numbers for choosing the cuts.
+*/
+void initialize_random_cut_forest(RandomCutForest &forest, size_t ncols, size_t ntrees, uint64_t random_seed)
+{
+    if (!ncols)
+        throw std::runtime_error("Random cut forest must have at least one column.\n");
+    if (!ntrees)
+        throw std::runtime_error("Random cut forest must have at least one tree.\n");
+
+    forest = RandomCutForest();
+    forest.ncols = ncols;
+    forest.n_points = 0;
+    forest.random_seed = random_seed;
+    forest.n_inserted = 0;
+    forest.cut_trees.resize(ntrees);
+    forest.model.trees.resize(ntrees);
+    forest.model.new_cat_action = Weighted;
+    forest.model.cat_split_type = SubSet;
+    forest.model.missing_action = Impute;
+    forest.model.scoring_metric = Depth;
+    forest.model.has_range_penalty = false;
+    update_expected_depths(forest);
+}
+
+/* Insert a new point into each tree of a random cut forest
+* 
+* Parameters
+* ==========
+* - forest (in, out)
+*       Object that was initialized through 'initialize_random_cut_forest'.
+* - point[ncols]
+*       Values of the point to insert, which cannot have missing values.
+* 
+* Returns
+* =======
+* Identifier for the point, which can later be used for deleting it or for calculating its
+* co-displacement. Identifiers from deleted points will be reused for new points.
+*/
+size_t insert_point_random_cut(RandomCutForest &forest, const double point[])
+{
+    if (forest.cut_trees.empty())
+        throw std::runtime_error("Random cut forest has not been initialized.\n");
+    for (size_t col = 0; col < forest.ncols; col++)
+        if (unlikely(is_na_or_inf(point[col])))
+            throw std::runtime_error("Cannot insert points with missing or infinite values.\n");
+
+    size_t point_id;
+    if (!forest.free_point_ids.empty())
+    {
+        point_id = forest.free_point_ids.back();
+        forest.free_point_ids.pop_back();
+    }
+
+    else
+    {
+        point_id = forest.point_is_active.size();
+        forest.point_is_active.push_back(false);
+        for (auto &cut_tree : forest.cut_trees)
+            cut_tree.point_leaf.push_back(0);
+    }
+
+    std::vector<double> buffer(forest.ncols * 2);
+    std::vector<size_t> node_stack;
+    const size_t ntrees = forest.cut_trees.size();
+    for (size_t tree = 0; tree < ntrees; tree++)
+    {
+        RNG_engine rnd_generator(forest.random_seed + forest.n_inserted * (uint64_t)ntrees + (uint64_t)tree);
+        insert_point_single_tree(forest, forest.cut_trees[tree], forest.model.trees[tree],
+                                 point, point_id, rnd_generator, buffer, node_stack);
+    }
+
+    forest.point_is_active[point_id] = true;
+    forest.n_points++;
+    forest.n_inserted++;
+    update_expected_depths(forest);
+    return point_id;
+}
+
+/* Delete a point from each tree of a random cut forest
+* 
+* Parameters
+* ==========
+* - forest (in, out)
+*       Object to which the point was added through 'insert_point_random_cut'.
+* - point_id
+*       Identifier of the point, as returned by 'insert_point_random_cut'.
+*/
+void delete_point_random_cut(RandomCutForest &forest, size_t point_id)
+{
+    if (point_id >= forest.point_is_active.size() || !forest.point_is_active[point_id])
+        throw std::runtime_error("Point to delete is not in the forest.\n");
+
+    std::vector<size_t> node_stack;
+    for (size_t tree = 0; tree < forest.cut_trees.size(); tree++)
+        delete_point_single_tree(forest, forest.cut_trees[tree], forest.model.trees[tree], point_id, node_stack);
+
+    forest.point_is_active[point_id] = false;
+    forest.free_point_ids.push_back(point_id);
+    forest.n_points--;
+    update_expected_depths(forest);
+}
+
+/* Calculate the co-displacement of a point in a random cut forest
+* 
+* This is the outlier score proposed in [12], calculated as the largest ratio between the
+* number of points in the sibling and the number of points in each node in the path from the
+* point to the root of each tree, averaged across trees. Higher values mean more outlierness.
+* 
+* Parameters
+* ==========
+* - forest
+*       Object to which the point was added through 'insert_point_random_cut'.
+* - point_id
+*       Identifier of the point, as returned by 'insert_point_random_cut'.
+* 
+* Returns
+* =======
+* Average co-displacement of the point across all trees.
+*/
+double codisp_random_cut(const RandomCutForest &forest, size_t point_id)
+{
+    if (point_id >= forest.point_is_active.size() || !forest.point_is_active[point_id])
+        throw std::runtime_error("Point is not in the forest.\n");
+
+    double sum_codisp = 0;
+    for (size_t tree = 0; tree < forest.cut_trees.size(); tree++)
+    {
+        const RandomCutTree &cut_tree = forest.cut_trees[tree];
+        const std::vector<IsoTree> &nodes = forest.model.trees[tree];
+        size_t node = cut_tree.point_leaf[point_id];
+        double codisp = 0;
+        while (node != 0)
+        {
+            size_t parent = cut_tree.parent[node];
+            size_t sibling = (nodes[parent].tree_left == node)? nodes[parent].tree_right : nodes[parent].tree_left;
+            codisp = std::fmax(codisp, (double)cut_tree.n_points[sibling] / (double)cut_tree.n_points[node]);
+            node = parent;
+        }
+        sum_codisp += codisp;
+    }
+
+    return sum_codisp / (double)forest.cut_trees.size();
+}
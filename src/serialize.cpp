@@ -147,7 +147,8 @@ enum ModelTypes {
     ExtIsoForestModel=2,
     ImputerModel=3,
     IndexerModel=5,
-    AllObjectsCombined=4
+    AllObjectsCombined=4,
+    TreesDelta=6
 };
 enum EndingIndicator {
     EndsHere=0,
@@ -701,7 +702,7 @@ size_t get_size_node(const IsoTree &node) noexcept
     n_bytes += sizeof(int);
     n_bytes += sizeof(double) * 6;
     n_bytes += sizeof(size_t) * 4;
-    n_bytes += sizeof(signed char) * node.cat_split.size();
+    n_bytes += sizeof(signed char) * (size_t)node.ncat_split;
     return n_bytes;
 }
 
@@ -729,12 +730,17 @@ void serialize_node(const IsoTree &node, otype &out)
         node.col_num,
         node.tree_left,
         node.tree_right,
-        node.cat_split.size()
+        (size_t)node.ncat_split
     };
     write_bytes<size_t>((void*)data_sizets, (size_t)4, out);
 
-    if (node.cat_split.size())
-    write_bytes<signed char>((void*)node.cat_split.data(), node.cat_split.size(), out);
+    /* the bitsets are written in the same format as before, with one byte per category */
+    if (node.ncat_split)
+    {
+        std::unique_ptr<signed char[]> cat_split(new signed char[node.ncat_split]);
+        get_cat_split(node, cat_split.get());
+        write_bytes<signed char>((void*)cat_split.get(), (size_t)node.ncat_split, out);
+    }
 }
 
 template <class itype>
@@ -762,7 +768,14 @@ void deserialize_node(IsoTree &node, itype &in)
     node.col_num = data_sizets[0];
     node.tree_left = data_sizets[1];
     node.tree_right = data_sizets[2];
-    read_bytes<signed char>(node.cat_split, data_sizets[3], in);
+    std::vector<signed char> cat_split;
+    read_bytes<signed char>(cat_split, data_sizets[3], in);
+    if (!cat_split.empty())
+        set_cat_split(node, cat_split.data(), (int)cat_split.size());
+    else {
+        node.cat_split.clear();
+        node.ncat_split = 0;
+    }
 }
 
 template <class itype, class saved_int_t, class saved_size_t>
@@ -790,7 +803,14 @@ void deserialize_node(IsoTree &node, itype &in, std::vector<char> &buffer, const
     node.col_num = data_sizets[0];
     node.tree_left = data_sizets[1];
     node.tree_right = data_sizets[2];
-    read_bytes<signed char, signed char>(node.cat_split, data_sizets[3], in, buffer, diff_endian);
+    std::vector<signed char> cat_split;
+    read_bytes<signed char, signed char>(cat_split, data_sizets[3], in, buffer, diff_endian);
+    if (!cat_split.empty())
+        set_cat_split(node, cat_split.data(), (int)cat_split.size());
+    else {
+        node.cat_split.clear();
+        node.ncat_split = 0;
+    }
 }
 
 size_t get_size_node(const IsoHPlane &node) noexcept
@@ -2493,11 +2513,445 @@ void incremental_serialize_Indexer(const TreesIndexer &model, std::string &old_b
     incremental_serialize_string(model, old_bytes);
 }
 
+/* Deltas with replaced trees:
+   setup info -> delta code -> model code -> size of the delta -> model-level fields ->
+   total number of trees -> number of trees in the delta -> (tree index + tree) ... -> ending */
+size_t get_size_delta_header(const IsoForest &/*model*/) noexcept
+{
+    return sizeof(uint8_t) + sizeof(double) * 2 + sizeof(size_t);
+}
+
+size_t get_size_delta_header(const ExtIsoForest &/*model*/) noexcept
+{
+    return sizeof(uint8_t) + sizeof(double) * 2 + sizeof(size_t);
+}
+
+size_t get_size_delta_header(const Imputer &/*model*/) noexcept
+{
+    return 0;
+}
+
+size_t get_size_delta_header(const TreesIndexer &/*model*/) noexcept
+{
+    return 0;
+}
+
+template <class Model>
+void serialize_delta_header(const Model &model, char *&out)
+{
+    uint8_t has_range_penalty = (uint8_t)model.has_range_penalty;
+    write_bytes<uint8_t>((void*)&has_range_penalty, (size_t)1, out);
+
+    double data_doubles[] = {
+        model.exp_avg_depth,
+        model.exp_avg_sep
+    };
+    write_bytes<double>((void*)data_doubles, (size_t)2, out);
+
+    size_t orig_sample_size = model.orig_sample_size;
+    write_bytes<size_t>((void*)&orig_sample_size, (size_t)1, out);
+}
+
+void serialize_delta_header(const Imputer &/*model*/, char *&/*out*/) noexcept {}
+
+void serialize_delta_header(const TreesIndexer &/*model*/, char *&/*out*/) noexcept {}
+
+template <class Model>
+void deserialize_delta_header(Model &model, const char *&in)
+{
+    uint8_t has_range_penalty;
+    read_bytes<uint8_t>((void*)&has_range_penalty, (size_t)1, in);
+    model.has_range_penalty = (bool)has_range_penalty;
+
+    double data_doubles[2];
+    read_bytes<double>((void*)data_doubles, (size_t)2, in);
+    model.exp_avg_depth = data_doubles[0];
+    model.exp_avg_sep = data_doubles[1];
+
+    read_bytes<size_t>((void*)&model.orig_sample_size, (size_t)1, in);
+}
+
+void deserialize_delta_header(Imputer &/*model*/, const char *&/*in*/) noexcept {}
+
+void deserialize_delta_header(TreesIndexer &/*model*/, const char *&/*in*/) noexcept {}
+
+std::vector<std::vector<IsoTree>>& get_model_trees(IsoForest &model) noexcept
+{
+    return model.trees;
+}
+
+std::vector<std::vector<IsoHPlane>>& get_model_trees(ExtIsoForest &model) noexcept
+{
+    return model.hplanes;
+}
+
+std::vector<std::vector<ImputeNode>>& get_model_trees(Imputer &model) noexcept
+{
+    return model.imputer_tree;
+}
+
+std::vector<SingleTreeIndex>& get_model_trees(TreesIndexer &model) noexcept
+{
+    return model.indices;
+}
+
+const std::vector<std::vector<IsoTree>>& get_model_trees(const IsoForest &model) noexcept
+{
+    return model.trees;
+}
+
+const std::vector<std::vector<IsoHPlane>>& get_model_trees(const ExtIsoForest &model) noexcept
+{
+    return model.hplanes;
+}
+
+const std::vector<std::vector<ImputeNode>>& get_model_trees(const Imputer &model) noexcept
+{
+    return model.imputer_tree;
+}
+
+const std::vector<SingleTreeIndex>& get_model_trees(const TreesIndexer &model) noexcept
+{
+    return model.indices;
+}
+
+template <class Node>
+size_t get_size_tree(const std::vector<Node> &tree) noexcept
+{
+    size_t n_bytes = sizeof(size_t);
+    for (const auto &node : tree)
+        n_bytes += get_size_node(node);
+    return n_bytes;
+}
+
+size_t get_size_tree(const SingleTreeIndex &tree) noexcept
+{
+    return get_size_node(tree);
+}
+
+void serialize_tree(const std::vector<IsoTree> &tree, char *&out)
+{
+    size_t veclen = tree.size();
+    write_bytes<size_t>((void*)&veclen, (size_t)1, out);
+    for (const auto &node : tree)
+        serialize_node(node, out);
+}
+
+void serialize_tree(const std::vector<IsoHPlane> &tree, char *&out)
+{
+    std::vector<uint8_t> buffer;
+    size_t veclen = tree.size();
+    write_bytes<size_t>((void*)&veclen, (size_t)1, out);
+    for (const auto &node : tree)
+        serialize_node(node, out, buffer);
+}
+
+void serialize_tree(const std::vector<ImputeNode> &tree, char *&out)
+{
+    size_t veclen = tree.size();
+    write_bytes<size_t>((void*)&veclen, (size_t)1, out);
+    for (const auto &node : tree)
+        serialize_node(node, out);
+}
+
+void serialize_tree(const SingleTreeIndex &tree, char *&out)
+{
+    serialize_node(tree, out);
+}
+
+void deserialize_tree(std::vector<IsoTree> &tree, const char *&in)
+{
+    size_t veclen;
+    read_bytes<size_t>((void*)&veclen, (size_t)1, in);
+    tree.resize(veclen);
+    tree.shrink_to_fit();
+    for (auto &node : tree)
+        deserialize_node(node, in);
+}
+
+void deserialize_tree(std::vector<IsoHPlane> &tree, const char *&in)
+{
+    std::vector<uint8_t> buffer;
+    size_t veclen;
+    read_bytes<size_t>((void*)&veclen, (size_t)1, in);
+    tree.resize(veclen);
+    tree.shrink_to_fit();
+    for (auto &node : tree)
+        deserialize_node(node, in, buffer);
+}
+
+void deserialize_tree(std::vector<ImputeNode> &tree, const char *&in)
+{
+    size_t veclen;
+    read_bytes<size_t>((void*)&veclen, (size_t)1, in);
+    tree.resize(veclen);
+    tree.shrink_to_fit();
+    for (auto &node : tree)
+        deserialize_node(node, in);
+}
+
+void deserialize_tree(SingleTreeIndex &tree, const char *&in)
+{
+    deserialize_node(tree, in);
+}
+
+template <class Model>
+size_t get_size_trees_delta(const Model &model, const size_t tree_nums[], size_t n_trees)
+{
+    const auto &trees = get_model_trees(model);
+    size_t n_bytes = get_size_delta_header(model);
+    n_bytes += sizeof(size_t) * 2;
+    for (size_t ix = 0; ix < n_trees; ix++)
+    {
+        if (tree_nums[ix] >= trees.size())
+            throw std::runtime_error("Passed tree number that is not in the model.\n");
+        n_bytes += sizeof(size_t);
+        n_bytes += get_size_tree(trees[tree_nums[ix]]);
+    }
+    return n_bytes;
+}
+
+template <class Model>
+size_t determine_serialized_size_trees_delta(const Model &model, const size_t tree_nums[], size_t n_trees)
+{
+    size_t n_bytes = 0;
+    n_bytes += get_size_setup_info();
+    n_bytes += sizeof(uint8_t) * 2;
+    n_bytes += sizeof(size_t);
+    n_bytes += get_size_trees_delta(model, tree_nums, n_trees);
+    n_bytes += get_size_ending_metadata();
+    return n_bytes;
+}
+
+template <class Model>
+void trees_delta_serialization_pipeline(const Model &model, const size_t tree_nums[], size_t n_trees, char *out)
+{
+    SignalSwitcher ss = SignalSwitcher();
+
+    const auto &trees = get_model_trees(model);
+    size_t size_delta = get_size_trees_delta(model, tree_nums, n_trees);
+
+    char *pos_watermark = out;
+    add_setup_info(out, false);
+    uint8_t delta_type = TreesDelta;
+    write_bytes<uint8_t>((void*)&delta_type, (size_t)1, out);
+    uint8_t model_type = get_model_code(model);
+    write_bytes<uint8_t>((void*)&model_type, (size_t)1, out);
+    write_bytes<size_t>((void*)&size_delta, (size_t)1, out);
+
+    serialize_delta_header(model, out);
+    size_t data_sizets[] = {
+        trees.size(),
+        n_trees
+    };
+    write_bytes<size_t>((void*)data_sizets, (size_t)2, out);
+
+    size_t tree_num;
+    for (size_t ix = 0; ix < n_trees; ix++)
+    {
+        tree_num = tree_nums[ix];
+        write_bytes<size_t>((void*)&tree_num, (size_t)1, out);
+        serialize_tree(trees[tree_num], out);
+    }
+    check_interrupt_switch(ss);
+
+    uint8_t ending_type = (uint8_t)EndsHere;
+    write_bytes<uint8_t>((void*)&ending_type, (size_t)1, out);
+    size_t jump_ahead = 0;
+    write_bytes<size_t>((void*)&jump_ahead, (size_t)1, out);
+
+    add_full_watermark(pos_watermark);
+}
+
+template <class Model>
+std::string trees_delta_serialization_pipeline(const Model &model, const size_t tree_nums[], size_t n_trees)
+{
+    std::string serialized;
+    serialized.resize(determine_serialized_size_trees_delta(model, tree_nums, n_trees));
+    trees_delta_serialization_pipeline(model, tree_nums, n_trees, &serialized[0]);
+    return serialized;
+}
+
+template <class Model>
+void apply_trees_delta_pipeline(Model &model, const char *in)
+{
+    SignalSwitcher ss = SignalSwitcher();
+
+    check_setup_info(in);
+
+    uint8_t delta_in;
+    read_bytes<uint8_t>((void*)&delta_in, (size_t)1, in);
+    if (delta_in != TreesDelta)
+        throw std::runtime_error("Input is not a serialized delta of trees.\n");
+    uint8_t model_in;
+    read_bytes<uint8_t>((void*)&model_in, (size_t)1, in);
+    if (model_in != get_model_code(model))
+        throw std::runtime_error("Object to update does not match with the type of the serialized delta.\n");
+    size_t size_delta;
+    read_bytes<size_t>((void*)&size_delta, (size_t)1, in);
+
+    const char *pos_header = in;
+    in += get_size_delta_header(model);
+    size_t data_sizets[2];
+    read_bytes<size_t>((void*)data_sizets, (size_t)2, in);
+    const size_t new_ntrees = data_sizets[0];
+    const size_t n_trees = data_sizets[1];
+
+    auto &trees = get_model_trees(model);
+    const size_t old_ntrees = trees.size();
+    if (new_ntrees < old_ntrees)
+        throw std::runtime_error("Serialized delta of trees has fewer trees than the model to update.\n");
+    if (n_trees > new_ntrees)
+        throw std::runtime_error("Serialized delta of trees is corrupted.\n");
+
+    /* The trees are first read into a separate container, so that the model is
+       left untouched if something fails along the way. */
+    std::vector<size_t> tree_nums(n_trees);
+    std::vector<typename std::remove_reference<decltype(trees)>::type::value_type> new_trees(n_trees);
+    for (size_t ix = 0; ix < n_trees; ix++)
+    {
+        read_bytes<size_t>((void*)&tree_nums[ix], (size_t)1, in);
+        if (tree_nums[ix] >= new_ntrees)
+            throw std::runtime_error("Serialized delta of trees is corrupted.\n");
+        deserialize_tree(new_trees[ix], in);
+    }
+    check_interrupt_switch(ss);
+
+    /* positions that the model doesn't have yet cannot be left as empty trees */
+    if (new_ntrees > old_ntrees)
+    {
+        std::vector<char> is_filled(new_ntrees - old_ntrees, false);
+        for (size_t tree_num : tree_nums)
+            if (tree_num >= old_ntrees) is_filled[tree_num - old_ntrees] = true;
+        if (std::find(is_filled.begin(), is_filled.end(), false) != is_filled.end())
+            throw std::runtime_error("Serialized delta of trees does not contain all of the trees that the model is missing.\n");
+    }
+
+    trees.resize(new_ntrees);
+    for (size_t ix = 0; ix < n_trees; ix++)
+        trees[tree_nums[ix]] = std::move(new_trees[ix]);
+    deserialize_delta_header(model, pos_header);
+
+    /* Not currently used, but left in case the format changes */
+    uint8_t ending_type;
+    read_bytes<uint8_t>((void*)&ending_type, (size_t)1, in);
+    size_t jump_ahead;
+    read_bytes<size_t>((void*)&jump_ahead, (size_t)1, in);
+}
+
+size_t determine_serialized_size_trees_delta(const IsoForest &model, const size_t tree_nums[], size_t n_trees)
+{
+    return determine_serialized_size_trees_delta<IsoForest>(model, tree_nums, n_trees);
+}
+
+size_t determine_serialized_size_trees_delta(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees)
+{
+    return determine_serialized_size_trees_delta<ExtIsoForest>(model, tree_nums, n_trees);
+}
+
+size_t determine_serialized_size_trees_delta(const Imputer &model, const size_t tree_nums[], size_t n_trees)
+{
+    return determine_serialized_size_trees_delta<Imputer>(model, tree_nums, n_trees);
+}
+
+size_t determine_serialized_size_trees_delta(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees)
+{
+    return determine_serialized_size_trees_delta<TreesIndexer>(model, tree_nums, n_trees);
+}
+
+void serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees, char *out)
+{
+    trees_delta_serialization_pipeline(model, tree_nums, n_trees, out);
+}
+
+void serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees, char *out)
+{
+    trees_delta_serialization_pipeline(model, tree_nums, n_trees, out);
+}
+
+void serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees, char *out)
+{
+    trees_delta_serialization_pipeline(model, tree_nums, n_trees, out);
+}
+
+void serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees, char *out)
+{
+    trees_delta_serialization_pipeline(model, tree_nums, n_trees, out);
+}
+
+std::string serialize_trees_delta_IsoForest(const IsoForest &model, const size_t tree_nums[], size_t n_trees)
+{
+    return trees_delta_serialization_pipeline(model, tree_nums, n_trees);
+}
+
+std::string serialize_trees_delta_ExtIsoForest(const ExtIsoForest &model, const size_t tree_nums[], size_t n_trees)
+{
+    return trees_delta_serialization_pipeline(model, tree_nums, n_trees);
+}
+
+std::string serialize_trees_delta_Imputer(const Imputer &model, const size_t tree_nums[], size_t n_trees)
+{
+    return trees_delta_serialization_pipeline(model, tree_nums, n_trees);
+}
+
+std::string serialize_trees_delta_Indexer(const TreesIndexer &model, const size_t tree_nums[], size_t n_trees)
+{
+    return trees_delta_serialization_pipeline(model, tree_nums, n_trees);
+}
+
+void apply_trees_delta_IsoForest(IsoForest &model, const char *in)
+{
+    apply_trees_delta_pipeline(model, in);
+}
+
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const char *in)
+{
+    apply_trees_delta_pipeline(model, in);
+}
+
+void apply_trees_delta_Imputer(Imputer &model, const char *in)
+{
+    apply_trees_delta_pipeline(model, in);
+}
+
+void apply_trees_delta_Indexer(TreesIndexer &model, const char *in)
+{
+    apply_trees_delta_pipeline(model, in);
+}
+
+void apply_trees_delta_IsoForest(IsoForest &model, const std::string &in)
+{
+    if (!in.size())
+        throw std::runtime_error("Invalid input model to deserialize.");
+    apply_trees_delta_pipeline(model, in.c_str());
+}
+
+void apply_trees_delta_ExtIsoForest(ExtIsoForest &model, const std::string &in)
+{
+    if (!in.size())
+        throw std::runtime_error("Invalid input model to deserialize.");
+    apply_trees_delta_pipeline(model, in.c_str());
+}
+
+void apply_trees_delta_Imputer(Imputer &model, const std::string &in)
+{
+    if (!in.size())
+        throw std::runtime_error("Invalid input model to deserialize.");
+    apply_trees_delta_pipeline(model, in.c_str());
+}
+
+void apply_trees_delta_Indexer(TreesIndexer &model, const std::string &in)
+{
+    if (!in.size())
+        throw std::runtime_error("Invalid input model to deserialize.");
+    apply_trees_delta_pipeline(model, in.c_str());
+}
+
 template <class Model>
 std::string serialization_pipeline(const Model &model)
 {
     std::string serialized;
-    serialized.resize(get_size_model(model));
+    serialized.resize(determine_serialized_size(model));
     char *ptr = &serialized[0];
     serialization_pipeline(model, ptr);
     return serialized;
@@ -0,0 +1,56 @@
+/* Interface to the kernels that are compiled separately for each instruction set in
+   'simd_kernels_avx2.cpp' and 'simd_kernels_avx512.cpp', so that the library can be
+   built for a baseline CPU and still use vector instructions when they are available.
+
+   This file is included both from 'isotree.hpp' and from those translation units, which
+   are compiled with different flags - it should not define any functions, only types. */
+#ifndef ISOTREE_SIMD_KERNELS_H
+#define ISOTREE_SIMD_KERNELS_H
+
+#include <cstddef>
+
+/* Offsets in bytes of the fields of 'IsoTree' that are used when traversing a tree,
+   passed this way so that the kernels do not need to see the full definition. */
+typedef struct SimdTreeLayout {
+    size_t node_size;
+    size_t col_num;
+    size_t num_split;
+    size_t tree_left;
+    size_t tree_right;
+} SimdTreeLayout;
+
+/* The meaning of each of these is documented in the wrappers that call them from 'utils.hpp',
+   'mult.hpp' and 'predict.hpp'. All of them take values of type 'double' only, and those which
+   take an index array treat a NULL one as meaning contiguous positions. */
+typedef struct SimdKernels {
+    const char *isa_name;
+    size_t width;
+
+    /* partitioning */
+    size_t (*divide_subset)(size_t *ix_arr_st, size_t n, const double *x, bool gather_x,
+                            double split_point, bool separate_NA, size_t *buffer,
+                            size_t &n_left, size_t &n_NA);
+
+    /* node statistics */
+    void (*get_range)(const size_t *ix_arr, const double *x, size_t n, double &xmin, double &xmax);
+    size_t (*count_equal)(const size_t *ix_arr, const double *x, size_t n, double x0, bool skip_NA);
+    void (*mean_and_sd)(const size_t *ix_arr, const double *x, size_t n, bool skip_NA,
+                        double &x_sd, double &x_mean);
+
+    /* prediction */
+    void (*traverse_tree)(const char *nodes, const SimdTreeLayout &layout,
+                          const double *X, size_t ld, size_t nrows, size_t *terminal);
+
+    /* distance accumulation */
+    void (*add_to_pairs)(double *counter, size_t i, const size_t *ix_arr, size_t n_ix,
+                         size_t n, size_t ncomb, const double *weights, double w_i, double value);
+    void (*add_to_positions)(double *counter, size_t offset, const size_t *ix_arr, size_t n_ix,
+                             const double *weights, double w_i, double value);
+} SimdKernels;
+
+/* These are NULL when the compiler could not produce code for the instruction set,
+   or when the library was built with 'NO_SIMD_KERNELS' or 'NO_AVX512_KERNELS'. */
+extern const SimdKernels *const simd_kernels_avx2;
+extern const SimdKernels *const simd_kernels_avx512;
+
+#endif /* ISOTREE_SIMD_KERNELS_H */
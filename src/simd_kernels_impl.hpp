@@ -0,0 +1,570 @@
+/* Bodies of the kernels declared in 'simd_kernels.hpp'. This file is included once from each
+   of the per-instruction-set translation units, which define either 'SIMD_KERNELS_AVX512' or
+   'SIMD_KERNELS_AVX2' before including it, and it produces a table named 'simd_kernels_table'.
+
+   Everything here is 'static' and does not call any inline function from the standard library,
+   since otherwise the linker could merge a copy compiled for a newer instruction set with the
+   ones used by the rest of the library. */
+#include <cstdint>
+#include <cmath>
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define popcount_mask(m) __builtin_popcount((unsigned int)(m))
+#else
+    #define popcount_mask(m) _mm_popcnt_u32((unsigned int)(m))
+#endif
+
+#ifdef SIMD_KERNELS_AVX512
+    #define SIMD_WIDTH 8
+#else
+    #define SIMD_WIDTH 4
+#endif
+
+#define is_finite_value(x) (((x) > -HUGE_VAL) && ((x) < HUGE_VAL))
+#define read_value(ix_arr, x, pos) (((ix_arr) == NULL)? (x)[pos] : (x)[(ix_arr)[pos]])
+#define read_node_field(T, nodes, node, layout, field) \
+    (*(const T*)((nodes) + (node) * (layout).node_size + (layout).field))
+
+#ifndef SIMD_KERNELS_AVX512
+/* lanes of 32-bit integers that move the 64-bit elements selected by a 4-bit mask to the front */
+alignas(32) static const int32_t compress_mask_lanes[16][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 0}, {0, 1, 0, 0, 0, 0, 0, 0},
+        {2, 3, 0, 0, 0, 0, 0, 0}, {0, 1, 2, 3, 0, 0, 0, 0},
+        {4, 5, 0, 0, 0, 0, 0, 0}, {0, 1, 4, 5, 0, 0, 0, 0},
+        {2, 3, 4, 5, 0, 0, 0, 0}, {0, 1, 2, 3, 4, 5, 0, 0},
+        {6, 7, 0, 0, 0, 0, 0, 0}, {0, 1, 6, 7, 0, 0, 0, 0},
+        {2, 3, 6, 7, 0, 0, 0, 0}, {0, 1, 2, 3, 6, 7, 0, 0},
+        {4, 5, 6, 7, 0, 0, 0, 0}, {0, 1, 4, 5, 6, 7, 0, 0},
+        {2, 3, 4, 5, 6, 7, 0, 0}, {0, 1, 2, 3, 4, 5, 6, 7},
+};
+#endif
+
+/* Loads the values at positions [pos, pos + SIMD_WIDTH) of 'ix_arr', or at those positions of 'x'
+   itself if 'ix_arr' is NULL. 'simd_is_finite' produces a mask of the elements that are neither
+   NaN nor infinite. */
+#ifdef SIMD_KERNELS_AVX512
+/* The AVX512 code uses the masked forms of the intrinsics with an explicit source, since the
+   unmasked ones in GCC pass an uninitialized '_mm512_undefined_*' value to the builtins, which
+   produces 'uninitialized' warnings wherever they get inlined (including at link time with LTO). */
+#define MASK_ALL ((__mmask8)0xFF)
+
+static inline __m512d simd_gather(const double *x, __m512i v_ix)
+{
+    return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), MASK_ALL, v_ix, (const void*)x, sizeof(double));
+}
+
+static inline __m512d simd_load_values(const size_t *ix_arr, const double *x, size_t pos)
+{
+    if (ix_arr == NULL) return _mm512_loadu_pd(x + pos);
+    return simd_gather(x, _mm512_loadu_si512((const void*)(ix_arr + pos)));
+}
+
+static inline __mmask8 simd_is_finite(__m512d v_x)
+{
+    return _mm512_cmp_pd_mask(_mm512_abs_pd(v_x), _mm512_set1_pd(HUGE_VAL), _CMP_LT_OQ);
+}
+#else
+static inline __m256d simd_load_values(const size_t *ix_arr, const double *x, size_t pos)
+{
+    if (ix_arr == NULL) return _mm256_loadu_pd(x + pos);
+    return _mm256_i64gather_pd(x, _mm256_loadu_si256((const __m256i*)(ix_arr + pos)), sizeof(double));
+}
+
+static inline __m256d simd_is_finite(__m256d v_x)
+{
+    return _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.), v_x), _mm256_set1_pd(HUGE_VAL), _CMP_LT_OQ);
+}
+
+#endif
+
+static inline double simd_reduce_add(__m256d v)
+{
+    __m128d v2 = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(v2, _mm_unpackhi_pd(v2, v2)));
+}
+
+static inline double simd_reduce_min(__m256d v)
+{
+    __m128d v2 = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(v2, _mm_unpackhi_pd(v2, v2)));
+}
+
+static inline double simd_reduce_max(__m256d v)
+{
+    __m128d v2 = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(v2, _mm_unpackhi_pd(v2, v2)));
+}
+
+#ifdef SIMD_KERNELS_AVX512
+static inline __m256d simd_low_half(__m512d v)
+{
+    return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), MASK_ALL, v, 0);
+}
+
+static inline __m256d simd_high_half(__m512d v)
+{
+    return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), MASK_ALL, v, 1);
+}
+
+static inline double simd_reduce_add(__m512d v)
+{
+    return simd_reduce_add(_mm256_add_pd(simd_low_half(v), simd_high_half(v)));
+}
+
+static inline double simd_reduce_min(__m512d v)
+{
+    return simd_reduce_min(_mm256_min_pd(simd_low_half(v), simd_high_half(v)));
+}
+
+static inline double simd_reduce_max(__m512d v)
+{
+    return simd_reduce_max(_mm256_max_pd(simd_low_half(v), simd_high_half(v)));
+}
+#endif
+
+static size_t simd_divide_subset_kernel(size_t *ix_arr_st, size_t n, const double *x, bool gather_x,
+                                        double split_point, bool separate_NA, size_t *buffer,
+                                        size_t &n_left, size_t &n_NA)
+{
+    size_t pos = 0;
+    size_t n_right = 0;
+    size_t n_NA_block;
+    alignas(64) size_t ix_NA[8] = {0};
+    n_left = 0;
+    n_NA = 0;
+
+    /* AVX512 can store only the selected elements */
+    #ifdef SIMD_KERNELS_AVX512
+    const __m512d v_split = _mm512_set1_pd(split_point);
+    __m512i v_ix;
+    __m512d v_x;
+    __mmask8 m_left, m_NA, m_right;
+    for (; pos + 8 <= n; pos += 8)
+    {
+        v_ix = _mm512_loadu_si512((const void*)(ix_arr_st + pos));
+        v_x = gather_x? simd_gather(x, v_ix) : _mm512_loadu_pd(x + pos);
+        m_left = _mm512_cmp_pd_mask(v_x, v_split, _CMP_LE_OQ);
+        m_NA = separate_NA? _mm512_cmp_pd_mask(v_x, v_x, _CMP_UNORD_Q) : (__mmask8)0;
+        m_right = (__mmask8)~(m_left | m_NA);
+        _mm512_mask_compressstoreu_epi64((void*)(ix_arr_st + n_left), m_left, v_ix);
+        _mm512_mask_compressstoreu_epi64((void*)(buffer + n_right), m_right, v_ix);
+        n_left += popcount_mask(m_left);
+        n_right += popcount_mask(m_right);
+        if (m_NA)
+        {
+            _mm512_mask_compressstoreu_epi64((void*)ix_NA, m_NA, v_ix);
+            n_NA_block = popcount_mask(m_NA);
+            for (size_t ix = 0; ix < n_NA_block; ix++)
+                buffer[n - 1 - (n_NA++)] = ix_NA[ix];
+        }
+    }
+
+    /* AVX2 needs to shuffle the selected elements to the front and store all of them, but the
+       extra ones written past the end of each branch fall in positions that are either already
+       processed or not yet used by any branch */
+    #else
+    const __m256d v_split = _mm256_set1_pd(split_point);
+    __m256i v_ix;
+    __m256d v_x;
+    int m_left, m_NA, m_right;
+    for (; pos + 4 <= n; pos += 4)
+    {
+        v_ix = _mm256_loadu_si256((const __m256i*)(ix_arr_st + pos));
+        v_x = gather_x? _mm256_i64gather_pd(x, v_ix, sizeof(double)) : _mm256_loadu_pd(x + pos);
+        m_left = _mm256_movemask_pd(_mm256_cmp_pd(v_x, v_split, _CMP_LE_OQ));
+        m_NA = separate_NA? _mm256_movemask_pd(_mm256_cmp_pd(v_x, v_x, _CMP_UNORD_Q)) : 0;
+        m_right = ~(m_left | m_NA) & 15;
+        _mm256_storeu_si256((__m256i*)(ix_arr_st + n_left),
+                            _mm256_permutevar8x32_epi32(v_ix, _mm256_load_si256((const __m256i*)compress_mask_lanes[m_left])));
+        _mm256_storeu_si256((__m256i*)(buffer + n_right),
+                            _mm256_permutevar8x32_epi32(v_ix, _mm256_load_si256((const __m256i*)compress_mask_lanes[m_right])));
+        n_left += popcount_mask(m_left);
+        n_right += popcount_mask(m_right);
+        if (m_NA)
+        {
+            _mm256_store_si256((__m256i*)ix_NA,
+                               _mm256_permutevar8x32_epi32(v_ix, _mm256_load_si256((const __m256i*)compress_mask_lanes[m_NA])));
+            n_NA_block = popcount_mask(m_NA);
+            for (size_t ix = 0; ix < n_NA_block; ix++)
+                buffer[n - 1 - (n_NA++)] = ix_NA[ix];
+        }
+    }
+    #endif
+    return pos;
+}
+
+static void simd_get_range_kernel(const size_t *ix_arr, const double *x, size_t n, double &xmin, double &xmax)
+{
+    size_t pos = 0;
+    /* note: when one of the operands is NaN, min/max return the second one */
+    #ifdef SIMD_KERNELS_AVX512
+    __m512d v_min = _mm512_set1_pd(HUGE_VAL);
+    __m512d v_max = _mm512_set1_pd(-HUGE_VAL);
+    __m512d v_x;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_x = simd_load_values(ix_arr, x, pos);
+        v_min = _mm512_mask_min_pd(v_min, MASK_ALL, v_x, v_min);
+        v_max = _mm512_mask_max_pd(v_max, MASK_ALL, v_x, v_max);
+    }
+    xmin = simd_reduce_min(v_min);
+    xmax = simd_reduce_max(v_max);
+    #else
+    __m256d v_min = _mm256_set1_pd(HUGE_VAL);
+    __m256d v_max = _mm256_set1_pd(-HUGE_VAL);
+    __m256d v_x;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_x = simd_load_values(ix_arr, x, pos);
+        v_min = _mm256_min_pd(v_x, v_min);
+        v_max = _mm256_max_pd(v_x, v_max);
+    }
+    xmin = simd_reduce_min(v_min);
+    xmax = simd_reduce_max(v_max);
+    #endif
+
+    double xval;
+    for (; pos < n; pos++)
+    {
+        xval = read_value(ix_arr, x, pos);
+        xmin = (xval < xmin)? xval : xmin;
+        xmax = (xval > xmax)? xval : xmax;
+    }
+}
+
+static size_t simd_count_equal_kernel(const size_t *ix_arr, const double *x, size_t n, double x0, bool skip_NA)
+{
+    size_t pos = 0;
+    #ifdef SIMD_KERNELS_AVX512
+    const __m512d v_x0 = _mm512_set1_pd(x0);
+    __m512d v_x;
+    __mmask8 m_diff;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_x = simd_load_values(ix_arr, x, pos);
+        if (skip_NA)
+            m_diff = _mm512_mask_cmp_pd_mask(simd_is_finite(v_x), v_x, v_x0, _CMP_NEQ_OQ);
+        else
+            m_diff = _mm512_cmp_pd_mask(v_x, v_x0, _CMP_NEQ_UQ);
+        if (m_diff) break;
+    }
+    #else
+    const __m256d v_x0 = _mm256_set1_pd(x0);
+    __m256d v_x, v_diff;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_x = simd_load_values(ix_arr, x, pos);
+        if (skip_NA)
+            v_diff = _mm256_and_pd(simd_is_finite(v_x), _mm256_cmp_pd(v_x, v_x0, _CMP_NEQ_OQ));
+        else
+            v_diff = _mm256_cmp_pd(v_x, v_x0, _CMP_NEQ_UQ);
+        if (_mm256_movemask_pd(v_diff)) break;
+    }
+    #endif
+    return pos;
+}
+
+static void simd_mean_and_sd_kernel(const size_t *ix_arr, const double *x, size_t n, bool skip_NA,
+                                    double &x_sd, double &x_mean)
+{
+    size_t pos = 0;
+    if (skip_NA)
+    {
+        while (pos < n && !is_finite_value(read_value(ix_arr, x, pos))) pos++;
+        if (pos == n)
+        {
+            x_mean = 0;
+            x_sd   = 0;
+            return;
+        }
+    }
+    const double x_ref = read_value(ix_arr, x, pos);
+    size_t cnt = 0;
+    double sum_dev, sum_sq_dev;
+
+    #ifdef SIMD_KERNELS_AVX512
+    const __m512d v_ref = _mm512_set1_pd(x_ref);
+    __m512d v_sum = _mm512_setzero_pd();
+    __m512d v_sum_sq = _mm512_setzero_pd();
+    __m512d v_dev;
+    __mmask8 m_take;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_dev = simd_load_values(ix_arr, x, pos);
+        m_take = skip_NA? simd_is_finite(v_dev) : (__mmask8)0xFF;
+        v_dev = _mm512_maskz_sub_pd(m_take, v_dev, v_ref);
+        v_sum = _mm512_add_pd(v_sum, v_dev);
+        v_sum_sq = _mm512_fmadd_pd(v_dev, v_dev, v_sum_sq);
+        cnt += popcount_mask(m_take);
+    }
+    sum_dev = simd_reduce_add(v_sum);
+    sum_sq_dev = simd_reduce_add(v_sum_sq);
+    #else
+    const __m256d v_ref = _mm256_set1_pd(x_ref);
+    const __m256d v_all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256d v_sum = _mm256_setzero_pd();
+    __m256d v_sum_sq = _mm256_setzero_pd();
+    __m256d v_x, v_take, v_dev;
+    for (; pos + SIMD_WIDTH <= n; pos += SIMD_WIDTH)
+    {
+        v_x = simd_load_values(ix_arr, x, pos);
+        v_take = skip_NA? simd_is_finite(v_x) : v_all;
+        v_dev = _mm256_and_pd(_mm256_sub_pd(v_x, v_ref), v_take);
+        v_sum = _mm256_add_pd(v_sum, v_dev);
+        v_sum_sq = _mm256_add_pd(v_sum_sq, _mm256_mul_pd(v_dev, v_dev));
+        cnt += popcount_mask(_mm256_movemask_pd(v_take));
+    }
+    sum_dev = simd_reduce_add(v_sum);
+    sum_sq_dev = simd_reduce_add(v_sum_sq);
+    #endif
+
+    double xval;
+    for (; pos < n; pos++)
+    {
+        xval = read_value(ix_arr, x, pos);
+        if (skip_NA && !is_finite_value(xval)) continue;
+        cnt++;
+        sum_dev += xval - x_ref;
+        sum_sq_dev += (xval - x_ref) * (xval - x_ref);
+    }
+
+    const double mean_dev = sum_dev / (double)cnt;
+    const double var = sum_sq_dev / (double)cnt - mean_dev * mean_dev;
+    x_mean = x_ref + mean_dev;
+    x_sd   = (var > 0)? std::sqrt(var) : 0.;
+}
+
+/* Traverses a block of rows at a time, one per lane, until all of them reach a terminal node.
+   Lanes that already finished are masked out of the gathers. The node indices are multiplied by
+   the size of a node through 32-bit products, hence the callers must ensure that the trees have
+   less than 2^32 nodes and that 'SIMD_WIDTH * ld' also fits in 32 bits. */
+static void simd_traverse_tree_kernel(const char *nodes, const SimdTreeLayout &layout,
+                                      const double *X, size_t ld, size_t nrows, size_t *terminal)
+{
+    size_t row = 0;
+    #ifdef SIMD_KERNELS_AVX512
+    const __m512i v_node_size = _mm512_set1_epi64((long long)layout.node_size);
+    const __m512i v_zero = _mm512_setzero_si512();
+    const __m512i v_lane_offset = _mm512_maskz_mul_epu32(MASK_ALL, _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0),
+                                                         _mm512_set1_epi64((long long)ld));
+    const char *ptr_col = nodes + layout.col_num;
+    const char *ptr_split = nodes + layout.num_split;
+    const char *ptr_left = nodes + layout.tree_left;
+    const char *ptr_right = nodes + layout.tree_right;
+    __m512i v_node, v_pos, v_left, v_right, v_col;
+    __m512d v_x, v_split;
+    __mmask8 m_active, m_le;
+    for (; row + SIMD_WIDTH <= nrows; row += SIMD_WIDTH)
+    {
+        const double *X_block = X + row * ld;
+        v_node = v_zero;
+        v_pos = v_zero;
+        m_active = 0xFF;
+        while (true)
+        {
+            v_left = _mm512_mask_i64gather_epi64(v_zero, m_active, v_pos, (const void*)ptr_left, 1);
+            m_active = _mm512_mask_cmpneq_epi64_mask(m_active, v_left, v_zero);
+            if (!m_active) break;
+            v_right = _mm512_mask_i64gather_epi64(v_zero, m_active, v_pos, (const void*)ptr_right, 1);
+            v_col = _mm512_mask_i64gather_epi64(v_zero, m_active, v_pos, (const void*)ptr_col, 1);
+            v_split = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m_active, v_pos, (const void*)ptr_split, 1);
+            v_x = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m_active, _mm512_add_epi64(v_lane_offset, v_col),
+                                           (const void*)X_block, sizeof(double));
+            m_le = _mm512_cmp_pd_mask(v_x, v_split, _CMP_LE_OQ);
+            v_node = _mm512_mask_mov_epi64(v_node, m_active, _mm512_mask_blend_epi64(m_le, v_right, v_left));
+            v_pos = _mm512_maskz_mul_epu32(MASK_ALL, v_node, v_node_size);
+        }
+        _mm512_storeu_si512((void*)(terminal + row), v_node);
+    }
+    #else
+    const __m256i v_node_size = _mm256_set1_epi64x((long long)layout.node_size);
+    const __m256i v_zero = _mm256_setzero_si256();
+    const __m256i v_lane_offset = _mm256_mul_epu32(_mm256_set_epi64x(3, 2, 1, 0), _mm256_set1_epi64x((long long)ld));
+    const long long *ptr_col = (const long long*)(nodes + layout.col_num);
+    const double *ptr_split = (const double*)(nodes + layout.num_split);
+    const long long *ptr_left = (const long long*)(nodes + layout.tree_left);
+    const long long *ptr_right = (const long long*)(nodes + layout.tree_right);
+    __m256i v_node, v_pos, v_left, v_right, v_col, v_active;
+    __m256d v_x, v_split, v_le;
+    for (; row + SIMD_WIDTH <= nrows; row += SIMD_WIDTH)
+    {
+        const double *X_block = X + row * ld;
+        v_node = v_zero;
+        v_pos = v_zero;
+        v_active = _mm256_set1_epi64x(-1);
+        while (true)
+        {
+            v_left = _mm256_mask_i64gather_epi64(v_zero, ptr_left, v_pos, v_active, 1);
+            v_active = _mm256_andnot_si256(_mm256_cmpeq_epi64(v_left, v_zero), v_active);
+            if (_mm256_testz_si256(v_active, v_active)) break;
+            v_right = _mm256_mask_i64gather_epi64(v_zero, ptr_right, v_pos, v_active, 1);
+            v_col = _mm256_mask_i64gather_epi64(v_zero, ptr_col, v_pos, v_active, 1);
+            v_split = _mm256_mask_i64gather_pd(_mm256_setzero_pd(), ptr_split, v_pos,
+                                               _mm256_castsi256_pd(v_active), 1);
+            v_x = _mm256_mask_i64gather_pd(_mm256_setzero_pd(), X_block, _mm256_add_epi64(v_lane_offset, v_col),
+                                           _mm256_castsi256_pd(v_active), sizeof(double));
+            v_le = _mm256_cmp_pd(v_x, v_split, _CMP_LE_OQ);
+            v_node = _mm256_blendv_epi8(v_node,
+                                        _mm256_blendv_epi8(v_right, v_left, _mm256_castpd_si256(v_le)),
+                                        v_active);
+            v_pos = _mm256_mul_epu32(v_node, v_node_size);
+        }
+        _mm256_storeu_si256((__m256i*)(terminal + row), v_node);
+    }
+    #endif
+
+    size_t node;
+    for (; row < nrows; row++)
+    {
+        node = 0;
+        while (read_node_field(size_t, nodes, node, layout, tree_left) != 0)
+        {
+            node = (X[row * ld + read_node_field(size_t, nodes, node, layout, col_num)]
+                        <=
+                    read_node_field(double, nodes, node, layout, num_split))?
+                   read_node_field(size_t, nodes, node, layout, tree_left)
+                        :
+                   read_node_field(size_t, nodes, node, layout, tree_right);
+        }
+        terminal[row] = node;
+    }
+}
+
+/* Adds 'value' (or 'w_i * weights[j] * value' if passing weights) to the entries of 'counter' that
+   correspond to the pairs formed by 'i' and each 'j' in 'ix_arr', indexed as in macro 'ix_comb'.
+   Since the rows in 'ix_arr' are all different, the positions within a block never collide.
+   The triangular offsets are calculated through 32-bit products, hence 'n' must fit in 32 bits. */
+static void simd_add_to_pairs_kernel(double *counter, size_t i, const size_t *ix_arr, size_t n_ix,
+                                     size_t n, size_t ncomb, const double *weights, double w_i, double value)
+{
+    size_t pos = 0;
+    #ifdef SIMD_KERNELS_AVX512
+    const __m512i v_i = _mm512_set1_epi64((long long)i);
+    const __m512i v_n = _mm512_set1_epi64((long long)n);
+    const __m512i v_one = _mm512_set1_epi64(1);
+    const __m512i v_base = _mm512_set1_epi64((long long)(ncomb - 1));
+    const __m512d v_w_i = _mm512_set1_pd(w_i);
+    const __m512d v_value = _mm512_set1_pd(value);
+    __m512i v_j, v_lo, v_hi, v_nlo, v_idx;
+    __m512d v_add;
+    for (; pos + SIMD_WIDTH <= n_ix; pos += SIMD_WIDTH)
+    {
+        v_j = _mm512_loadu_si512((const void*)(ix_arr + pos));
+        v_lo = _mm512_maskz_min_epu64(MASK_ALL, v_i, v_j);
+        v_hi = _mm512_maskz_max_epu64(MASK_ALL, v_i, v_j);
+        v_nlo = _mm512_sub_epi64(v_n, v_lo);
+        v_idx = _mm512_maskz_mul_epu32(MASK_ALL, v_nlo, _mm512_sub_epi64(v_nlo, v_one));
+        v_idx = _mm512_sub_epi64(_mm512_add_epi64(v_base, _mm512_sub_epi64(v_hi, v_lo)),
+                                 _mm512_maskz_srli_epi64(MASK_ALL, v_idx, 1));
+        v_add = v_value;
+        if (weights != NULL)
+            v_add = _mm512_mul_pd(_mm512_mul_pd(v_w_i, simd_gather(weights, v_j)), v_value);
+        _mm512_i64scatter_pd((void*)counter, v_idx, _mm512_add_pd(simd_gather(counter, v_idx), v_add),
+                             sizeof(double));
+    }
+    #else
+    const __m256i v_i = _mm256_set1_epi64x((long long)i);
+    const __m256i v_n = _mm256_set1_epi64x((long long)n);
+    const __m256i v_one = _mm256_set1_epi64x(1);
+    const __m256i v_base = _mm256_set1_epi64x((long long)(ncomb - 1));
+    const __m256d v_w_i = _mm256_set1_pd(w_i);
+    const __m256d v_value = _mm256_set1_pd(value);
+    alignas(32) size_t idx[4];
+    alignas(32) double add[4];
+    __m256i v_j, v_gt, v_lo, v_hi, v_nlo;
+    for (; pos + SIMD_WIDTH <= n_ix; pos += SIMD_WIDTH)
+    {
+        v_j = _mm256_loadu_si256((const __m256i*)(ix_arr + pos));
+        v_gt = _mm256_cmpgt_epi64(v_i, v_j);
+        v_lo = _mm256_blendv_epi8(v_i, v_j, v_gt);
+        v_hi = _mm256_blendv_epi8(v_j, v_i, v_gt);
+        v_nlo = _mm256_sub_epi64(v_n, v_lo);
+        _mm256_store_si256((__m256i*)idx,
+                           _mm256_sub_epi64(_mm256_add_epi64(v_base, _mm256_sub_epi64(v_hi, v_lo)),
+                                            _mm256_srli_epi64(_mm256_mul_epu32(v_nlo, _mm256_sub_epi64(v_nlo, v_one)), 1)));
+        if (weights == NULL)
+        {
+            counter[idx[0]] += value;
+            counter[idx[1]] += value;
+            counter[idx[2]] += value;
+            counter[idx[3]] += value;
+        }
+
+        else
+        {
+            _mm256_store_pd(add, _mm256_mul_pd(_mm256_mul_pd(v_w_i, _mm256_i64gather_pd(weights, v_j, sizeof(double))),
+                                               v_value));
+            counter[idx[0]] += add[0];
+            counter[idx[1]] += add[1];
+            counter[idx[2]] += add[2];
+            counter[idx[3]] += add[3];
+        }
+    }
+    #endif
+
+    size_t j, lo, hi;
+    for (; pos < n_ix; pos++)
+    {
+        j = ix_arr[pos];
+        lo = (i < j)? i : j;
+        hi = (i < j)? j : i;
+        counter[ncomb + (hi - lo) - 1 - ((n - lo) * (n - lo - 1)) / 2]
+            +=
+        (weights == NULL)? value : (w_i * weights[j] * value);
+    }
+}
+
+/* Same as above, but for entries 'counter[offset + j]', which are also all different. This one
+   needs scatters, so it is only provided for AVX512. */
+#ifdef SIMD_KERNELS_AVX512
+static void simd_add_to_positions_kernel(double *counter, size_t offset, const size_t *ix_arr, size_t n_ix,
+                                         const double *weights, double w_i, double value)
+{
+    size_t pos = 0;
+    const __m512i v_offset = _mm512_set1_epi64((long long)offset);
+    const __m512d v_w_i = _mm512_set1_pd(w_i);
+    const __m512d v_value = _mm512_set1_pd(value);
+    __m512i v_j, v_idx;
+    __m512d v_add;
+    for (; pos + SIMD_WIDTH <= n_ix; pos += SIMD_WIDTH)
+    {
+        v_j = _mm512_loadu_si512((const void*)(ix_arr + pos));
+        v_idx = _mm512_add_epi64(v_offset, v_j);
+        v_add = v_value;
+        if (weights != NULL)
+            v_add = _mm512_mul_pd(_mm512_mul_pd(v_w_i, simd_gather(weights, v_j)),
+                                  v_value);
+        _mm512_i64scatter_pd((void*)counter, v_idx,
+                             _mm512_add_pd(simd_gather(counter, v_idx), v_add),
+                             sizeof(double));
+    }
+
+    size_t j;
+    for (; pos < n_ix; pos++)
+    {
+        j = ix_arr[pos];
+        counter[offset + j] += (weights == NULL)? value : (w_i * weights[j] * value);
+    }
+}
+#endif
+
+static const SimdKernels simd_kernels_table = {
+    #ifdef SIMD_KERNELS_AVX512
+    "avx512f",
+    #else
+    "avx2",
+    #endif
+    SIMD_WIDTH,
+    simd_divide_subset_kernel,
+    simd_get_range_kernel,
+    simd_count_equal_kernel,
+    simd_mean_and_sd_kernel,
+    simd_traverse_tree_kernel,
+    simd_add_to_pairs_kernel,
+    #ifdef SIMD_KERNELS_AVX512
+    simd_add_to_positions_kernel
+    #else
+    NULL
+    #endif
+};
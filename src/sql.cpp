@@ -458,9 +458,9 @@ void extract_cond_isotree(const IsoForest &model, const IsoTree &tree,
                     }
                     bool added_left = false;
                     bool added_right = false;
-                    for (size_t categ = 0; categ < tree.cat_split.size(); categ++)
+                    for (size_t categ = 0; categ < (size_t)tree.ncat_split; categ++)
                     {
-                        switch(tree.cat_split[categ])
+                        switch(get_cat_split(tree, (int)categ))
                         {
                             case 1:
                             {
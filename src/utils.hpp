@@ -180,6 +180,12 @@ double expected_avg_depth(ldouble_safe approx_sample_size)
     }
 }
 
+/* Non-templated version, for code that is compiled outside of the template instantiations */
+double expected_avg_depth_dbl(size_t sample_size)
+{
+    return expected_avg_depth<double>(sample_size);
+}
+
 /* https://math.stackexchange.com/questions/3388518/expected-number-of-paths-required-to-separate-elements-in-a-binary-tree */
 #define THRESHOLD_EXACT_S 87670 /* difference is <5e-4 */
 double expected_separation_depth(size_t n)
@@ -258,11 +264,21 @@ double expected_separation_depth(ldouble_safe n)
     return s_l + diff * s_u;
 }
 
+/* The vectorized kernels calculate the positions of the pairs with 32-bit products */
+#define can_use_simd_pairs(n) (simd_kernels != NULL && (n) <= (size_t)UINT32_MAX)
+
 void increase_comb_counter(size_t ix_arr[], size_t st, size_t end, size_t n, double counter[], double exp_remainder)
 {
     size_t i, j;
     size_t ncomb = calc_ncomb(n);
-    if (exp_remainder <= 1)
+    if (can_use_simd_pairs(n))
+    {
+        const double value = (exp_remainder <= 1)? 1. : exp_remainder;
+        for (size_t el1 = st; el1 < end; el1++)
+            simd_kernels->add_to_pairs(counter, ix_arr[el1], ix_arr + el1 + 1, end - el1, n, ncomb,
+                                       (const double*)NULL, 1., value);
+    }
+    else if (exp_remainder <= 1)
         for (size_t el1 = st; el1 < end; el1++)
         {
             for (size_t el2 = el1 + 1; el2 <= end; el2++)
@@ -288,7 +304,14 @@ void increase_comb_counter(size_t ix_arr[], size_t st, size_t end, size_t n,
 {
     size_t i, j;
     size_t ncomb = calc_ncomb(n);
-    if (exp_remainder <= 1)
+    if (can_use_simd_pairs(n))
+    {
+        const double value = (exp_remainder <= 1)? 1. : exp_remainder;
+        for (size_t el1 = st; el1 < end; el1++)
+            simd_kernels->add_to_pairs(counter, ix_arr[el1], ix_arr + el1 + 1, end - el1, n, ncomb,
+                                       weights, weights[ix_arr[el1]], value);
+    }
+    else if (exp_remainder <= 1)
         for (size_t el1 = st; el1 < end; el1++)
         {
             for (size_t el2 = el1 + 1; el2 <= end; el2++)
@@ -341,7 +364,15 @@ void increase_comb_counter_in_groups(size_t ix_arr[], size_t st, size_t end, siz
     size_t n_group = std::distance(ix_arr + st, ptr_split_ix);
     n = n - split_ix;
 
-    if (exp_remainder <= 1)
+    if (simd_kernels != NULL && simd_kernels->add_to_positions != NULL)
+    {
+        const double value = (exp_remainder <= 1)? 1. : exp_remainder;
+        for (size_t ix1 = st; ix1 < st + n_group; ix1++)
+            simd_kernels->add_to_positions(counter, ix_arr[ix1] * n - split_ix,
+                                           ix_arr + st + n_group, end - st - n_group + 1,
+                                           (const double*)NULL, 1., value);
+    }
+    else if (exp_remainder <= 1)
         for (size_t ix1 = st; ix1 < st + n_group; ix1++)
             for (size_t ix2 = st + n_group; ix2 <= end; ix2++)
                 counter[ix_arr[ix1] * n + ix_arr[ix2] - split_ix]++;
@@ -358,7 +389,15 @@ void increase_comb_counter_in_groups(size_t ix_arr[], size_t st, size_t end, siz
     size_t n_group = std::distance(ix_arr + st, ptr_split_ix);
     n = n - split_ix;
 
-    if (exp_remainder <= 1)
+    if (simd_kernels != NULL && simd_kernels->add_to_positions != NULL)
+    {
+        const double value = (exp_remainder <= 1)? 1. : exp_remainder;
+        for (size_t ix1 = st; ix1 < st + n_group; ix1++)
+            simd_kernels->add_to_positions(counter, ix_arr[ix1] * n - split_ix,
+                                           ix_arr + st + n_group, end - st - n_group + 1,
+                                           weights, weights[ix_arr[ix1]], value);
+    }
+    else if (exp_remainder <= 1)
         for (size_t ix1 = st; ix1 < st + n_group; ix1++)
             for (size_t ix2 = st + n_group; ix2 <= end; ix2++)
                 counter[ix_arr[ix1] * n + ix_arr[ix2] - split_ix]
@@ -387,6 +426,47 @@ void tmat_to_dense(double *restrict tmat, double *restrict dmat, size_t n, doubl
         dmat[i + i * n] = fill_diag;
 }
 
+/* Ranks start at zero, and tied values get the average of the ranks that they span */
+void calc_ranks(const double x[], size_t n, double ranks[], size_t buffer_ix[])
+{
+    std::iota(buffer_ix, buffer_ix + n, (size_t)0);
+    std::sort(buffer_ix, buffer_ix + n,
+              [&x](const size_t a, const size_t b){return x[a] < x[b];});
+    size_t st = 0;
+    while (st < n)
+    {
+        size_t end = st + 1;
+        while (end < n && x[buffer_ix[end]] == x[buffer_ix[st]]) end++;
+        double avg_rank = 0.5 * (double)(st + end - 1);
+        for (size_t ix = st; ix < end; ix++)
+            ranks[buffer_ix[ix]] = avg_rank;
+        st = end;
+    }
+}
+
+/* Spearman's rank correlation, which doesn't change under monotonic transformations
+   of either input - thus it can compare the scores at any stage of standardization */
+double calc_rank_corr(const double x[], const double y[], size_t n)
+{
+    std::vector<double> ranks_x(n), ranks_y(n);
+    std::unique_ptr<size_t[]> buffer_ix(new size_t[n]);
+    calc_ranks(x, n, ranks_x.data(), buffer_ix.get());
+    calc_ranks(y, n, ranks_y.data(), buffer_ix.get());
+
+    /* the average rank is the same regardless of ties */
+    double mean_rank = 0.5 * (double)(n - 1);
+    double sxy = 0, sxx = 0, syy = 0;
+    for (size_t ix = 0; ix < n; ix++)
+    {
+        sxy += (ranks_x[ix] - mean_rank) * (ranks_y[ix] - mean_rank);
+        sxx += square(ranks_x[ix] - mean_rank);
+        syy += square(ranks_y[ix] - mean_rank);
+    }
+    if (sxx <= 0 || syy <= 0)
+        return (sxx <= 0 && syy <= 0)? 1. : 0.;
+    return sxy / std::sqrt(sxx * syy);
+}
+
 template <class real_t>
 void build_btree_sampler(std::vector<double> &btree_weights, real_t *restrict sample_weights,
                          size_t nrows, size_t &restrict log2_n, size_t &restrict btree_offset)
@@ -414,29 +494,113 @@ void build_btree_sampler(std::vector<double> &btree_weights, real_t *restrict sa
     }
 }
 
+/* Walker's alias method (with Vose's construction): each bucket holds the probability of keeping
+   its own index and the index to take otherwise, so that a draw with replacement is O(1)
+   https://www.keithschwarz.com/darts-dice-coins/ */
+template <class real_t>
+void build_alias_sampler(std::vector<double> &alias_prob, std::vector<size_t> &alias_ix,
+                         real_t *restrict sample_weights, size_t nrows)
+{
+    alias_prob.resize(nrows);
+    alias_ix.resize(nrows);
+
+    double wsum = 0;
+    for (size_t ix = 0; ix < nrows; ix++)
+        wsum += std::fmax(0., sample_weights[ix]);
+
+    if (std::isnan(wsum) || std::isinf(wsum) || wsum <= 0)
+    {
+        print_errmsg("Numeric precision error with sample weights, will not use them.\n");
+        alias_prob.clear();
+        alias_ix.clear();
+        alias_prob.shrink_to_fit();
+        alias_ix.shrink_to_fit();
+        return;
+    }
+
+    /* the small and large buckets are stacked from each end of 'alias_ix' while it is not yet used */
+    const double mult = (double)nrows / wsum;
+    size_t n_small = 0;
+    size_t n_large = 0;
+    for (size_t ix = 0; ix < nrows; ix++)
+    {
+        alias_prob[ix] = std::fmax(0., sample_weights[ix]) * mult;
+        if (alias_prob[ix] < 1.)
+            alias_ix[n_small++] = ix;
+        else
+            alias_ix[nrows - ++n_large] = ix;
+    }
+
+    std::vector<size_t> small(alias_ix.begin(), alias_ix.begin() + n_small);
+    std::vector<size_t> large(alias_ix.begin() + n_small, alias_ix.end());
+    size_t curr_small, curr_large;
+    while (!small.empty() && !large.empty())
+    {
+        curr_small = small.back(); small.pop_back();
+        curr_large = large.back();
+        alias_ix[curr_small] = curr_large;
+        alias_prob[curr_large] -= 1. - alias_prob[curr_small];
+        if (alias_prob[curr_large] < 1.)
+        {
+            large.pop_back();
+            small.push_back(curr_large);
+        }
+    }
+
+    /* whatever is left over is only due to rounding errors */
+    for (size_t ix : small)
+    {
+        alias_prob[ix] = 1.;
+        alias_ix[ix] = ix;
+    }
+    for (size_t ix : large)
+    {
+        alias_prob[ix] = 1.;
+        alias_ix[ix] = ix;
+    }
+}
+
+/* For weighted sampling without replacement, the binary tree is faster when the sample is a small
+   fraction of the rows, while drawing exponential keys for all of the rows and taking the smallest
+   ones ('Efraimidis-Spirakis') is faster when it takes a larger fraction. In timings, the cross-over
+   point was at around 1/10 to 1/5 of the rows. */
+bool prefer_btree_sampler(size_t ntake, size_t nrows) noexcept
+{
+    return ntake < nrows / 8;
+}
+
 template <class real_t, class ldouble_safe>
 void sample_random_rows(std::vector<size_t> &restrict ix_arr, size_t nrows, bool with_replacement,
                         RNG_engine &rnd_generator, std::vector<size_t> &restrict ix_all,
                         real_t *restrict sample_weights, std::vector<double> &restrict btree_weights,
-                        size_t log2_n, size_t btree_offset, std::vector<bool> &is_repeated)
+                        size_t log2_n, size_t btree_offset, std::vector<bool> &is_repeated,
+                        const double *restrict alias_prob, const size_t *restrict alias_ix)
 {
     size_t ntake = ix_arr.size();
 
     /* if with replacement, just generate random uniform numbers */
     if (with_replacement)
     {
-        if (sample_weights == NULL)
+        if (sample_weights == NULL || alias_prob == NULL)
         {
             std::uniform_int_distribution<size_t> runif(0, nrows - 1);
             for (size_t &ix : ix_arr)
                 ix = runif(rnd_generator);
         }
 
+        /* with the alias table, a single uniform number determines both the bucket and whether to take its alias */
         else
         {
-            std::discrete_distribution<size_t> runif(sample_weights, sample_weights + nrows);
+            UniformUnitInterval runif(0, 1);
+            const double nrows_dbl = (double)nrows;
+            double rnd_bucket;
+            size_t bucket;
             for (size_t &ix : ix_arr)
-                ix = runif(rnd_generator);
+            {
+                rnd_bucket = runif(rnd_generator) * nrows_dbl;
+                bucket = std::min((size_t)rnd_bucket, nrows - 1);
+                ix = ((rnd_bucket - (double)bucket) < alias_prob[bucket])? bucket : alias_ix[bucket];
+            }
         }
     }
 
@@ -449,27 +613,31 @@ void sample_random_rows(std::vector<size_t> &restrict ix_arr, size_t nrows, bool
 
     /* if there are sample weights, use binary trees to keep track and update weight
        https://stackoverflow.com/questions/57599509/c-random-non-repeated-integers-with-weights */
-    else if (sample_weights != NULL)
+    else if (sample_weights != NULL && !btree_weights.empty() && log2_n > 0)
     {
-        /* TODO: here could instead generate only 1 random number from zero to the full weight,
-           and then subtract from it as it goes down every level. Would have less precision
-           but should still work fine. */
-
+        /* only one random number is drawn per row, which then gets the weight of the
+           left branch subtracted from it whenever it goes down to the right */
+        UniformUnitInterval runif(0, 1);
         double rnd_subrange, w_left;
-        double curr_subrange;
         size_t curr_ix;
         for (size_t &ix : ix_arr)
         {
-            /* go down the tree by drawing a random number and
-               checking if it falls in the left or right ranges */
             curr_ix = 0;
-            curr_subrange = btree_weights[0];
+            rnd_subrange = runif(rnd_generator) * btree_weights[0];
             for (size_t lev = 0; lev < log2_n; lev++)
             {
-                rnd_subrange = std::uniform_real_distribution<double>(0., curr_subrange)(rnd_generator);
                 w_left = btree_weights[ix_child(curr_ix)];
-                curr_ix = ix_child(curr_ix) + (rnd_subrange >= w_left);
-                curr_subrange = btree_weights[curr_ix];
+                /* due to rounding, the number might end up past the sum of both children */
+                if (w_left <= 0 || (rnd_subrange >= w_left && btree_weights[ix_child(curr_ix) + 1] > 0))
+                {
+                    rnd_subrange -= w_left;
+                    curr_ix = ix_child(curr_ix) + 1;
+                }
+
+                else
+                {
+                    curr_ix = ix_child(curr_ix);
+                }
             }
 
             /* finally, determine element to choose in this iteration */
@@ -486,6 +654,46 @@ void sample_random_rows(std::vector<size_t> &restrict ix_arr, size_t nrows, bool
         }
     }
 
+    /* otherwise, draw a key '-log(U)/w' for each row and take the rows with the smallest keys
+       https://doi.org/10.1016/j.ipl.2005.11.003
+       here 'btree_weights' is only used as a buffer for the keys and a copy of them, as it's
+       faster to find the cut-off key over contiguous numbers than over indices to them */
+    else if (sample_weights != NULL)
+    {
+        btree_weights.resize(2 * nrows);
+        double *restrict keys = btree_weights.data();
+        double *restrict keys_copy = keys + nrows;
+
+        UniformUnitInterval runif(0, 1);
+        double w;
+        for (size_t row = 0; row < nrows; row++)
+        {
+            w = std::fmax(0., sample_weights[row]); /* zero and NaN weights get an infinite key */
+            keys[row] = (w > 0)? (-std::log1p(-runif(rnd_generator)) / w) : HUGE_VAL;
+        }
+
+        std::copy(keys, keys + nrows, keys_copy);
+        std::nth_element(keys_copy, keys_copy + (ntake - 1), keys_copy + nrows);
+        const double cutoff = keys_copy[ntake - 1];
+
+        /* ties at the cut-off (only expected with infinite keys) are taken in order of appearance */
+        size_t n_below = 0;
+        for (size_t row = 0; row < nrows; row++)
+            n_below += keys[row] < cutoff;
+        size_t n_ties = ntake - n_below;
+        size_t n_taken = 0;
+        for (size_t row = 0; row < nrows && n_taken < ntake; row++)
+        {
+            if (keys[row] < cutoff)
+                ix_arr[n_taken++] = row;
+            else if (keys[row] == cutoff && n_ties)
+            {
+                ix_arr[n_taken++] = row;
+                n_ties--;
+            }
+        }
+    }
+
     /* if no sample weights and not with replacement (most common case expected),
        then use different algorithms depending on the sampled fraction */
     else
@@ -662,6 +870,260 @@ double sample_random_uniform(double xmin, double xmax, RNG_engine &rng) noexcept
     return out;
 }
 
+/* Li, Kim-Hung. "Reservoir-sampling algorithms of time complexity O(n(1 + log(N/n)))."
+   ACM Transactions on Mathematical Software (TOMS) 20.4 (1994): 481-493.
+   Efraimidis, Pavlos S., and Paul G. Spirakis. "Weighted random sampling with a reservoir."
+   Information processing letters 97.5 (2006): 181-185. */
+template <class real_t>
+void RowReservoirs<real_t>::initialize(size_t ntrees, size_t sample_size, size_t ncols_numeric, size_t ncols_categ,
+                                       bool use_weights, bool keep_weights, uint64_t random_seed)
+{
+    this->ntrees = ntrees;
+    this->sample_size = sample_size;
+    this->ncols_numeric = ncols_numeric;
+    this->ncols_categ = ncols_categ;
+    this->use_weights = use_weights;
+    this->keep_weights = keep_weights;
+    this->nrows_seen = 0;
+    this->n_filled = 0;
+    this->cum_weight = 0;
+    this->rnd_generator.seed(random_seed);
+
+    size_t nrows_tot = this->ntrees * this->sample_size;
+    this->numeric_data.resize(nrows_tot * this->ncols_numeric);
+    this->categ_data.resize(nrows_tot * this->ncols_categ);
+    if (this->keep_weights)
+        this->sample_weights.resize(nrows_tot);
+    this->jump_param.resize(this->ntrees);
+    if (this->use_weights)
+    {
+        this->log_keys.resize(nrows_tot);
+        this->key_heap.resize(nrows_tot);
+    }
+    this->next_take.clear();
+    this->next_take.reserve(this->ntrees);
+}
+
+template <class real_t>
+double RowReservoirs<real_t>::draw_positive_unif()
+{
+    double u;
+    do { u = UniformUnitInterval(0, 1)(this->rnd_generator); } while (u <= 0);
+    return u;
+}
+
+template <class real_t>
+void RowReservoirs<real_t>::write_row(size_t row, const real_t numeric_row[], const int categ_row[], double weight)
+{
+    size_t nrows_tot = this->ntrees * this->sample_size;
+    for (size_t col = 0; col < this->ncols_numeric; col++)
+        this->numeric_data[row + col * nrows_tot] = numeric_row[col];
+    for (size_t col = 0; col < this->ncols_categ; col++)
+        this->categ_data[row + col * nrows_tot] = categ_row[col];
+    if (this->keep_weights)
+        this->sample_weights[row] = weight;
+}
+
+/* Rows are first written only to the block of the first tree, which gets copied to
+   the others once it is full, so that short streams don't pay for all the copies. */
+template <class real_t>
+void RowReservoirs<real_t>::finish_filling()
+{
+    size_t nrows_tot = this->ntrees * this->sample_size;
+    for (size_t tree = 1; tree < this->ntrees; tree++)
+    {
+        for (size_t col = 0; col < this->ncols_numeric; col++)
+            std::copy(this->numeric_data.begin() + col * nrows_tot,
+                      this->numeric_data.begin() + col * nrows_tot + this->sample_size,
+                      this->numeric_data.begin() + col * nrows_tot + tree * this->sample_size);
+        for (size_t col = 0; col < this->ncols_categ; col++)
+            std::copy(this->categ_data.begin() + col * nrows_tot,
+                      this->categ_data.begin() + col * nrows_tot + this->sample_size,
+                      this->categ_data.begin() + col * nrows_tot + tree * this->sample_size);
+        if (this->keep_weights)
+            std::copy(this->sample_weights.begin(),
+                      this->sample_weights.begin() + this->sample_size,
+                      this->sample_weights.begin() + tree * this->sample_size);
+    }
+
+    for (size_t tree = 0; tree < this->ntrees; tree++)
+    {
+        if (this->use_weights)
+        {
+            size_t *restrict heap = this->key_heap.data() + tree * this->sample_size;
+            const double *restrict keys = this->log_keys.data();
+            std::iota(heap, heap + this->sample_size, tree * this->sample_size);
+            std::make_heap(heap, heap + this->sample_size,
+                           [keys](const size_t a, const size_t b){return keys[a] > keys[b];});
+            this->jump_param[tree] = keys[heap[0]];
+        }
+
+        else
+        {
+            this->jump_param[tree] = std::exp(std::log(this->draw_positive_unif()) / (double)this->sample_size);
+        }
+
+        this->set_next_jump(tree);
+    }
+}
+
+template <class real_t>
+void RowReservoirs<real_t>::set_next_jump(size_t tree)
+{
+    double jump;
+    if (this->use_weights)
+        jump = std::log(this->draw_positive_unif()) / this->jump_param[tree];
+    else
+        jump = std::floor(std::log(this->draw_positive_unif()) / std::log1p(-this->jump_param[tree])) + 1.;
+    if (std::isnan(jump)) jump = HUGE_VAL;
+    this->next_take.emplace_back(this->cum_weight + jump, tree);
+    std::push_heap(this->next_take.begin(), this->next_take.end(),
+                   [](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b){return a > b;});
+}
+
+template <class real_t>
+void RowReservoirs<real_t>::push_row(const real_t numeric_row[], const int categ_row[], double weight)
+{
+    if (this->use_weights && (std::isnan(weight) || weight <= 0))
+        return;
+    if (!this->use_weights)
+        weight = this->keep_weights? weight : 1.;
+    this->nrows_seen++;
+    double w_step = this->use_weights? weight : 1.;
+
+    if (this->n_filled < this->sample_size)
+    {
+        this->write_row(this->n_filled, numeric_row, categ_row, weight);
+        if (this->use_weights)
+        {
+            for (size_t tree = 0; tree < this->ntrees; tree++)
+                this->log_keys[tree * this->sample_size + this->n_filled]
+                    = std::log(this->draw_positive_unif()) / w_step;
+        }
+        this->n_filled++;
+        this->cum_weight += w_step;
+        if (this->n_filled == this->sample_size)
+            this->finish_filling();
+        return;
+    }
+
+    this->cum_weight += w_step;
+    const auto heap_cmp = [](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b){return a > b;};
+    this->trees_taking.clear();
+    while (!this->next_take.empty() && this->next_take.front().first <= this->cum_weight)
+    {
+        this->trees_taking.push_back(this->next_take.front().second);
+        std::pop_heap(this->next_take.begin(), this->next_take.end(), heap_cmp);
+        this->next_take.pop_back();
+    }
+
+    for (const size_t tree : this->trees_taking)
+    {
+        size_t replaced;
+        if (this->use_weights)
+        {
+            /* the new key is drawn conditionally on being larger than the current smallest one */
+            size_t *restrict heap = this->key_heap.data() + tree * this->sample_size;
+            double *restrict keys = this->log_keys.data();
+            const auto key_cmp = [keys](const size_t a, const size_t b){return keys[a] > keys[b];};
+            std::pop_heap(heap, heap + this->sample_size, key_cmp);
+            replaced = heap[this->sample_size - 1];
+            double thr = std::exp(w_step * this->jump_param[tree]);
+            double r = thr + (1. - thr) * UniformUnitInterval(0, 1)(this->rnd_generator);
+            keys[replaced] = std::log(std::fmax(r, thr)) / w_step;
+            std::push_heap(heap, heap + this->sample_size, key_cmp);
+            this->jump_param[tree] = keys[heap[0]];
+        }
+
+        else
+        {
+            replaced = tree * this->sample_size
+                        + std::uniform_int_distribution<size_t>(0, this->sample_size - 1)(this->rnd_generator);
+            this->jump_param[tree] *= std::exp(std::log(this->draw_positive_unif()) / (double)this->sample_size);
+        }
+
+        this->write_row(replaced, numeric_row, categ_row, weight);
+        this->set_next_jump(tree);
+    }
+}
+
+template <class real_t>
+bool RowReservoirs<real_t>::is_full()
+{
+    return this->n_filled == this->sample_size;
+}
+
+/* If the stream had fewer rows than the sample size, all the reservoirs are the same, so
+   this leaves only the filled part of the first block as a regular column-major matrix. */
+template <class real_t>
+void RowReservoirs<real_t>::compact()
+{
+    size_t nrows_tot = this->ntrees * this->sample_size;
+    for (size_t col = 0; col < this->ncols_numeric; col++)
+        std::copy(this->numeric_data.begin() + col * nrows_tot,
+                  this->numeric_data.begin() + col * nrows_tot + this->n_filled,
+                  this->numeric_data.begin() + col * this->n_filled);
+    for (size_t col = 0; col < this->ncols_categ; col++)
+        std::copy(this->categ_data.begin() + col * nrows_tot,
+                  this->categ_data.begin() + col * nrows_tot + this->n_filled,
+                  this->categ_data.begin() + col * this->n_filled);
+    this->numeric_data.resize(this->n_filled * this->ncols_numeric);
+    this->categ_data.resize(this->n_filled * this->ncols_categ);
+    this->numeric_data.shrink_to_fit();
+    this->categ_data.shrink_to_fit();
+    if (this->keep_weights) {
+        this->sample_weights.resize(this->n_filled);
+        this->sample_weights.shrink_to_fit();
+    }
+}
+
+/* The stripes are contiguous ranges of rows, since the rows that land in a terminal node
+   are already scattered. Locks are only needed when there is more than one thread. */
+void RowStripes::initialize(size_t nrows, int nthreads)
+{
+    this->stripe_shift = 0;
+    while ((nrows >> this->stripe_shift) > ROW_SUMS_NSTRIPES)
+        this->stripe_shift++;
+    this->nstripes = ((std::max(nrows, (size_t)1) - 1) >> this->stripe_shift) + 1;
+    #ifdef _OPENMP
+    if (nthreads > 1)
+    {
+        this->locks.resize(this->nstripes);
+        for (omp_lock_t &lock : this->locks)
+            omp_init_lock(&lock);
+    }
+    #endif
+}
+
+size_t RowStripes::get_stripe(size_t row)
+{
+    return row >> this->stripe_shift;
+}
+
+void RowStripes::lock(size_t stripe)
+{
+    #ifdef _OPENMP
+    if (!this->locks.empty())
+        omp_set_lock(&this->locks[stripe]);
+    #endif
+}
+
+void RowStripes::unlock(size_t stripe)
+{
+    #ifdef _OPENMP
+    if (!this->locks.empty())
+        omp_unset_lock(&this->locks[stripe]);
+    #endif
+}
+
+RowStripes::~RowStripes()
+{
+    #ifdef _OPENMP
+    for (omp_lock_t &lock : this->locks)
+        omp_destroy_lock(&lock);
+    #endif
+}
+
 template <class ldouble_safe>
 template <class other_t>
 ColumnSampler<ldouble_safe>& ColumnSampler<ldouble_safe>::operator=(const ColumnSampler<other_t> &other)
@@ -675,6 +1137,11 @@ ColumnSampler<ldouble_safe>& ColumnSampler<ldouble_safe>::operator=(const Column
     this->tree_levels = other.tree_levels;
     this->offset = other.offset;
     this->n_dropped = other.n_dropped;
+    this->drop_log = other.drop_log;
+    this->alias_prob = other.alias_prob;
+    this->alias_col = other.alias_col;
+    this->alias_wtot = other.alias_wtot;
+    this->n_tree_draws = other.n_tree_draws;
     return *this;
 }
 
@@ -709,6 +1176,9 @@ void ColumnSampler<ldouble_safe>::initialize(real_t weights[], size_t n_cols)
     }
 
     this->n_dropped = 0;
+    this->drop_log.clear();
+    this->alias_prob.clear();
+    this->n_tree_draws = 0;
 }
 
 template <class ldouble_safe>
@@ -718,6 +1188,8 @@ void ColumnSampler<ldouble_safe>::drop_weights()
     this->tree_weights.shrink_to_fit();
     this->initialize(n_cols);
     this->n_dropped = 0;
+    this->drop_log.clear();
+    this->alias_prob.clear();
 }
 
 template <class ldouble_safe>
@@ -829,6 +1301,9 @@ void ColumnSampler<ldouble_safe>::leave_m_cols(size_t m, RNG_engine &rnd_generat
             this->tree_weights[ix_parent(ix)] += this->tree_weights[ix];
 
         this->n_dropped = this->n_cols - m;
+        this->drop_log.clear();
+        this->alias_prob.clear();
+        this->n_tree_draws = 0;
     }
 }
 
@@ -866,6 +1341,7 @@ void ColumnSampler<ldouble_safe>::drop_col(size_t col, size_t nobs_left)
     {
         this->n_dropped++;
         size_t curr_ix = col + this->offset;
+        this->drop_log.emplace_back(col, this->tree_weights[curr_ix]);
         this->tree_weights[curr_ix] = 0.;
         for (size_t lev = 0; lev < this->tree_levels; lev++)
         {
@@ -890,6 +1366,80 @@ void ColumnSampler<ldouble_safe>::drop_from_tail(size_t col)
     std::swap(this->col_indices[col], this->col_indices[--this->curr_pos]);
 }
 
+template <class ldouble_safe>
+size_t ColumnSampler<ldouble_safe>::get_drop_log_size()
+{
+    return this->drop_log.size();
+}
+
+/* Puts back the weights of the columns that were dropped after the log had 'drop_log_size'
+   entries, in reverse order. Since the sums are recalculated from the children in the same
+   way as when dropping them, the tree ends up exactly as it was at that point. */
+template <class ldouble_safe>
+void ColumnSampler<ldouble_safe>::undo_drops(size_t drop_log_size)
+{
+    size_t curr_ix;
+    while (this->drop_log.size() > drop_log_size)
+    {
+        curr_ix = this->drop_log.back().first + this->offset;
+        this->tree_weights[curr_ix] = this->drop_log.back().second;
+        this->drop_log.pop_back();
+        this->n_dropped--;
+        for (size_t lev = 0; lev < this->tree_levels; lev++)
+        {
+            curr_ix = ix_parent(curr_ix);
+            this->tree_weights[curr_ix] =   this->tree_weights[ix_child(curr_ix)]
+                                          + this->tree_weights[ix_child(curr_ix) + 1];
+        }
+    }
+}
+
+/* Vose's method, for the weights before any of the logged drops, so that undoing those
+   does not invalidate it. Dropped columns have zero weight in the tree and get rejected. */
+template <class ldouble_safe>
+void ColumnSampler<ldouble_safe>::build_alias_table()
+{
+    this->alias_prob.assign(this->tree_weights.begin() + this->offset,
+                            this->tree_weights.begin() + this->offset + this->n_cols);
+    this->alias_col.resize(this->n_cols);
+    for (size_t ix = this->drop_log.size(); ix > 0; ix--)
+        this->alias_prob[this->drop_log[ix-1].first] = this->drop_log[ix-1].second;
+    this->alias_wtot = 0;
+    for (size_t col = 0; col < this->n_cols; col++)
+        this->alias_wtot += this->alias_prob[col];
+
+    std::vector<size_t> small, large;
+    small.reserve(this->n_cols);
+    large.reserve(this->n_cols);
+    double multiplier = (double)this->n_cols / this->alias_wtot;
+    for (size_t col = 0; col < this->n_cols; col++)
+    {
+        this->alias_prob[col] *= multiplier;
+        this->alias_col[col] = col;
+        if (this->alias_prob[col] < 1.)
+            small.push_back(col);
+        else
+            large.push_back(col);
+    }
+
+    size_t col_small, col_large;
+    while (!small.empty() && !large.empty())
+    {
+        col_small = small.back(); small.pop_back();
+        col_large = large.back(); large.pop_back();
+        this->alias_col[col_small] = col_large;
+        this->alias_prob[col_large] = (this->alias_prob[col_large] + this->alias_prob[col_small]) - 1.;
+        if (this->alias_prob[col_large] < 1.)
+            small.push_back(col_large);
+        else
+            large.push_back(col_large);
+    }
+
+    /* leftovers are due to roundoff */
+    for (size_t col : small) this->alias_prob[col] = 1.;
+    for (size_t col : large) this->alias_prob[col] = 1.;
+}
+
 template <class ldouble_safe>
 void ColumnSampler<ldouble_safe>::prepare_full_pass()
 {
@@ -933,14 +1483,35 @@ bool ColumnSampler<ldouble_safe>::sample_col(size_t &col, RNG_engine &rnd_genera
 
     else
     {
+        double curr_subrange = this->tree_weights[0];
+        if (curr_subrange <= 0)
+            return false;
+
+        /* the table is built once the draws from the tree would have cost about as much, and
+           with most of the weight left, rejection from it needs less than two draws on average */
+        if (this->alias_prob.empty() && ++this->n_tree_draws * this->tree_levels >= this->n_cols)
+            this->build_alias_table();
+        if (!this->alias_prob.empty() && curr_subrange >= 0.5 * this->alias_wtot)
+        {
+            size_t chosen;
+            for (int attempt = 0; attempt < 16; attempt++)
+            {
+                chosen = std::uniform_int_distribution<size_t>(0, this->n_cols - 1)(rnd_generator);
+                if (std::uniform_real_distribution<double>(0., 1.)(rnd_generator) >= this->alias_prob[chosen])
+                    chosen = this->alias_col[chosen];
+                if (this->tree_weights[chosen + this->offset] > 0)
+                {
+                    col = chosen;
+                    return true;
+                }
+            }
+        }
+
         /* TODO: here could instead generate only 1 random number from zero to the full weight,
            and then subtract from it as it goes down every level. Would have less precision
            but should still work fine. */
         size_t curr_ix = 0;
         double rnd_subrange, w_left;
-        double curr_subrange = this->tree_weights[0];
-        if (curr_subrange <= 0)
-            return false;
 
         for (size_t lev = 0; lev < tree_levels; lev++)
         {
@@ -1217,7 +1788,8 @@ bool SingleNodeColumnSampler<ldouble_safe, real_t>::sample_col(size_t &col_chose
         }
 
         /* if there are no infinites, choose a column according to weight */
-        ldouble_safe chosen = std::uniform_real_distribution<ldouble_safe>((ldouble_safe)0, this->cumw)(rnd_generator);
+        typedef typename std::conditional<std::is_floating_point<ldouble_safe>::value, ldouble_safe, double>::type real_rng;
+        ldouble_safe chosen = std::uniform_real_distribution<real_rng>((real_rng)0, (real_rng)this->cumw)(rnd_generator);
         ldouble_safe cumw_ = 0;
         for (size_t col = 0; col < this->curr_pos; col++)
         {
@@ -2244,6 +2816,129 @@ size_t divide_subset_split(size_t ix_arr[], double x[], size_t st, size_t end, d
     return st;
 }
 
+/* Sparse columns are intersected with the rows of a node by leap-frogging between both sorted
+   index arrays. When both have a similar number of entries, the next match is typically only
+   a few positions ahead and a linear scan is the fastest way of reaching it, whereas when one
+   of them is much sparser than the other, an exponential ("galloping") search reaches it in
+   time logarithmic in the distance to it rather than in the remaining length of the array.
+   Which of the two to use is decided once per intersection from the ratio between the sizes. */
+#define GALLOPING_SIZE_RATIO 16
+bool prefer_galloping(size_t n_rows, size_t n_nonzero) noexcept
+{
+    return (n_rows > GALLOPING_SIZE_RATIO * n_nonzero) || (n_nonzero > GALLOPING_SIZE_RATIO * n_rows);
+}
+
+/* Same as 'std::lower_bound(first, last, val)', but searching outwards from 'first'.
+   The arrays and the value to search are row indices, which can be mixed between 'size_t'
+   and signed sparse indices, so the value is compared in the type of the array. */
+template <class T, class V>
+T* advance_sorted(T *first, T *last, V val, bool gallop) noexcept
+{
+    const T target = (T)val;
+    if (!gallop)
+    {
+        while (first < last && *first < target) first++;
+        return first;
+    }
+
+    size_t n = last - first;
+    if (!n || !(*first < target)) return first;
+    size_t lo = 0;
+    size_t hi = 1;
+    while (hi < n && first[hi] < target)
+    {
+        lo = hi;
+        hi = mult2(hi);
+    }
+    return std::lower_bound(first + lo + 1, first + std::min(hi, n), target);
+}
+
+/* Order-preserving version of the partitions below, used when fitting so as to keep the row indices
+   in their original order within each branch (needed for merging them against the CSC indices when
+   the data is sparse, and makes the results independent of whether vector instructions are used).
+   'side(row, pos)' is called sequentially for each position in the range, with 'pos' being the offset
+   with respect to 'st', and should return a negative number if the row goes to the left branch, zero
+   if the value is missing, and a positive number if the row goes to the right branch.
+   At the end, left rows will be at [st, st_NA), missing ones at [st_NA, end_NA), and right ones
+   at [end_NA, end]. 'buffer' must have space for 'end - st + 1' elements.
+
+   Since the split points are random, the side to which each row goes is unpredictable and a loop
+   that branches on it would mispredict about half of the time. Instead, each row is written to the
+   next free position of all three branches (left ones in-place, right ones at the start of 'buffer',
+   missing ones at the end of 'buffer'), and only the counter of the branch it belongs to advances.
+   If the first 'pos' rows were already distributed in this same layout (see 'simd_divide_subset'),
+   the partition can be resumed by passing how many of them went to the left and to the NA branch. */
+template <class side_getter>
+void stable_divide_subset(size_t *restrict ix_arr, size_t st, size_t end, size_t *restrict buffer,
+                          side_getter side, size_t &restrict st_NA, size_t &restrict end_NA,
+                          size_t pos, size_t n_left, size_t n_NA) noexcept
+{
+    size_t n = end - st + 1;
+    size_t n_right = pos - n_left - n_NA;
+    size_t *restrict ix_arr_st = ix_arr + st;
+    size_t row;
+    int curr_side;
+
+    for (; pos < n; pos++)
+    {
+        row = ix_arr_st[pos];
+        curr_side = side(row, pos);
+        ix_arr_st[n_left] = row;
+        buffer[n_right] = row;
+        buffer[n - 1 - n_NA] = row;
+        n_left  += curr_side < 0;
+        n_right += curr_side > 0;
+        n_NA    += curr_side == 0;
+    }
+
+    std::reverse_copy(buffer + (n - n_NA), buffer + n, ix_arr_st + n_left);
+    std::copy(buffer, buffer + n_right, ix_arr_st + n_left + n_NA);
+    st_NA  = st + n_left;
+    end_NA = st_NA + n_NA;
+}
+
+/* Distributes as many rows as possible from the start of 'ix_arr_st' in blocks of the vector width,
+   following the same layout as 'stable_divide_subset', according to whether their values are
+   l.e. than the split point. The values are taken as 'x[row]' if passing 'gather_x=true', or as
+   'x[pos]' otherwise. If passing 'separate_NA=false', missing values will be sent to the right.
+   Returns the number of rows that were distributed, which is zero when the CPU does not support
+   vector instructions or when the values are not of type 'double'. */
+template <class real_t>
+size_t simd_divide_subset(size_t *restrict, size_t, const real_t *restrict, bool,
+                          double, bool, size_t *restrict,
+                          size_t &restrict n_left, size_t &restrict n_NA) noexcept
+{
+    n_left = 0;
+    n_NA = 0;
+    return 0;
+}
+
+size_t simd_divide_subset(size_t *restrict ix_arr_st, size_t n, const double *restrict x, bool gather_x,
+                          double split_point, bool separate_NA, size_t *restrict buffer,
+                          size_t &restrict n_left, size_t &restrict n_NA) noexcept
+{
+    if (simd_kernels == NULL)
+    {
+        n_left = 0;
+        n_NA = 0;
+        return 0;
+    }
+    return simd_kernels->divide_subset(ix_arr_st, n, x, gather_x, split_point, separate_NA, buffer, n_left, n_NA);
+}
+
+/* For hyperplane intersections, preserving the order of the rows */
+size_t divide_subset_split(size_t ix_arr[], double x[], size_t st, size_t end, double split_point,
+                           size_t *restrict buffer) noexcept
+{
+    size_t split_ix, unused, n_left, n_NA;
+    size_t pos = simd_divide_subset(ix_arr + st, end - st + 1, x, false, split_point, false, buffer, n_left, n_NA);
+    stable_divide_subset(ix_arr, st, end, buffer,
+                         [&x, split_point](const size_t, const size_t pos)
+                         {return 1 - mult2((int)(x[pos] <= split_point));},
+                         split_ix, unused, pos, n_left, n_NA);
+    return split_ix;
+}
+
 /* For numerical columns */
 template <class real_t>
 void divide_subset_split(size_t *restrict ix_arr, real_t x[], size_t st, size_t end, double split_point,
@@ -2297,6 +2992,26 @@ void divide_subset_split(size_t *restrict ix_arr, real_t x[], size_t st, size_t
     }
 }
 
+/* For numerical columns, preserving the order of the rows */
+template <class real_t>
+void divide_subset_split(size_t *restrict ix_arr, real_t x[], size_t st, size_t end, double split_point,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept
+{
+    const int separate_NA = missing_action != Fail;
+    size_t n_left, n_NA;
+    size_t pos = simd_divide_subset(ix_arr + st, end - st + 1, x, true, split_point, separate_NA, buffer, n_left, n_NA);
+    stable_divide_subset(ix_arr, st, end, buffer,
+                         [&x, split_point, separate_NA](const size_t row, const size_t)
+                         {
+                            /* -1 if l.e., 0 if NaN and NAs are separated, +1 otherwise */
+                            const int is_le = x[row] <= split_point;
+                            return 1 - mult2(is_le) - ((int)std::isnan(x[row]) & separate_NA);
+                         },
+                         st_NA, end_NA, pos, n_left, n_NA);
+    split_ix = st_NA;
+}
+
 /* For sparse numeric columns */
 template <class real_t, class sparse_ix>
 void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
@@ -2325,6 +3040,7 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
     size_t temp;
     bool   move_zeros = 0 <= split_point;
@@ -2373,7 +3089,7 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                         }
                     }
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
@@ -2390,7 +3106,7 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                     }
 
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
         }
@@ -2411,15 +3127,15 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                         st++;
                     }
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
                 {
                     if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                        row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
         }
@@ -2469,7 +3185,7 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                             st++;
                         }
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
@@ -2487,7 +3203,7 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
 
                     else
                     {
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                     }
                 }
             }
@@ -2510,15 +3226,15 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                         st++;
                     }
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
                 {
                     if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                        row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
         }
@@ -2543,15 +3259,15 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
                         st++;
                     }
                     if (row == ix_arr + end || curr_pos == end_col) break;
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
                 }
 
                 else
                 {
                     if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                        row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                        row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                     else
-                        curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                        curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
                 }
             }
         }
@@ -2561,6 +3277,35 @@ void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t
 
 }
 
+/* For sparse numeric columns, preserving the order of the rows - requires sorted indices */
+template <class real_t, class sparse_ix>
+void divide_subset_split(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
+                         real_t Xc[], sparse_ix *restrict Xc_ind, sparse_ix *restrict Xc_indptr, double split_point,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept
+{
+    sparse_ix *curr_ind = Xc_ind + Xc_indptr[col_num];
+    sparse_ix *end_ind  = Xc_ind + Xc_indptr[col_num + 1];
+    const int side_NA = (missing_action == Fail)? 1 : 0;
+    const int side_zero = (0 <= split_point)? -1 : 1;
+    bool gallop = prefer_galloping(end - st + 1, end_ind - curr_ind);
+    double xval;
+
+    stable_divide_subset(ix_arr, st, end, buffer,
+                         [&](const size_t row, const size_t)
+                         {
+                            if (curr_ind < end_ind && *curr_ind < (sparse_ix)row)
+                                curr_ind = advance_sorted(curr_ind + 1, end_ind, (sparse_ix)row, gallop);
+                            if (curr_ind == end_ind || *curr_ind != (sparse_ix)row)
+                                return side_zero;
+                            xval = Xc[curr_ind - Xc_ind];
+                            if (unlikely(std::isnan(xval))) return side_NA;
+                            return (xval <= split_point)? -1 : 1;
+                         },
+                         st_NA, end_NA);
+    split_ix = st_NA;
+}
+
 /* For categorical columns split by subset */
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, signed char split_categ[],
                          MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept
@@ -2613,13 +3358,36 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
     }
 }
 
-/* For categorical columns split by subset, used at prediction time (with similarity) */
+/* For categorical columns split by subset, preserving the order of the rows */
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, signed char split_categ[],
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept
+{
+    const int separate_NA = missing_action != Fail;
+    stable_divide_subset(ix_arr, st, end, buffer,
+                         [&x, &split_categ, separate_NA](const size_t row, const size_t)
+                         {
+                            const int is_NA = x[row] < 0;
+                            const int is_left = !is_NA & (split_categ[std::max(x[row], 0)] == 1);
+                            return 1 - mult2(is_left) - (is_NA & separate_NA);
+                         },
+                         st_NA, end_NA);
+    split_ix = st_NA;
+}
+
+/* For categorical columns split by subset, used at prediction time (with similarity).
+   Takes the bitsets from 'IsoTree::cat_split', with 'split_absent' being NULL if there is none. */
+void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end,
+                         const uint64_t split_left[], const uint64_t split_absent[],
                          int ncat, MissingAction missing_action, NewCategAction new_cat_action,
                          bool move_new_to_left, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix) noexcept
 {
     size_t temp;
     int cval;
+    auto is_absent = [split_absent](int cval) -> bool
+    {
+        return split_absent != NULL && cat_split_bit(split_absent, cval);
+    };
 
     /* if NAs are not to be bothered with, just need to do a single pass */
     if (missing_action == Fail && new_cat_action != Weighted)
@@ -2630,7 +3398,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval >= ncat || split_categ[cval] == 1 || split_categ[cval] == (-1))
+                if (cval >= ncat || cat_split_bit(split_left, cval) || is_absent(cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2646,7 +3414,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             {
                 cval = x[ix_arr[row]];
                 cval = (cval >= ncat)? (cval % ncat) : cval;
-                if (split_categ[cval] == 1)
+                if (cat_split_bit(split_left, cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2661,7 +3429,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval < ncat && split_categ[cval] == 1)
+                if (cval < ncat && cat_split_bit(split_left, cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2686,7 +3454,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             {
                 cval = x[ix_arr[row]];
                 cval = (cval >= ncat)? (cval % ncat) : cval;
-                if (cval < 0 || split_categ[cval] == 1)
+                if (cval < 0 || cat_split_bit(split_left, cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2702,7 +3470,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             {
                 cval = x[ix_arr[row]];
                 cval = (cval >= ncat)? (cval % ncat) : cval;
-                if (cval >= 0 && split_categ[cval] == 1)
+                if (cval >= 0 && cat_split_bit(split_left, cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2741,7 +3509,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval >= 0 && (cval >= ncat || split_categ[cval] == 1 || split_categ[cval] == (-1)))
+                if (cval >= 0 && (cval >= ncat || cat_split_bit(split_left, cval) || is_absent(cval)))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2756,7 +3524,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval < ncat && (cval < 0 || split_categ[cval] == 1))
+                if (cval < ncat && (cval < 0 || cat_split_bit(split_left, cval)))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2771,7 +3539,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval >= 0 && cval < ncat && split_categ[cval] == 1)
+                if (cval >= 0 && cval < ncat && cat_split_bit(split_left, cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2788,7 +3556,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval < 0 || cval >= ncat || split_categ[cval] == (-1))
+                if (cval < 0 || cval >= ncat || is_absent(cval))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2803,7 +3571,7 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
             for (size_t row = st; row <= end; row++)
             {
                 cval = x[ix_arr[row]];
-                if (cval >= 0 && (cval >= ncat || split_categ[cval] == (-1)))
+                if (cval >= 0 && (cval >= ncat || is_absent(cval)))
                 {
                     temp        = ix_arr[st];
                     ix_arr[st]  = ix_arr[row];
@@ -2883,6 +3651,22 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
     }
 }
 
+/* For categorical columns split by a single category, preserving the order of the rows */
+void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end, int split_categ,
+                         MissingAction missing_action, size_t &restrict st_NA, size_t &restrict end_NA, size_t &restrict split_ix,
+                         size_t *restrict buffer) noexcept
+{
+    const int separate_NA = missing_action != Fail;
+    stable_divide_subset(ix_arr, st, end, buffer,
+                         [&x, split_categ, separate_NA](const size_t row, const size_t)
+                         {
+                            const int is_left = x[row] == split_categ;
+                            return 1 - mult2(is_left) - ((int)(x[row] < 0) & separate_NA);
+                         },
+                         st_NA, end_NA);
+    split_ix = st_NA;
+}
+
 /* For categoricals split on sub-set that turned out to have 2 categories only (prediction-time) */
 void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end,
                          MissingAction missing_action, NewCategAction new_cat_action,
@@ -2983,6 +3767,24 @@ void divide_subset_split(size_t *restrict ix_arr, int x[], size_t st, size_t end
     }
 }
 
+/* Minimum and maximum of the values at the first 'n' positions of 'ix_arr' (or of 'x' itself if
+   'ix_arr' is NULL), ignoring NaNs, computed with vector instructions. Returns 'false' without
+   calculating anything when those are not available or the values are not of type 'double'. */
+template <class real_t>
+bool simd_get_range(const size_t *restrict, const real_t *restrict, size_t,
+                    double &restrict, double &restrict) noexcept
+{
+    return false;
+}
+
+bool simd_get_range(const size_t *restrict ix_arr, const double *restrict x, size_t n,
+                    double &restrict xmin, double &restrict xmax) noexcept
+{
+    if (simd_kernels == NULL) return false;
+    simd_kernels->get_range(ix_arr, x, n, xmin, xmax);
+    return true;
+}
+
 /* for regular numeric columns */
 template <class real_t>
 void get_range(size_t ix_arr[], real_t *restrict x, size_t st, size_t end,
@@ -2992,7 +3794,13 @@ void get_range(size_t ix_arr[], real_t *restrict x, size_t st, size_t end,
     xmax = -HUGE_VAL;
     double xval;
 
-    if (missing_action == Fail)
+    /* NaNs are ignored in both cases, so the result is the same regardless of 'missing_action' */
+    if (simd_get_range(ix_arr + st, x, end - st + 1, xmin, xmax))
+    {
+        /* already calculated */
+    }
+
+    else if (missing_action == Fail)
     {
         for (size_t row = st; row <= end; row++)
         {
@@ -3023,7 +3831,12 @@ void get_range(real_t *restrict x, size_t n,
     xmin =  HUGE_VAL;
     xmax = -HUGE_VAL;
 
-    if (missing_action == Fail)
+    if (simd_get_range((const size_t*)NULL, x, n, xmin, xmax))
+    {
+        /* already calculated */
+    }
+
+    else if (missing_action == Fail)
     {
         for (size_t row = 0; row < n; row++)
         {
@@ -3060,6 +3873,7 @@ void get_range(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
     size_t nnz_col = end_col - st_col;
     end_col--;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
 
     if (!nnz_col || 
         Xc_ind[st_col]         >   (sparse_ix)ix_arr[end] || 
@@ -3094,15 +3908,15 @@ void get_range(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
                 xmin = (Xc[curr_pos] < xmin)? Xc[curr_pos] : xmin;
                 xmax = (Xc[curr_pos] > xmax)? Xc[curr_pos] : xmax;
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
     }
@@ -3119,15 +3933,15 @@ void get_range(size_t *restrict ix_arr, size_t st, size_t end, size_t col_num,
                 xmin = std::fmin(xmin, Xc[curr_pos]);
                 xmax = std::fmax(xmax, Xc[curr_pos]);
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else
             {
                 if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                    row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                    row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
                 else
-                    curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                    curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
             }
         }
 
@@ -3197,6 +4011,22 @@ void get_categs(size_t *restrict ix_arr, int x[], size_t st, size_t end, int nca
     unsplittable = npresent < 2;
 }
 
+/* Number of leading positions of 'ix_arr' whose values were verified with vector instructions to be
+   equal to 'x0' (or to be NaN or infinite, if passing 'skip_NA=true'). Stops at the first block in
+   which a different value is found, leaving it for the caller to check. Returns zero when vector
+   instructions are not available or the values are not of type 'double'. */
+template <class real_t>
+size_t simd_count_equal(const size_t *restrict, const real_t *restrict, size_t, double, bool) noexcept
+{
+    return 0;
+}
+
+size_t simd_count_equal(const size_t *restrict ix_arr, const double *restrict x, size_t n, double x0, bool skip_NA) noexcept
+{
+    if (simd_kernels == NULL) return 0;
+    return simd_kernels->count_equal(ix_arr, x, n, x0, skip_NA);
+}
+
 template <class real_t>
 bool check_more_than_two_unique_values(size_t ix_arr[], size_t st, size_t end, real_t x[], MissingAction missing_action)
 {
@@ -3205,7 +4035,7 @@ bool check_more_than_two_unique_values(size_t ix_arr[], size_t st, size_t end, r
     if (missing_action == Fail)
     {
         real_t x0 = x[ix_arr[st]];
-        for (size_t ix = st+1; ix <= end; ix++)
+        for (size_t ix = st + 1 + simd_count_equal(ix_arr + st + 1, x, end - st, x0, false); ix <= end; ix++)
         {
             if (x[ix_arr[ix]] != x0) return true;
         }
@@ -3225,6 +4055,8 @@ bool check_more_than_two_unique_values(size_t ix_arr[], size_t st, size_t end, r
             }
         }
 
+        if (ix <= end)
+            ix += simd_count_equal(ix_arr + ix, x, end - ix + 1, x0, true);
         for (; ix <= end; ix++)
         {
             if (!is_na_or_inf(x[ix_arr[ix]]) && x[ix_arr[ix]] != x0)
@@ -3285,6 +4117,7 @@ bool check_more_than_two_unique_values(size_t *restrict ix_arr, size_t st, size_
     size_t st_col  = Xc_indptr[col];
     size_t end_col = Xc_indptr[col + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
 
     /* 'ix_arr' should be sorted beforehand */
@@ -3300,23 +4133,23 @@ bool check_more_than_two_unique_values(size_t *restrict ix_arr, size_t st, size_
             if (is_na_or_inf(Xc[curr_pos]) || (has_zeros && Xc[curr_pos] == 0))
             {
                 if (row == ix_arr + end || curr_pos == end_col) return false;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             x0 = Xc[curr_pos];
             if (has_zeros) return true;
             else if (x0 == 0) has_zeros = true;
             if (row == ix_arr + end || curr_pos == end_col) return false;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             break;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -3329,7 +4162,7 @@ bool check_more_than_two_unique_values(size_t *restrict ix_arr, size_t st, size_
             if (is_na_or_inf(Xc[curr_pos]) || (has_zeros && Xc[curr_pos] == 0))
             {
                 if (row == ix_arr + end || curr_pos == end_col) break;
-                curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
             }
 
             else if (Xc[curr_pos] != x0)
@@ -3338,15 +4171,15 @@ bool check_more_than_two_unique_values(size_t *restrict ix_arr, size_t st, size_
             }
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -3459,6 +4292,7 @@ size_t move_NAs_to_front(size_t *restrict ix_arr, size_t st, size_t end, size_t
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
     std::sort(ix_arr + st, ix_arr + end + 1);
     size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, Xc_ind[st_col]);
@@ -3478,15 +4312,15 @@ size_t move_NAs_to_front(size_t *restrict ix_arr, size_t st, size_t end, size_t
             }
 
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > *row)
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 
@@ -3525,6 +4359,23 @@ size_t center_NAs(size_t ix_arr[], size_t st_left, size_t st, size_t curr_pos)
     return curr_pos;
 }
 
+/* Sparse inputs need the row indices sorted at each node. As the partitions used for them preserve
+   the order, the range will typically be sorted already, or be made up of two sorted runs when the
+   rows with missing values get assigned to a branch, in which case they are merged in linear time. */
+void sort_ix_arr(size_t ix_arr[], size_t st, size_t end)
+{
+    size_t *ix_arr_st = ix_arr + st;
+    size_t *ix_arr_end = ix_arr + end + 1;
+    size_t *first_unsorted = std::is_sorted_until(ix_arr_st, ix_arr_end);
+    if (first_unsorted == ix_arr_end)
+        return;
+
+    if (std::is_sorted(first_unsorted, ix_arr_end))
+        std::inplace_merge(ix_arr_st, first_unsorted, ix_arr_end);
+    else
+        std::sort(ix_arr_st, ix_arr_end);
+}
+
 /* FIXME / TODO: this calculation would not take weight into account */
 /* Here:
    - 'ix_arr' should be partitioned putting the NAs and Infs at the beginning: [st_orig, st)
@@ -3598,6 +4449,7 @@ void todense(const size_t *restrict ix_arr, size_t st, size_t end,
     size_t st_col  = Xc_indptr[col_num];
     size_t end_col = Xc_indptr[col_num + 1] - 1;
     size_t curr_pos = st_col;
+    bool gallop = prefer_galloping(end - st + 1, end_col - st_col + 1);
     size_t ind_end_col = Xc_ind[end_col];
     const size_t *ptr_st = std::lower_bound(ix_arr + st, ix_arr + end + 1, Xc_ind[st_col]);
 
@@ -3609,15 +4461,15 @@ void todense(const size_t *restrict ix_arr, size_t st, size_t end,
         {
             buffer_arr[row - (ix_arr + st)] = Xc[curr_pos];
             if (row == ix_arr + end || curr_pos == end_col) break;
-            curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row)) - Xc_ind;
+            curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *(++row), gallop) - Xc_ind;
         }
 
         else
         {
             if (Xc_ind[curr_pos] > (sparse_ix)(*row))
-                row = std::lower_bound(row + 1, ix_arr + end + 1, Xc_ind[curr_pos]);
+                row = advance_sorted(row + 1, ix_arr + end + 1, Xc_ind[curr_pos], gallop);
             else
-                curr_pos = std::lower_bound(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row) - Xc_ind;
+                curr_pos = advance_sorted(Xc_ind + curr_pos + 1, Xc_ind + end_col + 1, *row, gallop) - Xc_ind;
         }
     }
 }
@@ -3769,7 +4621,9 @@ void SignalSwitcher::restore_handle()
 
 bool has_long_double()
 {
-    #ifndef NO_LONG_DOUBLE
+    #if defined(USE_DOUBLE_DOUBLE) && !defined(NO_LONG_DOUBLE)
+    return true;
+    #elif !defined(NO_LONG_DOUBLE)
     return sizeof(long double) > sizeof(double);
     #else
     return false;
@@ -3787,3 +4641,32 @@ int return_EXIT_FAILURE()
 {
     return EXIT_FAILURE;
 }
+
+/* Picks the kernels for the widest instruction set that both the CPU and the operating system
+   support, among those that were compiled into the library. This is called once when the
+   library is loaded - if it returns NULL, the callers fall back to the scalar loops. */
+const SimdKernels* choose_simd_kernels()
+{
+    #if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (simd_kernels_avx512 != NULL && __builtin_cpu_supports("avx512f"))
+        return simd_kernels_avx512;
+    if (simd_kernels_avx2 != NULL && __builtin_cpu_supports("avx2"))
+        return simd_kernels_avx2;
+    #elif defined(_MSC_VER) && defined(_M_X64)
+    int cpu_info[4];
+    __cpuid(cpu_info, 0);
+    if (cpu_info[0] < 7) return NULL;
+    __cpuid(cpu_info, 1);
+    if (!(cpu_info[2] & (1 << 27))) return NULL; /* OSXSAVE */
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(cpu_info, 7, 0);
+    if (simd_kernels_avx512 != NULL && (cpu_info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6)
+        return simd_kernels_avx512;
+    if (simd_kernels_avx2 != NULL && (cpu_info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6)
+        return simd_kernels_avx2;
+    #endif
+    return NULL;
+}
+
+const SimdKernels *simd_kernels = choose_simd_kernels();